@@ -46,6 +46,8 @@ strip src/akcom-udpechod
 %files
 %attr(0755,root,root) /usr/bin/akcom-udpecho
 %attr(0755,root,root) /usr/bin/akcom-udpechod
+%attr(0644,root,root) /usr/include/akcom-udpecho.h
+%{_libdir}/libakcom-udpecho.*
 %attr(0644,root,root) /usr/share/man/man1/akcom-udpecho.1.gz
 %attr(0644,root,root) /usr/share/man/man8/akcom-udpechod.8.gz
 
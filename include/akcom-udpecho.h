@@ -0,0 +1,508 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file include/akcom-udpecho.h  UDP echo probing and reflecting library
+ */
+#ifndef __AKCOM_UDPECHO_H
+#define __AKCOM_UDPECHO_H 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+
+#define AKUDP_ECHOPLUS_SIZE      24             // TR-143 UDPEchoPlus header
+#define AKUDP_STAMP_SIZE         44             // STAMP unauthenticated packet size
+#define AKUDP_NTP_EPOCH_OFFSET   2208988800ULL  // seconds from 1900 to 1970
+#define AKUDP_STAMP_ERREST_REFRESH 60           // seconds between clock error estimates
+#define AKUDP_SEQ_WINDOW         1024           // sequence numbers tracked for duplicates
+
+// probe and reflector modes
+#define AKUDP_MODE_RFC862        0              // RFC 862 echo
+#define AKUDP_MODE_ECHOPLUS      1              // TR-143 UDPEchoPlus
+#define AKUDP_MODE_STAMP         2              // STAMP (RFC 8762) / TWAMP-Light
+
+// classification of responses
+#define AKUDP_SEQ_NEW            0              // first copy, in order
+#define AKUDP_SEQ_REORDERED      1              // first copy, after a higher sequence
+#define AKUDP_SEQ_DUPLICATE      2              // sequence already received
+#define AKUDP_SEQ_LATE           3              // after timeout or behind window
+#define AKUDP_SEQ_INVALID        4              // sequence never sent
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+
+// log-linear latency histogram of microsecond values
+typedef struct akudp_hist akudp_hist_t;
+
+// non-blocking prober of a single target
+typedef struct akudp_prober akudp_prober_t;
+
+// non-blocking reflector
+typedef struct akudp_reflector akudp_reflector_t;
+
+
+// window of received sequence numbers
+typedef struct akudp_seqwin
+{
+   uint32_t  seq_max;            // highest sequence received
+   uint64_t  bits[AKUDP_SEQ_WINDOW / 64];
+} akudp_seqwin_t;
+
+
+// TR-143 UDPEchoPlus header in host byte order
+typedef struct akudp_echoplus
+{
+   uint32_t  req_sn;             // TestGenSN
+   uint32_t  res_sn;             // TestRespSN
+   uint32_t  recv_time;          // TestRespRecvTimeStamp (usec, mod 2^32)
+   uint32_t  reply_time;         // TestRespReplyTimeStamp (usec, mod 2^32)
+   uint32_t  failures;           // TestRespReplyFailureCount
+   uint32_t  iteration;
+} akudp_echoplus_t;
+
+
+// STAMP unauthenticated test packet in host byte order, the session-sender
+// fields are the first four of the session-reflector packet
+typedef struct akudp_stamp
+{
+   uint32_t  seq;
+   uint32_t  ts_sec;             // NTP timestamp
+   uint32_t  ts_frac;
+   uint16_t  errest;
+   uint32_t  rx_sec;             // reflector receive timestamp
+   uint32_t  rx_frac;
+   uint32_t  ss_seq;             // session-sender fields
+   uint32_t  ss_sec;
+   uint32_t  ss_frac;
+   uint16_t  ss_errest;
+   uint8_t   ss_ttl;
+} akudp_stamp_t;
+
+
+// response received by prober
+typedef struct akudp_result
+{
+   uint32_t  seq;
+   int       status;             // AKUDP_SEQ_*
+   uint64_t  rtt;                // microseconds
+   uint64_t  delay;              // reflector turnaround reported by reflector (usec)
+   uint32_t  failures;           // echo plus reply failure count
+} akudp_result_t;
+
+
+// cumulative statistics of prober
+typedef struct akudp_stats
+{
+   uint64_t  sent;
+   uint64_t  rcvd;               // excludes duplicate and late responses
+   uint64_t  dups;
+   uint64_t  reordered;
+   uint64_t  late;
+   uint64_t  invalid;            // responses too short or never sent
+   uint64_t  rtt_min;            // microseconds
+   uint64_t  rtt_max;
+   uint64_t  rtt_sum;
+   double    rtt_stddev;
+   double    jitter;             // RFC 3550 interarrival jitter (usec)
+} akudp_stats_t;
+
+
+// counters of reflector
+typedef struct akudp_reflector_stats
+{
+   uint64_t  rcvd;
+   uint64_t  sent;
+   uint64_t  failures;           // replies which could not be sent
+   uint64_t  invalid;            // requests too short for the mode
+} akudp_reflector_stats_t;
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// histograms
+
+// allocate empty latency histogram, returns NULL on failure
+extern akudp_hist_t *
+akudp_hist_alloc(
+         void );
+
+
+// copy latency histogram
+extern void
+akudp_hist_copy(
+         akudp_hist_t *                dst,
+         const akudp_hist_t *          src );
+
+
+// number of values in latency histogram
+extern uint64_t
+akudp_hist_count(
+         const akudp_hist_t *          hist );
+
+
+// number of values in latency histogram at or below value
+extern uint64_t
+akudp_hist_count_le(
+         const akudp_hist_t *          hist,
+         uint64_t                      value );
+
+
+// store difference of cumulative histograms, dst may be older
+extern void
+akudp_hist_delta(
+         akudp_hist_t *                dst,
+         const akudp_hist_t *          newer,
+         const akudp_hist_t *          older );
+
+
+// release latency histogram
+extern void
+akudp_hist_free(
+         akudp_hist_t *                hist );
+
+
+// merge latency histograms
+extern void
+akudp_hist_merge(
+         akudp_hist_t *                dst,
+         const akudp_hist_t *          src );
+
+
+// determine value at quantile of latency histogram
+extern uint64_t
+akudp_hist_quantile(
+         const akudp_hist_t *          hist,
+         double                        quantile );
+
+
+// record value in latency histogram
+extern void
+akudp_hist_record(
+         akudp_hist_t *                hist,
+         uint64_t                      value );
+
+
+// clear latency histogram
+extern void
+akudp_hist_reset(
+         akudp_hist_t *                hist );
+
+
+// packets
+
+// decode UDPEchoPlus header, returns -1 if buffer is too short
+extern int
+akudp_echoplus_decode(
+         akudp_echoplus_t *            msg,
+         const void *                  buff,
+         size_t                        len );
+
+
+// encode UDPEchoPlus header, returns -1 if buffer is too short
+extern int
+akudp_echoplus_encode(
+         void *                        buff,
+         size_t                        len,
+         const akudp_echoplus_t *      msg );
+
+
+// fill in reflector fields of UDPEchoPlus request, returns -1 if buffer is
+// too short
+extern int
+akudp_echoplus_reflect(
+         void *                        buff,
+         size_t                        len,
+         uint32_t                      res_sn,
+         const struct timespec *       recvp,
+         const struct timespec *       replyp,
+         uint32_t                      failures );
+
+
+// convert NTP timestamp to nanoseconds since the UNIX epoch
+extern int64_t
+akudp_ntp2nsec(
+         uint32_t                      sec,
+         uint32_t                      frac );
+
+
+// decode STAMP session-reflector packet, returns -1 if buffer is too short
+extern int
+akudp_stamp_decode(
+         akudp_stamp_t *               msg,
+         const void *                  buff,
+         size_t                        len );
+
+
+// encode STAMP session-sender packet, returns -1 if buffer is too short
+extern int
+akudp_stamp_encode(
+         void *                        buff,
+         size_t                        len,
+         const akudp_stamp_t *         msg );
+
+
+// determine STAMP error estimate of local clock
+extern uint16_t
+akudp_stamp_errest(
+         void );
+
+
+// convert STAMP session-sender packet into session-reflector packet
+extern int
+akudp_stamp_reflect(
+         void *                        buff,
+         size_t                        len,
+         const struct timespec *       recvp,
+         const struct timespec *       replyp,
+         uint16_t                      errest,
+         int                           ttl );
+
+
+// convert wall clock time to NTP timestamp
+extern void
+akudp_timespec2ntp(
+         const struct timespec *       ts,
+         uint32_t *                    secp,
+         uint32_t *                    fracp );
+
+
+// calculates delta between timespecs and returns result as microseconds
+extern uint64_t
+akudp_timespec_delta(
+         const struct timespec *       ts1,
+         const struct timespec *       ts2,
+         struct timespec *             delta );
+
+
+// prober
+
+// release prober
+extern void
+akudp_prober_destroy(
+         akudp_prober_t *              prober );
+
+
+// socket of prober to poll for responses
+extern int
+akudp_prober_fd(
+         const akudp_prober_t *        prober );
+
+
+// latency histogram of prober
+extern const akudp_hist_t *
+akudp_prober_hist(
+         const akudp_prober_t *        prober );
+
+
+// resolve target and open prober, returns 0 or error code
+extern int
+akudp_prober_initialize(
+         akudp_prober_t **             proberp,
+         const char *                  host,
+         const char *                  port,
+         int                           family,
+         int                           mode,
+         size_t                        size );
+
+
+// process one pending response, returns 1 if stored, 0 if none is pending
+// and -1 on error (errno is set)
+extern int
+akudp_prober_recv(
+         akudp_prober_t *              prober,
+         akudp_result_t *              result );
+
+
+// send next request, returns -1 on error
+extern int
+akudp_prober_send(
+         akudp_prober_t *              prober );
+
+
+// set timeout after which responses are late in milliseconds
+extern void
+akudp_prober_set_timeout(
+         akudp_prober_t *              prober,
+         uint32_t                      msec );
+
+
+// copy cumulative statistics of prober
+extern void
+akudp_prober_stats(
+         const akudp_prober_t *        prober,
+         akudp_stats_t *               stats );
+
+
+// reflector
+
+// release reflector
+extern void
+akudp_reflector_destroy(
+         akudp_reflector_t *           reflector );
+
+
+// socket of reflector to poll for requests
+extern int
+akudp_reflector_fd(
+         const akudp_reflector_t *     reflector );
+
+
+// bind reflector to address and port, returns 0 or error code
+extern int
+akudp_reflector_initialize(
+         akudp_reflector_t **          reflectorp,
+         const char *                  address,
+         const char *                  port,
+         int                           family,
+         int                           mode );
+
+
+// answer pending requests from the address each was sent to, returns number
+// answered or -1 on error
+extern int
+akudp_reflector_process(
+         akudp_reflector_t *           reflector );
+
+
+// copy counters of reflector
+extern void
+akudp_reflector_stats(
+         const akudp_reflector_t *     reflector,
+         akudp_reflector_stats_t *     stats );
+
+
+// sockets
+
+// traffic class of received datagram, returns -1 if not present
+extern int
+akudp_cmsg_tos(
+         struct msghdr *               msg );
+
+
+// TTL or hop limit of received datagram, returns 0 if not present
+extern int
+akudp_cmsg_ttl(
+         struct msghdr *               msg );
+
+
+// enable TTL or hop limit of received datagrams, returns -1 on error
+extern int
+akudp_socket_recvttl(
+         int                           fd,
+         int                           family );
+
+
+// mark datagrams with traffic class unless tos is -1 and enable traffic class
+// of received datagrams, returns -1 on error
+extern int
+akudp_socket_tclass(
+         int                           fd,
+         int                           family,
+         int                           tos );
+
+
+// statistics
+
+// RFC 3550 interarrival jitter updated with delay variation of consecutive
+// responses
+extern double
+akudp_jitter(
+         double                        jitter,
+         int64_t                       ipdv );
+
+
+// track sequence number in window and classify response as AKUDP_SEQ_*,
+// seq_last is the most recent sequence sent and timeout is in units of rtt
+extern int
+akudp_seq_classify(
+         akudp_seqwin_t *              win,
+         uint32_t                      seq,
+         uint32_t                      seq_last,
+         uint64_t                      rtt,
+         uint64_t                      timeout );
+
+
+// update running mean and sum of squared deviations (Welford) with value,
+// count includes value
+extern void
+akudp_welford(
+         double *                      meanp,
+         double *                      m2p,
+         uint64_t                      count,
+         double                        value );
+
+
+// miscellaneous
+
+// describe error code returned by library
+extern const char *
+akudp_strerror(
+         int                           err );
+
+
+// version of library
+extern const char *
+akudp_version(
+         void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of header */
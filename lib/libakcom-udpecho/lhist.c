@@ -0,0 +1,223 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libakcom-udpecho/lhist.c  log-linear latency histograms
+ */
+#define _LIB_LIBAKCOM_UDPECHO_LHIST_C 1
+#include "libakcom-udpecho.h"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+// representative value of latency histogram bucket
+static uint64_t
+akudp_hist_value(
+         size_t                        idx );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+// allocate empty latency histogram, returns NULL on failure
+akudp_hist_t *
+akudp_hist_alloc(
+         void )
+{
+   return(calloc(1, sizeof(akudp_hist_t)));
+}
+
+
+// copy latency histogram
+void
+akudp_hist_copy(
+         akudp_hist_t *                dst,
+         const akudp_hist_t *          src )
+{
+   memcpy(dst, src, sizeof(akudp_hist_t));
+   return;
+}
+
+
+// number of values in latency histogram
+uint64_t
+akudp_hist_count(
+         const akudp_hist_t *          hist )
+{
+   return(hist->count);
+}
+
+
+// number of values in latency histogram at or below value
+uint64_t
+akudp_hist_count_le(
+         const akudp_hist_t *          hist,
+         uint64_t                      value )
+{
+   size_t                     idx;
+   uint64_t                   count;
+
+   // buckets are assigned by their midpoint
+   for(idx = 0, count = 0; ( (idx < AKUDP_HIST_BUCKETS) && (akudp_hist_value(idx) <= value) ); idx++)
+      count += hist->buckets[idx];
+
+   return(count);
+}
+
+
+// store difference of cumulative histograms, dst may be older
+void
+akudp_hist_delta(
+         akudp_hist_t *                dst,
+         const akudp_hist_t *          newer,
+         const akudp_hist_t *          older )
+{
+   size_t                     idx;
+
+   for(idx = 0; (idx < AKUDP_HIST_BUCKETS); idx++)
+      dst->buckets[idx] = newer->buckets[idx] - older->buckets[idx];
+   dst->count = newer->count - older->count;
+
+   return;
+}
+
+
+// release latency histogram
+void
+akudp_hist_free(
+         akudp_hist_t *                hist )
+{
+   free(hist);
+   return;
+}
+
+
+// merge latency histograms
+void
+akudp_hist_merge(
+         akudp_hist_t *                dst,
+         const akudp_hist_t *          src )
+{
+   size_t                     idx;
+
+   for(idx = 0; (idx < AKUDP_HIST_BUCKETS); idx++)
+      dst->buckets[idx] += src->buckets[idx];
+   dst->count += src->count;
+
+   return;
+}
+
+
+// determine value at quantile of latency histogram
+uint64_t
+akudp_hist_quantile(
+         const akudp_hist_t *          hist,
+         double                        quantile )
+{
+   size_t                     idx;
+   uint64_t                   rank;
+   uint64_t                   seen;
+
+   if (!(hist->count))
+      return(0);
+
+   // find bucket containing the rank
+   rank = (uint64_t)((quantile * (double)hist->count) + 0.5);
+   rank = ((rank)) ? rank : 1;
+   for(idx = 0, seen = 0; (idx < (AKUDP_HIST_BUCKETS-1)); idx++)
+      if ((seen += hist->buckets[idx]) >= rank)
+         break;
+
+   return(akudp_hist_value(idx));
+}
+
+
+// record value in latency histogram
+void
+akudp_hist_record(
+         akudp_hist_t *                hist,
+         uint64_t                      value )
+{
+   size_t                     idx;
+   unsigned                   shift;
+
+   // values below 2^(P+1) are recorded exactly, larger values keep the P
+   // most significant bits following the leading bit
+   if (value < (2U << AKUDP_HIST_PRECISION))
+      idx = (size_t)value;
+   else if (value >= (1ULL << AKUDP_HIST_RANGE))
+      idx = AKUDP_HIST_BUCKETS - 1;
+   else
+   {
+      shift = (unsigned)(63 - __builtin_clzll(value)) - AKUDP_HIST_PRECISION;
+      idx   = ((size_t)(shift + 1) << AKUDP_HIST_PRECISION) + (size_t)((value >> shift) & ((1U << AKUDP_HIST_PRECISION) - 1));
+   };
+   hist->buckets[idx]++;
+   hist->count++;
+
+   return;
+}
+
+
+// clear latency histogram
+void
+akudp_hist_reset(
+         akudp_hist_t *                hist )
+{
+   memset(hist, 0, sizeof(akudp_hist_t));
+   return;
+}
+
+
+// representative value of latency histogram bucket
+uint64_t
+akudp_hist_value(
+         size_t                        idx )
+{
+   unsigned                   shift;
+
+   // report midpoint of bucket
+   if (idx < (2U << AKUDP_HIST_PRECISION))
+      return(idx);
+   shift = (unsigned)(idx >> AKUDP_HIST_PRECISION) - 1;
+   return(( ((idx & ((1U << AKUDP_HIST_PRECISION) - 1)) | (1U << AKUDP_HIST_PRECISION)) << shift ) + ((1ULL << shift) >> 1));
+}
+
+/* end of source file */
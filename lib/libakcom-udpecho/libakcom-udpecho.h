@@ -0,0 +1,178 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libakcom-udpecho/libakcom-udpecho.h  internal definitions
+ */
+#ifndef __LIBAKCOM_UDPECHO_H
+#define __LIBAKCOM_UDPECHO_H 1
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+#pragma mark - Headers
+
+// defined in the Single UNIX Specification
+#ifndef _XOPEN_SOURCE
+#   define _XOPEN_SOURCE 600
+#endif
+
+// required by glibc for IPV6_RECVHOPLIMIT
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE 1
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <time.h>
+
+#include <akcom-udpecho.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+#pragma mark - Definitions
+
+#ifndef PACKAGE_VERSION
+#define PACKAGE_VERSION "0.0"
+#endif
+
+#define AKUDP_HIST_PRECISION     7              // sub-bucket bits, under 1% error
+#define AKUDP_HIST_RANGE         36             // value bits, about 19 hours in usec
+#define AKUDP_HIST_BUCKETS       ((AKUDP_HIST_RANGE - AKUDP_HIST_PRECISION + 1) << AKUDP_HIST_PRECISION)
+#define AKUDP_TIMEOUT            5000           // default response timeout (msec)
+#define AKUDP_BUFF_SIZE          65536          // max datagram size
+#define AKUDP_CMSG_SIZE          128            // ancillary data of received datagram
+#define AKUDP_RFC862_SIZE        8              // sequence number and padding of RFC 862 probes
+#define AKUDP_BATCH              64             // requests answered per call of reflector
+
+// symbols shared between objects of the library but not exported
+#if defined(__GNUC__) && (__GNUC__ >= 4)
+#   define AKUDP_INTERNAL __attribute__((visibility("hidden")))
+#else
+#   define AKUDP_INTERNAL
+#endif
+
+
+//////////////////
+//              //
+//  Data Types  //
+//              //
+//////////////////
+#pragma mark - Data Types
+
+union akudp_sa
+{
+   struct sockaddr         sa;
+   struct sockaddr_in      sin;
+   struct sockaddr_in6     sin6;
+   struct sockaddr_storage ss;
+};
+
+
+struct akudp_hist
+{
+   uint64_t  count;
+   uint64_t  buckets[AKUDP_HIST_BUCKETS];
+};
+
+
+struct akudp_prober
+{
+   int               fd;
+   int               mode;
+   size_t            size;
+   size_t            offset;        // send time follows protocol header
+   uint32_t          seq;           // sequence of most recent request
+   uint64_t          timeout;       // microseconds
+   uint16_t          errest;        // STAMP error estimate of local clock
+   uint64_t          last_rtt;      // round-trip of previous accepted response
+   double            rtt_mean;      // running mean and squared deviations
+   double            rtt_m2;
+   akudp_stats_t     stats;
+   akudp_seqwin_t    seqwin;
+   uint8_t *         buff;
+   akudp_hist_t      hist;
+};
+
+
+struct akudp_reflector
+{
+   int                       fd;
+   int                       mode;
+   uint32_t                  req_sn;
+   uint32_t                  res_sn;
+   uint32_t                  failures;
+   uint16_t                  errest;        // STAMP error estimate, refreshed once per minute
+   time_t                    errest_time;
+   akudp_reflector_stats_t   stats;
+   uint8_t *                 buff;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+// resolve address and open non-blocking UDP socket, returns 0 or error code
+extern AKUDP_INTERNAL int
+akudp_socket(
+         const char *                  host,
+         const char *                  port,
+         int                           family,
+         int                           passive,
+         int *                         fdp );
+
+#endif /* end of header */
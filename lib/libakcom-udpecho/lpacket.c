@@ -0,0 +1,355 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libakcom-udpecho/lpacket.c  encoding and decoding of test packets
+ */
+#define _LIB_LIBAKCOM_UDPECHO_LPACKET_C 1
+#include "libakcom-udpecho.h"
+
+#if defined(__linux__)
+#include <sys/timex.h>
+#endif
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+// read 16 bit network order value from buffer
+static uint16_t
+akudp_get16(
+         const uint8_t *               buff,
+         size_t                        off );
+
+
+// read 32 bit network order value from buffer
+static uint32_t
+akudp_get32(
+         const uint8_t *               buff,
+         size_t                        off );
+
+
+// write 16 bit network order value to buffer
+static void
+akudp_put16(
+         uint8_t *                     buff,
+         size_t                        off,
+         uint16_t                      val );
+
+
+// write 32 bit network order value to buffer
+static void
+akudp_put32(
+         uint8_t *                     buff,
+         size_t                        off,
+         uint32_t                      val );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+// decode UDPEchoPlus header, returns -1 if buffer is too short
+int
+akudp_echoplus_decode(
+         akudp_echoplus_t *            msg,
+         const void *                  buff,
+         size_t                        len )
+{
+   if (len < AKUDP_ECHOPLUS_SIZE)
+      return(-1);
+   msg->req_sn     = akudp_get32(buff,  0);
+   msg->res_sn     = akudp_get32(buff,  4);
+   msg->recv_time  = akudp_get32(buff,  8);
+   msg->reply_time = akudp_get32(buff, 12);
+   msg->failures   = akudp_get32(buff, 16);
+   msg->iteration  = akudp_get32(buff, 20);
+   return(0);
+}
+
+
+// encode UDPEchoPlus header, returns -1 if buffer is too short
+int
+akudp_echoplus_encode(
+         void *                        buff,
+         size_t                        len,
+         const akudp_echoplus_t *      msg )
+{
+   if (len < AKUDP_ECHOPLUS_SIZE)
+      return(-1);
+   akudp_put32(buff,  0, msg->req_sn);
+   akudp_put32(buff,  4, msg->res_sn);
+   akudp_put32(buff,  8, msg->recv_time);
+   akudp_put32(buff, 12, msg->reply_time);
+   akudp_put32(buff, 16, msg->failures);
+   akudp_put32(buff, 20, msg->iteration);
+   return(0);
+}
+
+
+// fill in reflector fields of UDPEchoPlus request, returns -1 if buffer is
+// too short
+int
+akudp_echoplus_reflect(
+         void *                        buff,
+         size_t                        len,
+         uint32_t                      res_sn,
+         const struct timespec *       recvp,
+         const struct timespec *       replyp,
+         uint32_t                      failures )
+{
+   uint64_t                   us_recv;
+   uint64_t                   us_reply;
+
+   if (len < AKUDP_ECHOPLUS_SIZE)
+      return(-1);
+
+   // timestamps are microseconds modulo 2^32, sender fields are kept
+   us_recv  = ((uint64_t)recvp->tv_sec * 1000000ULL)  + ((uint64_t)recvp->tv_nsec / 1000ULL);
+   us_reply = ((uint64_t)replyp->tv_sec * 1000000ULL) + ((uint64_t)replyp->tv_nsec / 1000ULL);
+   akudp_put32(buff,  4, res_sn);
+   akudp_put32(buff,  8, (uint32_t)(us_recv & 0xFFFFFFFFULL));
+   akudp_put32(buff, 12, (uint32_t)(us_reply & 0xFFFFFFFFULL));
+   akudp_put32(buff, 16, failures);
+
+   return(0);
+}
+
+
+// read 16 bit network order value from buffer
+uint16_t
+akudp_get16(
+         const uint8_t *               buff,
+         size_t                        off )
+{
+   uint16_t                   val;
+   memcpy(&val, &buff[off], sizeof(val));
+   return(ntohs(val));
+}
+
+
+// read 32 bit network order value from buffer
+uint32_t
+akudp_get32(
+         const uint8_t *               buff,
+         size_t                        off )
+{
+   uint32_t                   val;
+   memcpy(&val, &buff[off], sizeof(val));
+   return(ntohl(val));
+}
+
+
+// convert NTP timestamp to nanoseconds since the UNIX epoch
+int64_t
+akudp_ntp2nsec(
+         uint32_t                      sec,
+         uint32_t                      frac )
+{
+   int64_t                    nsec;
+
+   // timestamps with the high bit clear belong to NTP era 1 (after 2036)
+   nsec  = (int64_t)sec - (int64_t)AKUDP_NTP_EPOCH_OFFSET;
+   nsec += ((sec & 0x80000000U)) ? 0 : 0x100000000LL;
+   nsec *= 1000000000LL;
+   nsec += (int64_t)(((uint64_t)frac * 1000000000ULL) >> 32);
+
+   return(nsec);
+}
+
+
+// write 16 bit network order value to buffer
+void
+akudp_put16(
+         uint8_t *                     buff,
+         size_t                        off,
+         uint16_t                      val )
+{
+   val = htons(val);
+   memcpy(&buff[off], &val, sizeof(val));
+   return;
+}
+
+
+// write 32 bit network order value to buffer
+void
+akudp_put32(
+         uint8_t *                     buff,
+         size_t                        off,
+         uint32_t                      val )
+{
+   val = htonl(val);
+   memcpy(&buff[off], &val, sizeof(val));
+   return;
+}
+
+
+// decode STAMP session-reflector packet, returns -1 if buffer is too short
+int
+akudp_stamp_decode(
+         akudp_stamp_t *               msg,
+         const void *                  buff,
+         size_t                        len )
+{
+   const uint8_t *            bytes;
+
+   if (len < AKUDP_STAMP_SIZE)
+      return(-1);
+   bytes          = buff;
+   msg->seq       = akudp_get32(bytes,  0);
+   msg->ts_sec    = akudp_get32(bytes,  4);
+   msg->ts_frac   = akudp_get32(bytes,  8);
+   msg->errest    = akudp_get16(bytes, 12);
+   msg->rx_sec    = akudp_get32(bytes, 16);
+   msg->rx_frac   = akudp_get32(bytes, 20);
+   msg->ss_seq    = akudp_get32(bytes, 24);
+   msg->ss_sec    = akudp_get32(bytes, 28);
+   msg->ss_frac   = akudp_get32(bytes, 32);
+   msg->ss_errest = akudp_get16(bytes, 36);
+   msg->ss_ttl    = bytes[40];
+
+   return(0);
+}
+
+
+// encode STAMP session-sender packet, returns -1 if buffer is too short
+int
+akudp_stamp_encode(
+         void *                        buff,
+         size_t                        len,
+         const akudp_stamp_t *         msg )
+{
+   if (len < AKUDP_STAMP_SIZE)
+      return(-1);
+   memset(buff, 0, AKUDP_STAMP_SIZE);
+   akudp_put32(buff,  0, msg->seq);
+   akudp_put32(buff,  4, msg->ts_sec);
+   akudp_put32(buff,  8, msg->ts_frac);
+   akudp_put16(buff, 12, msg->errest);
+   return(0);
+}
+
+
+// determine STAMP error estimate of local clock
+uint16_t
+akudp_stamp_errest(
+         void )
+{
+   uint64_t                   err_ns;
+   uint64_t                   units;
+   uint16_t                   scale;
+   uint16_t                   sync;
+   struct timespec            res;
+
+   // start with clock resolution
+   clock_getres(CLOCK_REALTIME, &res);
+   err_ns = (uint64_t)res.tv_nsec + ((uint64_t)res.tv_sec * 1000000000ULL);
+   sync   = 0;
+#if defined(__linux__)
+   {
+      struct timex tx;
+      memset(&tx, 0, sizeof(tx));
+      if ( (ntp_adjtime(&tx) != -1) && (!(tx.status & STA_UNSYNC)) )
+      {
+         sync   = 0x8000;
+         err_ns = ((uint64_t)tx.esterror * 1000ULL > err_ns) ? (uint64_t)tx.esterror * 1000ULL : err_ns;
+      };
+   };
+#endif
+
+   // encode as Multiplier * 2^(Scale-32) seconds (RFC 4656 section 4.1.2)
+   units = ((err_ns << 32) + 999999999ULL) / 1000000000ULL;
+   for(scale = 0; (units > 0xff); scale++)
+      units = (units + 1) >> 1;
+   units  = ((units)) ? units : 1;
+
+   return((uint16_t)(sync | ((scale & 0x3f) << 8) | units));
+}
+
+
+// convert STAMP session-sender packet into session-reflector packet
+int
+akudp_stamp_reflect(
+         void *                        buff,
+         size_t                        len,
+         const struct timespec *       recvp,
+         const struct timespec *       replyp,
+         uint16_t                      errest,
+         int                           ttl )
+{
+   uint8_t *                  bytes;
+   uint8_t                    sender[16];
+   uint32_t                   sec;
+   uint32_t                   frac;
+
+   if (len < AKUDP_STAMP_SIZE)
+      return(-1);
+
+   // stateless reflector, sequence number is copied from sender
+   bytes = buff;
+   memcpy(sender, bytes, sizeof(sender));
+   memset(bytes, 0, AKUDP_STAMP_SIZE);
+   memcpy(&bytes[0], &sender[0], 4);
+   akudp_timespec2ntp(replyp, &sec, &frac);
+   akudp_put32(bytes,  4, sec);
+   akudp_put32(bytes,  8, frac);
+   akudp_put16(bytes, 12, errest);
+   akudp_timespec2ntp(recvp, &sec, &frac);
+   akudp_put32(bytes, 16, sec);
+   akudp_put32(bytes, 20, frac);
+   memcpy(&bytes[24], &sender[0], 12);
+   memcpy(&bytes[36], &sender[12], 2);
+   bytes[40] = (uint8_t)(ttl & 0xff);
+
+   return(0);
+}
+
+
+// convert wall clock time to NTP timestamp
+void
+akudp_timespec2ntp(
+         const struct timespec *       ts,
+         uint32_t *                    secp,
+         uint32_t *                    fracp )
+{
+   *secp  = (uint32_t)((uint64_t)ts->tv_sec + AKUDP_NTP_EPOCH_OFFSET);
+   *fracp = (uint32_t)(((uint64_t)ts->tv_nsec << 32) / 1000000000ULL);
+   return;
+}
+
+/* end of source file */
@@ -0,0 +1,332 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libakcom-udpecho/lprober.c  non-blocking prober of a single target
+ */
+#define _LIB_LIBAKCOM_UDPECHO_LPROBER_C 1
+#include "libakcom-udpecho.h"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+// update cumulative statistics with accepted response
+static void
+akudp_prober_record(
+         akudp_prober_t *              prober,
+         uint64_t                      rtt );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+// release prober
+void
+akudp_prober_destroy(
+         akudp_prober_t *              prober )
+{
+   if (!(prober))
+      return;
+   if (prober->fd != -1)
+      close(prober->fd);
+   free(prober->buff);
+   free(prober);
+   return;
+}
+
+
+// socket of prober to poll for responses
+int
+akudp_prober_fd(
+         const akudp_prober_t *        prober )
+{
+   return(prober->fd);
+}
+
+
+// latency histogram of prober
+const akudp_hist_t *
+akudp_prober_hist(
+         const akudp_prober_t *        prober )
+{
+   return(&prober->hist);
+}
+
+
+// resolve target and open prober, returns 0 or error code
+int
+akudp_prober_initialize(
+         akudp_prober_t **             proberp,
+         const char *                  host,
+         const char *                  port,
+         int                           family,
+         int                           mode,
+         size_t                        size )
+{
+   int                        rc;
+   akudp_prober_t *           prober;
+
+   *proberp = NULL;
+
+   if (!(prober = calloc(1, sizeof(akudp_prober_t))))
+      return(ENOMEM);
+   prober->fd      = -1;
+   prober->mode    = mode;
+   prober->timeout = (uint64_t)AKUDP_TIMEOUT * 1000ULL;
+
+   // protocol header is followed by monotonic send time
+   switch(mode)
+   {
+      case AKUDP_MODE_RFC862:   prober->offset = AKUDP_RFC862_SIZE;   break;
+      case AKUDP_MODE_ECHOPLUS: prober->offset = AKUDP_ECHOPLUS_SIZE; break;
+      case AKUDP_MODE_STAMP:    prober->offset = AKUDP_STAMP_SIZE;    break;
+      default:
+      akudp_prober_destroy(prober);
+      return(EINVAL);
+   };
+   prober->size = (size < (prober->offset + sizeof(uint64_t))) ? (prober->offset + sizeof(uint64_t)) : size;
+   if (prober->size > AKUDP_BUFF_SIZE)
+   {
+      akudp_prober_destroy(prober);
+      return(EMSGSIZE);
+   };
+   if (mode == AKUDP_MODE_STAMP)
+      prober->errest = akudp_stamp_errest();
+
+   if (!(prober->buff = malloc(AKUDP_BUFF_SIZE)))
+   {
+      akudp_prober_destroy(prober);
+      return(ENOMEM);
+   };
+
+   if ((rc = akudp_socket(host, port, family, 0, &prober->fd)) != 0)
+   {
+      akudp_prober_destroy(prober);
+      return(rc);
+   };
+
+   *proberp = prober;
+
+   return(0);
+}
+
+
+// update cumulative statistics with accepted response
+void
+akudp_prober_record(
+         akudp_prober_t *              prober,
+         uint64_t                      rtt )
+{
+   akudp_stats_t *            st;
+
+   st = &prober->stats;
+   st->rcvd++;
+   st->rtt_sum += rtt;
+   st->rtt_min  = ( (st->rcvd == 1) || (rtt < st->rtt_min) ) ? rtt : st->rtt_min;
+   st->rtt_max  = ( (st->rcvd == 1) || (rtt > st->rtt_max) ) ? rtt : st->rtt_max;
+   akudp_hist_record(&prober->hist, rtt);
+
+   akudp_welford(&prober->rtt_mean, &prober->rtt_m2, st->rcvd, (double)rtt);
+
+   // RFC 3550 interarrival jitter of round-trip times in arrival order
+   if (st->rcvd > 1)
+      st->jitter = akudp_jitter(st->jitter, (int64_t)rtt - (int64_t)prober->last_rtt);
+   prober->last_rtt = rtt;
+
+   return;
+}
+
+
+// process one pending response, returns 1 if stored, 0 if none is pending
+// and -1 on error (errno is set)
+int
+akudp_prober_recv(
+         akudp_prober_t *              prober,
+         akudp_result_t *              result )
+{
+   ssize_t                    ssize;
+   int                        status;
+   uint32_t                   seq;
+   uint64_t                   sent;
+   uint64_t                   now;
+   uint64_t                   rtt;
+   int64_t                    delay;
+   struct timespec            ts;
+   akudp_echoplus_t           echoplus;
+   akudp_stamp_t              stamp;
+
+   while(1)
+   {
+      if ((ssize = recv(prober->fd, prober->buff, AKUDP_BUFF_SIZE, 0)) == -1)
+         return( ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? 0 : -1 );
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      now = ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+
+      if ((size_t)ssize < (prober->offset + sizeof(uint64_t)))
+      {
+         prober->stats.invalid++;
+         continue;
+      };
+
+      // decode protocol header
+      delay = 0;
+      memset(&echoplus, 0, sizeof(echoplus));
+      switch(prober->mode)
+      {
+         case AKUDP_MODE_ECHOPLUS:
+         akudp_echoplus_decode(&echoplus, prober->buff, (size_t)ssize);
+         seq   = echoplus.req_sn;
+         delay = (int64_t)(uint32_t)(echoplus.reply_time - echoplus.recv_time);
+         break;
+
+         case AKUDP_MODE_STAMP:
+         akudp_stamp_decode(&stamp, prober->buff, (size_t)ssize);
+         seq   = stamp.ss_seq;
+         delay = (akudp_ntp2nsec(stamp.ts_sec, stamp.ts_frac) - akudp_ntp2nsec(stamp.rx_sec, stamp.rx_frac)) / 1000;
+         break;
+
+         default:
+         memcpy(&seq, prober->buff, sizeof(seq));
+         seq = ntohl(seq);
+         break;
+      };
+
+      // round-trip time from send time carried in payload
+      memcpy(&sent, &prober->buff[prober->offset], sizeof(sent));
+      rtt = (now > sent) ? ((now - sent) / 1000ULL) : 0;
+
+      switch(status = akudp_seq_classify(&prober->seqwin, seq, prober->seq, rtt, prober->timeout))
+      {
+         case AKUDP_SEQ_INVALID:   prober->stats.invalid++;   continue;
+         case AKUDP_SEQ_DUPLICATE: prober->stats.dups++;      break;
+         case AKUDP_SEQ_LATE:      prober->stats.late++;      break;
+         case AKUDP_SEQ_REORDERED: prober->stats.reordered++; break;
+         default:                                             break;
+      };
+      if (status <= AKUDP_SEQ_REORDERED)
+         akudp_prober_record(prober, rtt);
+
+      result->seq      = seq;
+      result->status   = status;
+      result->rtt      = rtt;
+      result->delay    = (delay > 0) ? (uint64_t)delay : 0;
+      result->failures = echoplus.failures;
+
+      return(1);
+   };
+}
+
+
+// send next request, returns -1 on error
+int
+akudp_prober_send(
+         akudp_prober_t *              prober )
+{
+   uint32_t                   seq;
+   uint64_t                   sent;
+   struct timespec            ts;
+   akudp_echoplus_t           echoplus;
+   akudp_stamp_t              stamp;
+
+   // sequence number zero is never sent
+   seq = prober->seq + 1;
+   seq = ((seq)) ? seq : 1;
+   memset(prober->buff, 0, prober->size);
+
+   switch(prober->mode)
+   {
+      case AKUDP_MODE_ECHOPLUS:
+      memset(&echoplus, 0, sizeof(echoplus));
+      echoplus.req_sn = seq;
+      akudp_echoplus_encode(prober->buff, prober->size, &echoplus);
+      break;
+
+      case AKUDP_MODE_STAMP:
+      memset(&stamp, 0, sizeof(stamp));
+      clock_gettime(CLOCK_REALTIME, &ts);
+      stamp.seq    = seq;
+      stamp.errest = prober->errest;
+      akudp_timespec2ntp(&ts, &stamp.ts_sec, &stamp.ts_frac);
+      akudp_stamp_encode(prober->buff, prober->size, &stamp);
+      break;
+
+      default:
+      seq = htonl(seq);
+      memcpy(prober->buff, &seq, sizeof(seq));
+      seq = ntohl(seq);
+      break;
+   };
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   sent = ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+   memcpy(&prober->buff[prober->offset], &sent, sizeof(sent));
+
+   if (send(prober->fd, prober->buff, prober->size, 0) == -1)
+      return(-1);
+   prober->seq = seq;
+   prober->stats.sent++;
+
+   return(0);
+}
+
+
+// set timeout after which responses are late in milliseconds
+void
+akudp_prober_set_timeout(
+         akudp_prober_t *              prober,
+         uint32_t                      msec )
+{
+   prober->timeout = (uint64_t)msec * 1000ULL;
+   return;
+}
+
+
+// copy cumulative statistics of prober
+void
+akudp_prober_stats(
+         const akudp_prober_t *        prober,
+         akudp_stats_t *               stats )
+{
+   *stats            = prober->stats;
+   stats->rtt_stddev = (stats->rcvd > 1) ? sqrt(prober->rtt_m2 / (double)(stats->rcvd - 1)) : 0.0;
+   return;
+}
+
+/* end of source file */
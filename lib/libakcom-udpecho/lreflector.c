@@ -0,0 +1,396 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libakcom-udpecho/lreflector.c  non-blocking reflector
+ */
+#define _LIB_LIBAKCOM_UDPECHO_LREFLECTOR_C 1
+#include "libakcom-udpecho.h"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+#pragma mark - Prototypes
+
+// receive request, destination address, and TTL or hop limit of datagram
+static ssize_t
+akudp_reflector_recvmsg(
+         akudp_reflector_t *           reflector,
+         union akudp_sa *              sap,
+         socklen_t *                   sinlenp,
+         union akudp_sa *              localp,
+         unsigned *                    ifindexp,
+         int *                         ttlp );
+
+
+// send reply from the address the request was sent to
+static ssize_t
+akudp_reflector_sendmsg(
+         akudp_reflector_t *           reflector,
+         size_t                        len,
+         union akudp_sa *              sap,
+         socklen_t                     sinlen,
+         const union akudp_sa *        localp,
+         unsigned                      ifindex );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+// release reflector
+void
+akudp_reflector_destroy(
+         akudp_reflector_t *           reflector )
+{
+   if (!(reflector))
+      return;
+   if (reflector->fd != -1)
+      close(reflector->fd);
+   free(reflector->buff);
+   free(reflector);
+   return;
+}
+
+
+// socket of reflector to poll for requests
+int
+akudp_reflector_fd(
+         const akudp_reflector_t *     reflector )
+{
+   return(reflector->fd);
+}
+
+
+// bind reflector to address and port, returns 0 or error code
+int
+akudp_reflector_initialize(
+         akudp_reflector_t **          reflectorp,
+         const char *                  address,
+         const char *                  port,
+         int                           family,
+         int                           mode )
+{
+   int                        rc;
+   int                        opt;
+   socklen_t                  sinlen;
+   union akudp_sa             sa;
+   akudp_reflector_t *        reflector;
+
+   *reflectorp = NULL;
+
+   if ( (mode != AKUDP_MODE_RFC862) && (mode != AKUDP_MODE_ECHOPLUS) && (mode != AKUDP_MODE_STAMP) )
+      return(EINVAL);
+
+   if (!(reflector = calloc(1, sizeof(akudp_reflector_t))))
+      return(ENOMEM);
+   reflector->fd   = -1;
+   reflector->mode = mode;
+
+   if (!(reflector->buff = malloc(AKUDP_BUFF_SIZE)))
+   {
+      akudp_reflector_destroy(reflector);
+      return(ENOMEM);
+   };
+
+   if ((rc = akudp_socket(address, port, family, 1, &reflector->fd)) != 0)
+   {
+      akudp_reflector_destroy(reflector);
+      return(rc);
+   };
+
+   sinlen = sizeof(sa);
+   if (getsockname(reflector->fd, &sa.sa, &sinlen) == -1)
+   {
+      rc = errno;
+      akudp_reflector_destroy(reflector);
+      return(rc);
+   };
+
+   // STAMP reflectors report the TTL of requests
+   if (mode == AKUDP_MODE_STAMP)
+      akudp_socket_recvttl(reflector->fd, sa.sa.sa_family);
+
+   // request destination address of received packets so replies from a
+   // wildcard socket leave from the address the request was sent to
+   opt = 1;
+   rc  = 0;
+#if defined(IPV6_RECVPKTINFO)
+   if ( (sa.sa.sa_family == AF_INET6) && (setsockopt(reflector->fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &opt, sizeof(opt)) == -1) )
+      rc = errno;
+#endif
+#if defined(IP_PKTINFO)
+   if ( (sa.sa.sa_family == AF_INET) && (setsockopt(reflector->fd, IPPROTO_IP, IP_PKTINFO, &opt, sizeof(opt)) == -1) )
+      rc = errno;
+#endif
+   if ((rc))
+   {
+      akudp_reflector_destroy(reflector);
+      return(rc);
+   };
+
+   *reflectorp = reflector;
+
+   return(0);
+}
+
+
+// answer pending requests from the address each was sent to, returns number
+// answered or -1 on error
+int
+akudp_reflector_process(
+         akudp_reflector_t *           reflector )
+{
+   int                        count;
+   int                        ttl;
+   unsigned                   ifindex;
+   ssize_t                    ssize;
+   socklen_t                  sinlen;
+   struct timespec            ts_recv;
+   struct timespec            ts;
+   union akudp_sa             sa;
+   union akudp_sa             local;
+
+   for(count = 0; (count < AKUDP_BATCH); )
+   {
+      if ((ssize = akudp_reflector_recvmsg(reflector, &sa, &sinlen, &local, &ifindex, &ttl)) == -1)
+      {
+         if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR) )
+            return(count);
+         return(-1);
+      };
+      clock_gettime(CLOCK_REALTIME, &ts_recv);
+      reflector->stats.rcvd++;
+      reflector->req_sn++;
+
+      if ( ( (reflector->mode == AKUDP_MODE_ECHOPLUS) && (ssize < AKUDP_ECHOPLUS_SIZE) ) ||
+           ( (reflector->mode == AKUDP_MODE_STAMP)    && (ssize < AKUDP_STAMP_SIZE) ) )
+      {
+         reflector->stats.invalid++;
+         continue;
+      };
+      reflector->res_sn++;
+
+      // fill in reflector fields of request
+      clock_gettime(CLOCK_REALTIME, &ts);
+      switch(reflector->mode)
+      {
+         case AKUDP_MODE_ECHOPLUS:
+         akudp_echoplus_reflect(reflector->buff, (size_t)ssize, reflector->res_sn, &ts_recv, &ts, reflector->failures);
+         break;
+
+         case AKUDP_MODE_STAMP:
+         if ( (!(reflector->errest)) || ((ts.tv_sec - reflector->errest_time) >= AKUDP_STAMP_ERREST_REFRESH) )
+         {
+            reflector->errest      = akudp_stamp_errest();
+            reflector->errest_time = ts.tv_sec;
+         };
+         akudp_stamp_reflect(reflector->buff, (size_t)ssize, &ts_recv, &ts, reflector->errest, ttl);
+         break;
+
+         default:
+         break;
+      };
+
+      if (akudp_reflector_sendmsg(reflector, (size_t)ssize, &sa, sinlen, &local, ifindex) == -1)
+      {
+         reflector->failures++;
+         reflector->stats.failures++;
+         continue;
+      };
+      reflector->stats.sent++;
+      count++;
+   };
+
+   return(count);
+}
+
+
+// receive request, destination address, and TTL or hop limit of datagram
+ssize_t
+akudp_reflector_recvmsg(
+         akudp_reflector_t *           reflector,
+         union akudp_sa *              sap,
+         socklen_t *                   sinlenp,
+         union akudp_sa *              localp,
+         unsigned *                    ifindexp,
+         int *                         ttlp )
+{
+   ssize_t                    ssize;
+   struct iovec               iov;
+   struct msghdr              msg;
+   struct cmsghdr *           cmsg;
+   union
+   {
+      char                    bytes[AKUDP_CMSG_SIZE];
+      struct cmsghdr          align;
+   } cbuff;
+
+   iov.iov_base         = reflector->buff;
+   iov.iov_len          = AKUDP_BUFF_SIZE;
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_name         = &sap->sa;
+   msg.msg_namelen      = sizeof(struct sockaddr_storage);
+   msg.msg_iov          = &iov;
+   msg.msg_iovlen       = 1;
+   msg.msg_control      = cbuff.bytes;
+   msg.msg_controllen   = sizeof(cbuff);
+
+   if ((ssize = recvmsg(reflector->fd, &msg, 0)) == -1)
+      return(-1);
+   *sinlenp = msg.msg_namelen;
+
+   *ttlp    = akudp_cmsg_ttl(&msg);
+
+   // extract destination address of packet
+   memset(localp, 0, sizeof(union akudp_sa));
+   *ifindexp = 0;
+   for(cmsg = CMSG_FIRSTHDR(&msg); (cmsg != NULL); cmsg = CMSG_NXTHDR(&msg, cmsg))
+   {
+#if defined(IP_PKTINFO)
+      if ( (cmsg->cmsg_level == IPPROTO_IP) && (cmsg->cmsg_type == IP_PKTINFO) )
+      {
+         struct in_pktinfo pi;
+         memcpy(&pi, CMSG_DATA(cmsg), sizeof(pi));
+         *ifindexp                = (unsigned)pi.ipi_ifindex;
+         localp->sin.sin_family   = AF_INET;
+         localp->sin.sin_addr     = pi.ipi_addr;
+      };
+#endif
+#if defined(IPV6_RECVPKTINFO)
+      if ( (cmsg->cmsg_level == IPPROTO_IPV6) && (cmsg->cmsg_type == IPV6_PKTINFO) )
+      {
+         struct in6_pktinfo pi6;
+         memcpy(&pi6, CMSG_DATA(cmsg), sizeof(pi6));
+         *ifindexp                = pi6.ipi6_ifindex;
+         localp->sin6.sin6_family = AF_INET6;
+         localp->sin6.sin6_addr   = pi6.ipi6_addr;
+      };
+#endif
+   };
+
+   return(ssize);
+}
+
+
+// send reply from the address the request was sent to
+ssize_t
+akudp_reflector_sendmsg(
+         akudp_reflector_t *           reflector,
+         size_t                        len,
+         union akudp_sa *              sap,
+         socklen_t                     sinlen,
+         const union akudp_sa *        localp,
+         unsigned                      ifindex )
+{
+   struct iovec               iov;
+   struct msghdr              msg;
+   struct cmsghdr *           cmsg;
+   union
+   {
+      char                    bytes[AKUDP_CMSG_SIZE];
+      struct cmsghdr          align;
+   } cbuff;
+
+   iov.iov_base         = reflector->buff;
+   iov.iov_len          = len;
+   memset(&msg,   0, sizeof(msg));
+   memset(&cbuff, 0, sizeof(cbuff));
+   msg.msg_name         = &sap->sa;
+   msg.msg_namelen      = sinlen;
+   msg.msg_iov          = &iov;
+   msg.msg_iovlen       = 1;
+   msg.msg_control      = cbuff.bytes;
+   msg.msg_controllen   = sizeof(cbuff);
+   cmsg                 = CMSG_FIRSTHDR(&msg);
+
+   switch(localp->ss.ss_family)
+   {
+#if defined(IP_PKTINFO)
+      case AF_INET:
+      {
+         struct in_pktinfo pi;
+         memset(&pi, 0, sizeof(pi));
+         pi.ipi_spec_dst         = localp->sin.sin_addr;
+         cmsg->cmsg_level        = IPPROTO_IP;
+         cmsg->cmsg_type         = IP_PKTINFO;
+         cmsg->cmsg_len          = CMSG_LEN(sizeof(pi));
+         memcpy(CMSG_DATA(cmsg), &pi, sizeof(pi));
+         msg.msg_controllen      = CMSG_SPACE(sizeof(pi));
+         break;
+      };
+#endif
+
+#if defined(IPV6_RECVPKTINFO)
+      case AF_INET6:
+      {
+         struct in6_pktinfo pi6;
+         memset(&pi6, 0, sizeof(pi6));
+         pi6.ipi6_addr           = localp->sin6.sin6_addr;
+         // interface is only pinned for link-local scope
+         if (IN6_IS_ADDR_LINKLOCAL(&pi6.ipi6_addr))
+            pi6.ipi6_ifindex     = ifindex;
+         cmsg->cmsg_level        = IPPROTO_IPV6;
+         cmsg->cmsg_type         = IPV6_PKTINFO;
+         cmsg->cmsg_len          = CMSG_LEN(sizeof(pi6));
+         memcpy(CMSG_DATA(cmsg), &pi6, sizeof(pi6));
+         msg.msg_controllen      = CMSG_SPACE(sizeof(pi6));
+         break;
+      };
+#endif
+
+      default:
+      msg.msg_control      = NULL;
+      msg.msg_controllen   = 0;
+      break;
+   };
+
+   return(sendmsg(reflector->fd, &msg, 0));
+}
+
+
+// copy counters of reflector
+void
+akudp_reflector_stats(
+         const akudp_reflector_t *     reflector,
+         akudp_reflector_stats_t *     stats )
+{
+   *stats = reflector->stats;
+   return;
+}
+
+/* end of source file */
@@ -0,0 +1,126 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libakcom-udpecho/lstats.c  sequence and round-trip statistics
+ */
+#define _LIB_LIBAKCOM_UDPECHO_LSTATS_C 1
+#include "libakcom-udpecho.h"
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+// RFC 3550 interarrival jitter updated with delay variation of consecutive
+// responses
+double
+akudp_jitter(
+         double                        jitter,
+         int64_t                       ipdv )
+{
+   return(jitter + (((double)llabs(ipdv) - jitter) / 16.0));
+}
+
+
+// track sequence number in window and classify response as AKUDP_SEQ_*,
+// seq_last is the most recent sequence sent and timeout is in units of rtt
+int
+akudp_seq_classify(
+         akudp_seqwin_t *              win,
+         uint32_t                      seq,
+         uint32_t                      seq_last,
+         uint64_t                      rtt,
+         uint64_t                      timeout )
+{
+   int32_t                    diff;
+   uint32_t                   pos;
+   uint64_t                   bit;
+   uint64_t *                 word;
+
+   // serial number arithmetic tolerates wrapping of 32-bit sequences
+   if ( (!(seq)) || ((int32_t)(seq - seq_last) > 0) )
+      return(AKUDP_SEQ_INVALID);
+   diff = (int32_t)(seq - win->seq_max);
+
+   // behind the window, cannot tell duplicates apart
+   if (diff <= -AKUDP_SEQ_WINDOW)
+      return(AKUDP_SEQ_LATE);
+
+   // advance window, clearing slots of skipped sequences and of the new
+   // sequence which still hold sequences from one window earlier
+   if (diff > 0)
+   {
+      if (diff >= AKUDP_SEQ_WINDOW)
+         memset(win->bits, 0, sizeof(win->bits));
+      else
+         for(pos = win->seq_max + 1; (pos != (seq + 1)); pos++)
+            win->bits[(pos % AKUDP_SEQ_WINDOW) / 64] &= ~(1ULL << (pos % 64));
+      win->seq_max = seq;
+   };
+
+   word = &win->bits[(seq % AKUDP_SEQ_WINDOW) / 64];
+   bit  = 1ULL << (seq % 64);
+   if ((*word & bit))
+      return(AKUDP_SEQ_DUPLICATE);
+   *word |= bit;
+
+   if (rtt > timeout)
+      return(AKUDP_SEQ_LATE);
+   if (diff < 0)
+      return(AKUDP_SEQ_REORDERED);
+
+   return(AKUDP_SEQ_NEW);
+}
+
+
+// update running mean and sum of squared deviations (Welford) with value,
+// count includes value
+void
+akudp_welford(
+         double *                      meanp,
+         double *                      m2p,
+         uint64_t                      count,
+         double                        value )
+{
+   double                     delta;
+
+   delta   = value - *meanp;
+   *meanp += delta / (double)count;
+   *m2p   += delta * (value - *meanp);
+
+   return;
+}
+
+/* end of source file */
@@ -0,0 +1,274 @@
+/*
+ *  Alaska Communications UDP Echo Tools
+ *  Copyright (C) 2020, 2025 Alaska Communications
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libakcom-udpecho/lutil.c  miscellaneous functions
+ */
+#define _LIB_LIBAKCOM_UDPECHO_LUTIL_C 1
+#include "libakcom-udpecho.h"
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+#pragma mark - Functions
+
+// traffic class of received datagram, returns -1 if not present
+int
+akudp_cmsg_tos(
+         struct msghdr *               msg )
+{
+   int                        tos;
+   struct cmsghdr *           cmsg;
+
+   for(cmsg = CMSG_FIRSTHDR(msg); (cmsg != NULL); cmsg = CMSG_NXTHDR(msg, cmsg))
+   {
+#if defined(IP_RECVTOS)
+      // IPv4 traffic class is delivered as a single byte
+      if ( (cmsg->cmsg_level == IPPROTO_IP) && (cmsg->cmsg_type == IP_TOS) )
+         return(*(unsigned char *)CMSG_DATA(cmsg));
+#endif
+#if defined(IPV6_RECVTCLASS)
+      if ( (cmsg->cmsg_level == IPPROTO_IPV6) && (cmsg->cmsg_type == IPV6_TCLASS) )
+      {
+         memcpy(&tos, CMSG_DATA(cmsg), sizeof(int));
+         return(tos);
+      };
+#endif
+   };
+
+   return(-1);
+}
+
+
+// TTL or hop limit of received datagram, returns 0 if not present
+int
+akudp_cmsg_ttl(
+         struct msghdr *               msg )
+{
+   int                        ttl;
+   struct cmsghdr *           cmsg;
+
+   for(cmsg = CMSG_FIRSTHDR(msg); (cmsg != NULL); cmsg = CMSG_NXTHDR(msg, cmsg))
+   {
+#if defined(IP_RECVTTL)
+      if ( (cmsg->cmsg_level == IPPROTO_IP) && (cmsg->cmsg_type == IP_TTL) )
+      {
+         memcpy(&ttl, CMSG_DATA(cmsg), sizeof(int));
+         return(ttl);
+      };
+#endif
+#if defined(IPV6_RECVHOPLIMIT)
+      if ( (cmsg->cmsg_level == IPPROTO_IPV6) && (cmsg->cmsg_type == IPV6_HOPLIMIT) )
+      {
+         memcpy(&ttl, CMSG_DATA(cmsg), sizeof(int));
+         return(ttl);
+      };
+#endif
+   };
+
+   return(0);
+}
+
+
+// resolve address and open non-blocking UDP socket, returns 0 or error code
+int
+akudp_socket(
+         const char *                  host,
+         const char *                  port,
+         int                           family,
+         int                           passive,
+         int *                         fdp )
+{
+   int                        rc;
+   int                        s;
+   int                        err;
+   int                        opt;
+   struct addrinfo            hints;
+   struct addrinfo *          res;
+   struct addrinfo *          ai;
+
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family   = family;
+   hints.ai_socktype = SOCK_DGRAM;
+   hints.ai_protocol = IPPROTO_UDP;
+   hints.ai_flags    = ((passive)) ? AI_PASSIVE : 0;
+   if ((rc = getaddrinfo(host, port, &hints, &res)) != 0)
+      return(((rc == EAI_SYSTEM)) ? errno : -abs(rc));
+
+   // use first address which accepts a socket
+   for(ai = res, s = -1, err = EADDRNOTAVAIL; ( ((ai)) && (s == -1) ); ai = ai->ai_next)
+   {
+      if ((s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) == -1)
+      {
+         err = errno;
+         continue;
+      };
+      opt = 1;
+      if ((passive))
+         setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+      if ( ((passive)) && (ai->ai_family == AF_INET6) )
+         setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, &opt, sizeof(opt));
+      rc = ((passive))
+         ? bind(s, ai->ai_addr, ai->ai_addrlen)
+         : connect(s, ai->ai_addr, ai->ai_addrlen);
+      if (rc == -1)
+      {
+         err = errno;
+         close(s);
+         s = -1;
+      };
+   };
+   freeaddrinfo(res);
+   if (s == -1)
+      return(err);
+
+   if (fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK) == -1)
+   {
+      err = errno;
+      close(s);
+      return(err);
+   };
+   *fdp = s;
+
+   return(0);
+}
+
+
+// enable TTL or hop limit of received datagrams, returns -1 on error
+int
+akudp_socket_recvttl(
+         int                           fd,
+         int                           family )
+{
+   int                        opt;
+
+   // IPv6 sockets also receive IPv4 datagrams as mapped addresses
+   opt = 1;
+#if defined(IPV6_RECVHOPLIMIT)
+   if ( (family == AF_INET6) && (setsockopt(fd, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &opt, sizeof(opt)) == -1) )
+      return(-1);
+#endif
+#if defined(IP_RECVTTL)
+   if ( (setsockopt(fd, IPPROTO_IP, IP_RECVTTL, &opt, sizeof(opt)) == -1) && (family == AF_INET) )
+      return(-1);
+#endif
+
+   return(0);
+}
+
+
+// mark datagrams with traffic class unless tos is -1 and enable traffic class
+// of received datagrams, returns -1 on error
+int
+akudp_socket_tclass(
+         int                           fd,
+         int                           family,
+         int                           tos )
+{
+   int                        opt;
+
+   opt = 1;
+   if (family == AF_INET6)
+   {
+      if ( (tos != -1) && (setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos)) == -1) )
+         return(-1);
+#if defined(IPV6_RECVTCLASS)
+      if (setsockopt(fd, IPPROTO_IPV6, IPV6_RECVTCLASS, &opt, sizeof(opt)) == -1)
+         return(-1);
+#endif
+   };
+   if ( (family == AF_INET) && (tos != -1) && (setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) == -1) )
+      return(-1);
+
+   // IPv6 sockets also receive IPv4 datagrams as mapped addresses
+#if defined(IP_RECVTOS)
+   if ( (setsockopt(fd, IPPROTO_IP, IP_RECVTOS, &opt, sizeof(opt)) == -1) && (family == AF_INET) )
+      return(-1);
+#endif
+
+   return(0);
+}
+
+
+// describe error code returned by library
+const char *
+akudp_strerror(
+         int                           err )
+{
+   // getaddrinfo codes are negative on some platforms and positive on others
+   if (err < 0)
+      return(gai_strerror((EAI_NONAME < 0) ? err : -err));
+   return(strerror(err));
+}
+
+
+// calculates delta between timespecs and returns result as microseconds
+uint64_t
+akudp_timespec_delta(
+         const struct timespec *       ts1,
+         const struct timespec *       ts2,
+         struct timespec *             delta )
+{
+   struct timespec ts;
+   uint64_t        usec;
+
+   if (!(delta))
+      delta = &ts;
+
+   delta->tv_sec  = ts1->tv_sec;
+   delta->tv_nsec = ts1->tv_nsec;
+   if (delta->tv_nsec < ts2->tv_nsec)
+   {
+      delta->tv_sec--;
+      delta->tv_nsec += 1000000000L;
+   };
+   delta->tv_sec  -= ts2->tv_sec;
+   delta->tv_nsec -= ts2->tv_nsec;
+
+   usec  = (uint64_t)delta->tv_sec * 1000000ULL;
+   usec += (uint64_t)delta->tv_nsec / 1000ULL;
+
+   return(usec);
+}
+
+
+// version of library
+const char *
+akudp_version(
+         void )
+{
+   return(PACKAGE_VERSION);
+}
+
+/* end of source file */
@@ -34,15 +34,15 @@
  */
 /*
  *  Simple Build:
- *     export CFLAGS='-Wall -Wno-unknown-pragmas'
- *     gcc ${CFLAGS} -c akcom-udpecho.c
- *     gcc ${CFLAGS} -o akcom-udpecho akcom-udpecho.o
+ *     export CFLAGS='-Wall -Wno-unknown-pragmas -I../include -I../lib/libakcom-udpecho'
+ *     gcc ${CFLAGS} -c akcom-udpecho.c ../lib/libakcom-udpecho/l*.c
+ *     gcc ${CFLAGS} -o akcom-udpecho akcom-udpecho.o l*.o -lpthread -lm
  *
  *  Libtool Build:
- *     export CFLAGS='-Wall -Wno-unknown-pragmas'
+ *     export CFLAGS='-Wall -Wno-unknown-pragmas -I../include'
  *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c akcom-udpecho.c
  *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -o akcom-udpecho \
- *             akcom-udpecho.lo
+ *             akcom-udpecho.lo ../lib/libakcom-udpecho.la
  *
  *  Libtool Clean:
  *     libtool --mode=clean rm -f akcom-udpecho.lo akcom-udpecho
@@ -61,6 +61,11 @@
 #   define _XOPEN_SOURCE 600
 #endif
 
+// required by glibc for ppoll()
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE 1
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
@@ -72,6 +77,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <errno.h>
 #include <string.h>
 #include <strings.h>
@@ -87,8 +93,18 @@
 #include <syslog.h>
 #include <signal.h>
 #include <poll.h>
+#include <pthread.h>
+#include <sys/time.h>
 #include <string.h>
 #include <strings.h>
+#include <math.h>
+#if defined(__linux__)
+#include <sys/prctl.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#endif
+
+#include <akcom-udpecho.h>
 
 
 ///////////////////
@@ -112,6 +128,17 @@
 #   define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
 #endif
 
+#if !defined(HAVE_CONFIG_H) && (defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__))
+#   define HAVE_PPOLL 1
+#endif
+#if !defined(HAVE_CONFIG_H) && (defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__))
+#   define HAVE_SENDMMSG 1
+#   define HAVE_RECVMMSG 1
+#endif
+#if defined(__linux__) && defined(SO_TIMESTAMPING) && defined(HAVE_RECVMMSG)
+#   define HAVE_SO_TIMESTAMPING 1
+#endif
+
 #define my_sec2msec( sec )   (  sec * 1000 )
 #define my_sec2usec( sec )   (  sec * 1000000 )
 #define my_sec2nsec( sec )   (  sec * 1000000000 )
@@ -130,6 +157,73 @@
 
 #define my_usec2msec_tenths( usec ) ((usec%1000)/100)
 
+#define MY_STAMP_SIZE            AKUDP_STAMP_SIZE
+#define MY_STAMP_SS_SEQ          24             // session-sender sequence in reflector packet
+#define MY_BATCH_MAX             64             // max sends or receives per loop pass
+#define MY_BURST_MAX             64             // max requests per burst
+#define MY_LINE_MAX              1024           // max line length of target file
+
+#define MY_HIST_TARGETS          256            // max targets with latency histograms
+#define MY_SEQ_WINDOW            AKUDP_SEQ_WINDOW
+#define MY_CLOCK_FILTER          8              // probes per minimum delay clock sample
+#define MY_CLOCK_PERIOD          1000000        // min usec per minimum delay clock sample
+#define MY_CLOCK_WINDOW          64             // filtered clock samples of drift fit
+#define MY_CLOCK_DRIFT_MIN       8              // filtered clock samples before drift is reported
+#define MY_CLOCK_DRIFT_SPAN      30000000       // usec spanned by samples before drift is reported
+#define MY_TX_RING               4096           // datagrams awaiting kernel TX timestamps
+#define MY_CMSG_SIZE             128            // control buffer of received datagram
+#define MY_DSCP_MAX              8              // max traffic classes probed concurrently
+#define MY_SOCK_MAX              (MY_DSCP_MAX * 2) // sockets per worker, one per class and family
+
+#define MY_TS_NONE               0
+#define MY_TS_SOFTWARE           1              // kernel software timestamps
+#define MY_TS_HARDWARE           2              // NIC hardware timestamps
+
+#define MY_SEQ_NEW               AKUDP_SEQ_NEW
+#define MY_SEQ_REORDERED         AKUDP_SEQ_REORDERED
+#define MY_SEQ_DUPLICATE         AKUDP_SEQ_DUPLICATE
+#define MY_SEQ_LATE              AKUDP_SEQ_LATE
+#define MY_SEQ_INVALID           AKUDP_SEQ_INVALID
+
+#define MY_LOSS_FORWARD          0              // request lost before reflector
+#define MY_LOSS_RETURN           1              // response lost after reflector
+#define MY_LOSS_REFLECTOR        2              // request dropped by reflector
+
+#define MY_REPORT_IDLE           0              // worker has not contributed to round
+#define MY_REPORT_JOINED         1              // worker contributed to round
+#define MY_REPORT_EXITED         2              // worker exited, final statistics merged each round
+
+#define MY_CAP_LOAD_MAGIC        0x414b434cU    // "AKCL" capacity load packet
+#define MY_CAP_STATUS_MAGIC      0x414b4353U    // "AKCS" capacity status feedback
+#define MY_CAP_SIZE              1222           // default capacity load payload
+#define MY_CAP_RATE_MAX          1390           // rate table index of 40 Gbit/s
+#define MY_CAP_LOW_THRESH        30000          // delay variation to increase (usec)
+#define MY_CAP_UPPER_THRESH      90000          // delay variation to decrease (usec)
+#define MY_CAP_SEQ_ERR_THRESH    10             // sequence errors to decrease
+#define MY_CAP_SLOW_ADJ_THRESH   3              // impaired feedback to confirm congestion
+#define MY_CAP_HIGH_SPEED_DELTA  10             // rate table rows before congestion
+#define MY_CAP_BACKOFF           30             // rate table rows of first congestion backoff
+#define MY_CAP_SUB_INTERVALS     10             // default sub-intervals of capacity test
+#define MY_CAP_CATCHUP           10000000ULL    // max send backlog in nanoseconds
+#define MY_CAP_QUIET             2              // empty status feedback ending the drain
+#define MY_CAP_SNDBUF            (8 * 1024 * 1024)
+
+#define MY_PROFILE_MAX           16             // max entries of traffic profile
+#define MY_PROFILE_BUCKETS       8              // buckets of a single size range
+#define MY_SWEEP_COUNT           5              // default requests per size of sweep
+#define MY_SWEEP_STEP            64             // default size increment of sweep
+#define MY_SWEEP_MAX             65507          // largest UDP payload of sweep
+
+#define MY_FORMAT_TEXT           0              // human readable lines
+#define MY_FORMAT_JSONL          1              // one JSON object per line
+#define MY_FORMAT_CSV            2              // comma separated, type first
+#define MY_FORMAT_METRICS        3              // Prometheus text exposition, escaping only
+#define MY_OUTBUF_SIZE           65536          // per worker record buffer
+
+#define MY_METRICS_PERIOD        1              // seconds between metrics updates
+#define MY_METRICS_TIMEOUT       2              // seconds to receive scrape request
+#define MY_METRICS_REQ           2048           // max HTTP request header size
+
 
 /////////////////
 //             //
@@ -149,17 +243,228 @@ union my_sa
 
 typedef struct udp_echo_plus
 {
-   uint32_t  req_sn;
-   uint32_t  res_sn;
-   uint32_t  recv_time;
-   uint32_t  reply_time;
-   uint32_t  failures;
-   uint32_t  iteration;
+   uint8_t   hdr[AKUDP_ECHOPLUS_SIZE]; // UDPEchoPlus header, see akudp_echoplus_encode()
    struct timespec   send_time;
    uint8_t   bytes[];
 } echoplus_t;
 
 
+// request sizes of traffic profile entry
+typedef struct my_profile
+{
+   size_t    min;
+   size_t    max;
+   unsigned  weight;
+} my_profile_t;
+
+
+// statistics of a traffic profile size bucket
+typedef struct my_bucket
+{
+   uint64_t  sent;
+   uint64_t  rcvd;
+   uint64_t  corrupt;            // responses failing verification
+   uint64_t  rtt_min;            // microseconds
+   uint64_t  rtt_max;
+   uint64_t  rtt_sum;
+} my_bucket_t;
+
+
+// results of a single request size of a size sweep
+typedef struct my_sweep
+{
+   size_t    size;
+   uint32_t  sent;
+   uint32_t  rcvd;
+   int       toobig;             // rejected as larger than known path MTU
+   uint64_t  rtt_min;            // microseconds
+   uint64_t  rtt_max;
+   uint64_t  rtt_sum;
+} my_sweep_t;
+
+
+// capacity test load packet header, remainder of packet is padding
+typedef struct capacity_load
+{
+   uint32_t  magic;
+   uint32_t  session;
+   uint32_t  seq;
+   uint32_t  tx_sec;          // sender monotonic clock
+   uint32_t  tx_nsec;
+} capacity_load_t;
+
+
+// capacity test status feedback, counters cover one feedback interval
+typedef struct capacity_status
+{
+   uint32_t  magic;
+   uint32_t  session;
+   uint32_t  seq;             // status message sequence
+   uint32_t  interval;        // microseconds covered by counters
+   uint32_t  rx_pkts;
+   uint32_t  rx_bytes;        // UDP payload bytes
+   uint32_t  seq_gap;         // load sequences skipped
+   uint32_t  seq_ooo;         // load sequences received out of order
+   uint32_t  dvar_max;        // max one-way delay above session minimum (usec)
+   uint32_t  rx_drops;        // load datagrams dropped by receive buffer overflow
+} capacity_status_t;
+
+
+// probe statistics of a single target
+typedef struct my_stats
+{
+   uint32_t  seq;                // sequence of most recent request
+   uint32_t  sent;               // requests accepted by the kernel
+   uint32_t  rcvd;
+   uint64_t  rtt_min;            // microseconds
+   uint64_t  rtt_max;
+   uint64_t  rtt_sum;
+   uint64_t  adj_min;
+   uint64_t  adj_max;
+   uint64_t  adj_sum;
+   int64_t   fwd_min;
+   int64_t   fwd_max;
+   int64_t   fwd_sum;
+   int64_t   rev_min;
+   int64_t   rev_max;
+   int64_t   rev_sum;
+   uint64_t  owd_cnt;            // responses with one-way delays
+   double    rtt_mean;           // running mean and squared deviations
+   double    rtt_m2;
+   double    adj_mean;
+   double    adj_m2;
+   akudp_hist_t * rtt_hist;
+   akudp_hist_t * adj_hist;
+   int       stamp_sync;
+   uint32_t  dups;
+   uint32_t  reordered;
+   uint32_t  late;
+   uint32_t  corrupt;            // replies with altered payload or size
+   uint32_t  tos_rcvd;           // replies with known traffic class (-X)
+   uint32_t  tos_remarked;       // replies with DSCP other than sent
+   uint32_t  tos_ce;             // replies marked congestion experienced
+   uint32_t  last_seq;           // sequence of previous accepted response
+   uint64_t  last_rtt;           // round-trip of previous accepted response
+   double    jitter;             // RFC 3550 interarrival jitter (usec)
+   uint64_t  jitter_cnt;
+   uint64_t  jitter_abs_sum;     // sum of |D| of consecutive arrivals, interval jitter
+   uint64_t  jitter_abs_cnt;
+   int64_t   ipdv_min;           // RFC 5481 inter-packet delay variation
+   int64_t   ipdv_max;
+   uint64_t  ipdv_abs_sum;
+   uint64_t  ipdv_cnt;
+   akudp_seqwin_t seqwin;        // sequences received
+   uint32_t  loss[3];            // directional loss from echo plus counters
+   uint32_t  loss_req_sn;        // counters of previous in order response
+   uint32_t  loss_res_sn;
+   uint32_t  loss_failures;
+   int       loss_valid;
+   int       loss_shared;        // reflector counters include other clients
+   uint32_t  burst_id;           // burst of most recent response
+   uint32_t  burst_rcvd;         // responses received in current burst
+   uint64_t  burst_first;        // arrival of first response in burst (nsec)
+   uint64_t  burst_last;         // arrival of last response in burst (nsec)
+   uint64_t  burst_bytes;        // bytes received after first response in burst
+   uint32_t  bursts_sent;
+   uint32_t  bursts;             // bursts with at least one response
+   uint32_t  bursts_lossy;       // bursts missing responses
+   uint64_t  disp_min;           // receive dispersion of bursts (nsec, -K only)
+   uint64_t  disp_max;
+   uint64_t  disp_sum;
+   uint64_t  disp_bytes;         // bytes received during dispersion
+   uint32_t  disp_cnt;
+   uint64_t * burst_rtt;         // round-trip sum by position in burst
+   uint32_t * burst_cnt;         // responses by position in burst
+   int64_t *  ktx;               // kernel TX time by sequence window slot (nsec)
+   int64_t *  stx;               // monotonic STAMP send time by sequence window slot (nsec)
+   uint64_t  krtt_min;           // kernel timestamped round-trip (usec)
+   uint64_t  krtt_max;
+   uint64_t  krtt_sum;
+   uint64_t  krtt_cnt;
+   int64_t   host_sum;           // application minus kernel round-trip (usec)
+   int       clk_valid;
+   uint32_t  clk_base;           // first server minus client offset (usec, mod 2^32)
+   int64_t   clk_t0;             // client time of first offset (usec)
+   uint32_t  clk_cnt;            // samples in current filter window
+   int64_t   clk_start;          // client time of first sample of filter window
+   int64_t   clk_best_delay;     // minimum delay of current filter window
+   int64_t   clk_best_offset;    // offset relative to base of minimum delay sample
+   int64_t   clk_best_time;      // client time of minimum delay sample
+   int64_t   clk_win_t[MY_CLOCK_WINDOW]; // recent filtered samples, client time relative to t0
+   int64_t   clk_win_o[MY_CLOCK_WINDOW]; // recent filtered samples, offset relative to base
+   uint32_t  clk_total;          // filtered samples taken
+   uint32_t  clk_n;              // least squares fit of recent filtered offsets
+   int64_t   clk_span;           // usec between oldest and newest recent sample
+   double    clk_st;
+   double    clk_so;
+   double    clk_stt;
+   double    clk_sto;
+} my_stats_t;
+
+
+// probe target
+typedef struct my_target
+{
+   char *        host;
+   union my_sa   sa;
+   socklen_t     salen;
+   uint32_t      hash;
+   size_t        next;           // next target in hash chain (index + 1)
+   int           tos;            // traffic class of requests, -1 for default
+   unsigned      cls;            // index of traffic class
+   char          addrstr[INET6_ADDRSTRLEN];
+} my_target_t;
+
+
+// datagram awaiting kernel TX timestamp, keyed by SO_TIMESTAMPING OPT_ID
+typedef struct my_txmap
+{
+   uint32_t  id;
+   uint32_t  target;
+   uint32_t  seq;
+} my_txmap_t;
+
+
+// probe worker, each thread owns its sockets, schedule, and statistics
+typedef struct my_worker
+{
+   pthread_t       thread;
+   int             rc;
+   struct pollfd   fds[MY_SOCK_MAX+1]; // IPv4 and IPv6 socket per class, stop pipe
+   uint64_t        start_nsec;
+   uint64_t        total_sent;    // read by reporting thread
+   uint64_t        total_rcvd;    // read by reporting thread
+   uint64_t        total_loss[3]; // read by reporting thread
+   echoplus_t *    rcvbuff;
+   echoplus_t *    sndbuff;
+   my_stats_t *    stats;         // one per target
+   char *          outbuf;        // pending structured records
+   size_t          outlen;
+   uint32_t        tx_id[MY_SOCK_MAX];  // OPT_ID of next datagram per socket
+   my_txmap_t *    tx_map[MY_SOCK_MAX]; // datagrams awaiting TX timestamps per socket
+   uint64_t        report_nsec;   // end of current report interval
+   unsigned        summary_gen;   // most recent summary request contributed to
+   uint64_t        metrics_nsec;  // next update of metrics endpoint
+   uint16_t        errest;        // STAMP error estimate of local clock
+   time_t          errest_time;   // wall clock second of error estimate
+   size_t          sndlen[MY_BURST_MAX];       // request sizes of current burst
+   my_bucket_t     buckets[MY_PROFILE_MAX];    // statistics per profile entry
+} my_worker_t;
+
+
+// statistics of all workers combined for interval reports and summaries
+typedef struct my_report
+{
+   pthread_mutex_t mutex;
+   unsigned        workers;       // running workers, each contributes to a round
+   unsigned        pending;       // workers yet to contribute to current round
+   uint8_t *       state;         // MY_REPORT_* of each worker
+   uint64_t        rounds;        // completed rounds
+   my_stats_t *    stats;         // combined statistics of current round
+   my_stats_t *    prev;          // combined statistics of previous interval
+} my_report_t;
+
+
 /////////////////
 //             //
 //  Variables  //
@@ -170,16 +475,62 @@ typedef struct udp_echo_plus
 static const char        * prog_name        = PROGRAM_NAME;
 static uint32_t            cnf_count        = 0;
 static int                 cnf_debug        = 0;
+static int                 cnf_dump         = 0;
 static int                 cnf_echoplus     = -1;
+static int                 cnf_stamp        = 0;
 static int                 cnf_verbose      = 0;
 static int                 cnf_silent       = 0;
 static unsigned long       cnf_timeout      = 5;
 static const char        * cnf_port         = "30006";
-static const char        * cnf_host         = NULL;
+static const char        * cnf_file         = NULL;
+static int                 cnf_multi        = 0;
+static int                 cnf_all_addrs    = 0;           // probe every resolved address
 static int                 cnf_ai_family    = PF_UNSPEC;
-static unsigned long       cnf_interval     = 1;
+static int                 cnf_throughput   = 0;
+static unsigned            cnf_threads      = 1;
+static uint64_t            cnf_interval     = 1000000000;  // nanoseconds
 static size_t              cnf_packetsize   = sizeof(echoplus_t);
-static int                 should_stop      = 0;
+static size_t              cnf_packetsize_avg = sizeof(echoplus_t); // mean request size
+static my_profile_t        cnf_profile[MY_PROFILE_MAX];   // request size distribution
+static unsigned            cnf_profile_len  = 0;
+static unsigned            cnf_profile_weight = 0;
+static int                 cnf_format       = MY_FORMAT_TEXT;
+static unsigned            cnf_burst        = 1;
+static int                 cnf_capacity     = 0;
+static unsigned            cnf_sub_intervals = 0;          // sub-intervals of capacity test
+static int                 cnf_sweep        = 0;           // step request size with DF set
+static size_t              cnf_sweep_min    = 0;
+static size_t              cnf_sweep_max    = 0;
+static size_t              cnf_sweep_step   = MY_SWEEP_STEP;
+static int                 cnf_timestamping = MY_TS_NONE;
+static uint64_t            cnf_report       = 0;           // nanoseconds
+static int                 cnf_tos[MY_DSCP_MAX];          // traffic class byte of each class
+static const char        * cnf_tos_name[MY_DSCP_MAX];     // DSCP of each class as specified
+static unsigned            cnf_tos_len      = 0;
+static int                 cnf_ecn          = 0;           // mark requests ECN capable
+static int                 cnf_tos_reflected = 0;          // reflector returns traffic class of requests
+static const char        * cnf_metrics      = NULL;        // [address:]port of metrics endpoint
+static volatile sig_atomic_t should_stop    = 0;
+static int64_t             clock_offset     = 0;           // realtime minus monotonic (ns)
+static my_target_t       * targets          = NULL;
+static size_t              targets_len      = 0;
+static size_t              targets_base     = 0;           // targets of a single traffic class
+static size_t            * target_hash      = NULL;
+static size_t              target_hash_mask = 0;
+static my_worker_t       * workers          = NULL;
+static int                 stop_pipe[2]     = { -1, -1 };
+static int                 done_pipe[2]     = { -1, -1 };
+static unsigned            summary_gen      = 0;           // summaries requested by SIGUSR1
+static my_report_t         report_interval  = { PTHREAD_MUTEX_INITIALIZER, 0, 0, NULL, 0, NULL, NULL };
+static my_report_t         report_summary   = { PTHREAD_MUTEX_INITIALIZER, 0, 0, NULL, 0, NULL, NULL };
+static my_report_t         report_metrics   = { PTHREAD_MUTEX_INITIALIZER, 0, 0, NULL, 0, NULL, NULL };
+static pthread_mutex_t     metrics_mutex    = PTHREAD_MUTEX_INITIALIZER;
+static my_stats_t        * metrics_stats    = NULL;        // published snapshot of combined statistics
+static int                 metrics_fresh    = 0;           // snapshot published since last rendering
+static my_stats_t        * metrics_render   = NULL;        // snapshot owned by endpoint thread
+static char              * metrics_text     = NULL;        // rendered snapshot owned by endpoint thread
+static size_t              metrics_len      = 0;
+static const char        * seq_status[]     = { "ok", "reordered", "duplicate", "late" };
 
 
 //////////////////
@@ -196,18 +547,397 @@ main(
          char *                        argv[] );
 
 
+// close burst of most recent response and record dispersion and loss
+static void
+my_burst_finish(
+         my_stats_t *                  st );
+
+
+// record response in burst statistics
+static void
+my_burst_update(
+         my_stats_t *                  st,
+         uint32_t                      seq,
+         uint64_t                      rtt,
+         uint64_t                      recv_ns,
+         size_t                        size );
+
+
+// run RFC 9097 style IP capacity test against target
+static int
+my_capacity(
+         my_target_t *                 tgt );
+
+
+// estimated server clock offset relative to base at client time in usec
+static int64_t
+my_clock_offset(
+         const my_stats_t *            st,
+         int64_t                       t );
+
+
+// estimated server clock drift in parts per million, returns -1 until
+// enough samples span enough time
+static int
+my_clock_drift(
+         const my_stats_t *            st,
+         double *                      driftp );
+
+
+// update server clock estimate from echo plus timestamps and estimate
+// one-way delays of response
+static void
+my_clock_update(
+         my_stats_t *                  st,
+         int64_t                       t1,
+         uint32_t                      t2,
+         int64_t                       delay,
+         int64_t *                     owd_fwd,
+         int64_t *                     owd_rev );
+
+
+// adjust capacity load rate from status feedback
+static unsigned
+my_capacity_adjust(
+         unsigned                      idx,
+         uint32_t                      seq_err,
+         uint32_t                      dvar,
+         unsigned *                    impaired,
+         int *                         congested );
+
+
+// IP capacity load rate of rate table index in bits per second
+static uint64_t
+my_capacity_rate(
+         unsigned                      idx );
+
+
+// parse list of DSCP names or values into traffic classes
+static int
+my_dscp_parse(
+         char *                        list );
+
+
+// escape string as JSON string, CSV field, or label value, truncating to size
+static char *
+my_escape(
+         char *                        dst,
+         size_t                        size,
+         const char *                  src,
+         int                           format );
+
+
+// send requests and process responses of a worker
 static int
 my_loop(
-         int                           s,
+         my_worker_t *                 w );
+
+
+// parse interval with optional s, ms, or us suffix into nanoseconds
+static int
+my_interval_parse(
+         const char *                  str,
+         uint64_t *                    nsecp );
+
+
+// kernel timestamp of datagram in nanoseconds, returns 0 if not present
+static int64_t
+my_kernel_time(
+         struct msghdr *               msg );
+
+
+// open listening socket of metrics endpoint, returns -1 on error
+static int
+my_metrics_listen(
+         const char *                  arg );
+
+
+// metrics endpoint thread, answers scrapes until the test stops
+static void *
+my_metrics_run(
+         void *                        arg );
+
+
+// render most recent published snapshot if it changed
+static void
+my_metrics_render(
+         void );
+
+
+// answer HTTP request for metrics with most recent published snapshot
+static void
+my_metrics_serve(
+         int                           fd );
+
+
+// publish combined statistics of report to metrics endpoint
+static void
+my_metrics_update(
+         my_report_t *                 r );
+
+
+// write buffer to stream socket
+static void
+my_metrics_write(
+         int                           fd,
+         const char *                  buff,
+         size_t                        len );
+
+
+// wait for socket events or until timeout in nanoseconds expires
+static int
+my_poll(
+         struct pollfd *               fds,
+         nfds_t                        nfds,
+         uint64_t                      timeout );
+
+
+// attribute lost requests to direction using echo plus counters
+static void
+my_loss_update(
+         my_worker_t *                 w,
+         my_stats_t *                  st,
+         const akudp_echoplus_t *      msg,
+         int                           status );
+
+
+// parse traffic profile into request size distribution
+static int
+my_profile_parse(
+         char *                        spec );
+
+
+// size of request to target, drawn from the traffic profile when configured
+static size_t
+my_profile_size(
+         const my_target_t *           tgt,
+         uint32_t                      seq,
+         unsigned *                    bucketp );
+
+
+// print statistics of traffic profile size buckets
+static void
+my_profile_summary(
+         my_bucket_t *                 buckets );
+
+
+// write buffered structured records of worker
+static void
+my_record_flush(
+         my_worker_t *                 w );
+
+
+// print column names of structured CSV records
+static void
+my_record_header(
+         void );
+
+
+// append structured record of a response to worker buffer
+static void
+my_record_packet(
+         my_worker_t *                 w,
+         my_target_t *                 tgt,
+         uint32_t                      seq,
+         int64_t                       send_ns,
+         int64_t                       recv_ns,
+         uint64_t                      delay_ns,
+         uint64_t                      krtt_ns,
+         int                           status );
+
+
+// print structured summary record of a target
+static void
+my_record_summary(
+         my_target_t *                 tgt,
+         my_stats_t *                  st );
+
+
+// contribute worker statistics to combined report, last worker prints it
+static void
+my_report(
+         my_worker_t *                 w,
+         my_report_t *                 r );
+
+
+// print or publish combined statistics of completed round
+static void
+my_report_finish(
+         my_report_t *                 r );
+
+
+// remove exiting worker from combined report, keeping its final statistics
+static void
+my_report_leave(
+         my_worker_t *                 w,
+         my_report_t *                 r );
+
+
+// print combined statistics of interval since previous report
+static void
+my_report_print(
+         my_report_t *                 r );
+
+
+// receive and process pending responses, returns number counted
+static uint64_t
+my_recv(
+         my_worker_t *                 w,
+         int                           fd,
+         unsigned                      cls );
+
+
+// report ICMP error received on connected socket of single target
+static void
+my_recv_error(
+         int                           err );
+
+
+// process echo response from target, returns 1 if counted as received
+static int
+my_response(
+         my_worker_t *                 w,
+         my_target_t *                 tgt,
+         my_stats_t *                  st,
          echoplus_t *                  rcvbuff,
-         echoplus_t *                  sndbuff );
+         int64_t                       rx_kern );
 
 
-int
+// open unconnected socket for address family
+static int
 my_socket(
-         const char *                  host,
-         const char *                  port,
-         int                           family );
+         int                           family,
+         int                           tos );
+
+
+// determine STAMP error estimate of local clock
+static uint16_t
+my_stamp_errest(
+         my_worker_t *                 w,
+         time_t                        now );
+
+
+// track sequence number and classify response
+static int
+my_seq_update(
+         my_stats_t *                  st,
+         uint32_t                      seq,
+         uint64_t                      rtt );
+
+
+// send burst of requests to target, returns number of datagrams sent
+static unsigned
+my_send(
+         int                           fd,
+         my_target_t *                 tgt,
+         char *                        buff,
+         const size_t *                lens,
+         unsigned                      count );
+
+
+// allocate statistics of all targets
+static my_stats_t *
+my_stats_alloc(
+         void );
+
+
+// release statistics of all targets
+static void
+my_stats_free(
+         my_stats_t *                  stats );
+
+
+// print summary statistics of a single target
+static void
+my_stats_print(
+         my_target_t *                 tgt,
+         my_stats_t *                  st );
+
+
+// record latency of accepted response
+static void
+my_stats_record(
+         my_stats_t *                  st,
+         uint32_t                      seq,
+         uint64_t                      rtt,
+         uint64_t                      rtt_adj );
+
+
+// record one-way delays of accepted response
+static void
+my_stats_owd(
+         my_stats_t *                  st,
+         int64_t                       owd_fwd,
+         int64_t                       owd_rev );
+
+
+// merge statistics of a target
+static void
+my_stats_merge(
+         my_stats_t *                  dst,
+         const my_stats_t *            src );
+
+
+// print burst loss, dispersion, and round-trip by position in burst
+static void
+my_stats_burst(
+         my_stats_t *                  st );
+
+
+// print latency quantiles and standard deviation
+static void
+my_stats_quantiles(
+         const char *                  label,
+         const akudp_hist_t *          hist,
+         double                        m2,
+         uint32_t                      count );
+
+
+// clear statistics of a target, keeps allocated histograms and arrays
+static void
+my_stats_reset(
+         my_stats_t *                  st );
+
+
+// print summary of all targets in selected output format
+static void
+my_stats_summary(
+         my_stats_t *                  stats );
+
+
+// compare address families of hosts probed at every address
+static void
+my_stats_family(
+         my_stats_t *                  stats );
+
+
+// print summary statistics table of all targets
+static void
+my_stats_table(
+         my_stats_t *                  stats );
+
+
+// compare traffic classes of all targets
+static void
+my_stats_class(
+         my_stats_t *                  stats );
+
+
+// step request size through range with fragmentation disabled
+static int
+my_sweep(
+         my_target_t *                 tgt,
+         echoplus_t *                  tmpl );
+
+
+// send requests of a single size and collect responses
+static int
+my_sweep_probe(
+         int                           fd,
+         echoplus_t *                  tmpl,
+         char *                        rcvbuff,
+         uint32_t *                    seqp,
+         my_sweep_t *                  res );
 
 
 // signal system stop
@@ -216,11 +946,76 @@ static void
          int                           signum );
 
 
-extern uint64_t
-my_timespec_delta(
-         struct timespec *             ts1,
-         struct timespec *             ts2,
-         struct timespec *             delta );
+// signal request for cumulative summary
+static void
+my_summary(
+         int                           signum );
+
+
+// resolve and append probe target
+static int
+my_target_add(
+         const char *                  host );
+
+
+// replicate targets for each traffic class
+static int
+my_target_classes(
+         void );
+
+
+// append probe targets listed in file
+static int
+my_target_file(
+         const char *                  path );
+
+
+// run worker threads and report progress until they finish
+static int
+my_threads(
+         void );
+
+
+// print throughput line
+static void
+my_throughput(
+         uint64_t                      sec,
+         uint64_t                      sent,
+         uint64_t                      rcvd,
+         const uint64_t *              loss );
+
+
+// calculate hash of target address and port
+static uint32_t
+my_target_hashval(
+         const union my_sa *           sap );
+
+
+// build target hash table
+static int
+my_target_index(
+         void );
+
+
+// find target by address and port
+static my_target_t *
+my_target_lookup(
+         const union my_sa *           sap );
+
+
+// compare traffic class of response with that of the request
+static void
+my_tos_update(
+         my_stats_t *                  st,
+         const my_target_t *           tgt,
+         struct msghdr *               msg );
+
+
+// read kernel TX timestamps from socket error queue
+static void
+my_txstamp(
+         my_worker_t *                 w,
+         int                           idx );
 
 
 // display program usage
@@ -229,6 +1024,25 @@ my_usage(
       void );
 
 
+// release worker resources
+static void
+my_worker_free(
+         my_worker_t *                 w );
+
+
+// allocate worker buffers, statistics, and sockets
+static int
+my_worker_init(
+         my_worker_t *                 w,
+         const echoplus_t *            tmpl );
+
+
+// worker thread entry point
+static void *
+my_worker_run(
+         void *                        arg );
+
+
 // display program usage error
 static void
 my_usage_error(
@@ -236,6 +1050,16 @@ my_usage_error(
       ... );
 
 
+// verify echoed payload of response, returns -1 if corrupted
+static int
+my_verify(
+         my_worker_t *                 w,
+         my_target_t *                 tgt,
+         my_stats_t *                  st,
+         const char *                  buff,
+         size_t                        len );
+
+
 /////////////////
 //             //
 //  Functions  //
@@ -250,23 +1074,51 @@ main(
          char *                        argv[] )
 {
    int                       c;
-   int                       s;
+   int                       rc;
    int                       fd;
+   int                       metrics_fd;
    int                       opt_index;
+   int                       sized;
+   int                       hosts;
+   size_t                    pos;
+   size_t                    hdr;
+   unsigned                  idx;
    char                    * ptr;
    echoplus_t *              sndbuff;
-   echoplus_t *              rcvbuff;
+   akudp_echoplus_t          echoplus;
+   my_bucket_t *             bp;
+   unsigned short            port;
+   pthread_t                 metrics_thread;
+   struct timespec           now;
+   struct timespec           real;
 
    // getopt options
-   static char   short_opt[] = "46c:dehi:qrs:t:vV";
+   static char   short_opt[] = "46Ab:c:CdDeEf:F:hi:j:K:M:N:p:P:qQ:rR:s:St:TvVXz:";
    static struct option long_opt[] =
    {
+      {"all-addresses", no_argument,       0, 'A'},
+      {"burst",         required_argument, 0, 'b'},
+      {"capacity",      no_argument,       0, 'C'},
       {"debug",         no_argument,       0, 'd'},
+      {"dscp",          required_argument, 0, 'Q'},
+      {"dump",          no_argument,       0, 'D'},
       {"echoplus",      no_argument,       0, 'e'},
+      {"ecn",           no_argument,       0, 'E'},
+      {"format",        required_argument, 0, 'F'},
       {"help",          no_argument,       0, 'h'},
+      {"metrics",       required_argument, 0, 'M'},
+      {"profile",       required_argument, 0, 'P'},
       {"quiet",         no_argument,       0, 'q'},
       {"silent",        no_argument,       0, 'q'},
+      {"report-interval", required_argument, 0, 'R'},
       {"rfc",           no_argument,       0, 'r'},
+      {"stamp",         no_argument,       0, 'S'},
+      {"sub-intervals", required_argument, 0, 'N'},
+      {"sweep",         required_argument, 0, 'z'},
+      {"threads",       required_argument, 0, 'j'},
+      {"throughput",    no_argument,       0, 'T'},
+      {"timestamping",  required_argument, 0, 'K'},
+      {"tos-reflected", no_argument,       0, 'X'},
       {"verbose",       no_argument,       0, 'v'},
       {"version",       no_argument,       0, 'V'},
       {NULL,            0,                 0, 0  }
@@ -278,6 +1130,8 @@ main(
       prog_name = &ptr[1];
 
    // process arguments
+   sized = 0;
+   hosts = 0;
    while((c = getopt_long(argc, argv, short_opt, long_opt, &opt_index)) != -1)
    {
       switch(c)
@@ -294,46 +1148,183 @@ main(
          cnf_ai_family = PF_INET6;
          break;
 
+         case 'A':
+         cnf_all_addrs = 1;
+         break;
+
+         case 'b':
+         cnf_burst = (unsigned)strtoul(optarg, &ptr, 10);
+         if ( ((ptr[0])) || (cnf_burst < 1) || (cnf_burst > MY_BURST_MAX) )
+         {
+            my_usage_error("invalid burst size `%s'", optarg);
+            return(1);
+         };
+         break;
+
          case 'c':
          cnf_count = (uint32_t)strtoul(optarg, NULL, 10);
          break;
 
+         case 'C':
+         cnf_capacity = 1;
+         break;
+
          case 'd':
          cnf_debug = 1;
          break;
 
+         case 'D':
+         cnf_dump = 1;
+         break;
+
          case 'e':
          cnf_echoplus = 1;
+         cnf_stamp    = 0;
          break;
 
-         case 'r':
-         cnf_echoplus = 0;
+         case 'E':
+         cnf_ecn = 1;
          break;
 
-         case 'h':
-         my_usage();
-         return(0);
+         case 'X':
+         cnf_tos_reflected = 1;
+         break;
 
-         case 'i':
-         cnf_interval = (unsigned)strtoul(optarg, NULL, 10);
+         case 'r':
+         cnf_echoplus = 0;
+         cnf_stamp    = 0;
          break;
 
-         case 'q':
+         case 'R':
+         if ( (my_interval_parse(optarg, &cnf_report) == -1) || (cnf_report < my_sec2nsec(1ULL)) )
+         {
+            my_usage_error("invalid report interval `%s'", optarg);
+            return(1);
+         };
+         break;
+
+         case 'S':
+         cnf_echoplus = 1;
+         cnf_stamp    = 1;
+         break;
+
+         case 'f':
+         cnf_file  = optarg;
+         break;
+
+         case 'F':
+         if (!(strcasecmp(optarg, "text")))
+            cnf_format = MY_FORMAT_TEXT;
+         else if (!(strcasecmp(optarg, "jsonl")))
+            cnf_format = MY_FORMAT_JSONL;
+         else if (!(strcasecmp(optarg, "csv")))
+            cnf_format = MY_FORMAT_CSV;
+         else
+         {
+            my_usage_error("unknown output format `%s'", optarg);
+            return(1);
+         };
+         break;
+
+         case 'h':
+         my_usage();
+         return(0);
+
+         case 'i':
+         if (my_interval_parse(optarg, &cnf_interval) == -1)
+         {
+            my_usage_error("invalid interval `%s'", optarg);
+            return(1);
+         };
+         break;
+
+         case 'j':
+         cnf_threads = (unsigned)strtoul(optarg, &ptr, 10);
+         if ( ((ptr[0])) || (cnf_threads < 1) || (cnf_threads > 256) )
+         {
+            my_usage_error("invalid number of threads `%s'", optarg);
+            return(1);
+         };
+         break;
+
+         case 'K':
+#ifndef HAVE_SO_TIMESTAMPING
+         my_usage_error("kernel timestamping is not supported on this platform");
+         return(1);
+#else
+         if ( (!(strcasecmp(optarg, "software"))) || (!(strcasecmp(optarg, "sw"))) )
+            cnf_timestamping = MY_TS_SOFTWARE;
+         else if ( (!(strcasecmp(optarg, "hardware"))) || (!(strcasecmp(optarg, "hw"))) )
+            cnf_timestamping = MY_TS_HARDWARE;
+         else
+         {
+            my_usage_error("unknown timestamp source `%s'", optarg);
+            return(1);
+         };
+         break;
+#endif
+
+         case 'M':
+         cnf_metrics = optarg;
+         break;
+
+         case 'N':
+         cnf_sub_intervals = (unsigned)strtoul(optarg, &ptr, 10);
+         if ( ((ptr[0])) || (!(cnf_sub_intervals)) )
+         {
+            my_usage_error("invalid number of sub-intervals `%s'", optarg);
+            return(1);
+         };
+         break;
+
+         case 'p':
+         cnf_port  = optarg;
+         hosts     = 1;
+         break;
+
+         case 'P':
+         if ((my_profile_parse(optarg)))
+            return(1);
+         break;
+
+         case 'q':
          cnf_silent = 1;
          break;
 
+         case 'Q':
+         if ((my_dscp_parse(optarg)))
+            return(1);
+         break;
+
          case 's':
          cnf_packetsize = (size_t)strtoull(optarg, NULL, 10);
+         sized          = 1;
          break;
 
          case 't':
          cnf_timeout  = (uint64_t)strtoull(optarg, NULL, 10);
          break;
 
+         case 'T':
+         cnf_throughput = 1;
+         break;
+
          case 'v':
          cnf_verbose++;
          break;
 
+         case 'z':
+         cnf_sweep_min  = (size_t)strtoul(optarg, &ptr, 10);
+         cnf_sweep_max  = (ptr[0] == ':') ? (size_t)strtoul(&ptr[1], &ptr, 10) : 0;
+         cnf_sweep_step = (ptr[0] == ':') ? (size_t)strtoul(&ptr[1], &ptr, 10) : MY_SWEEP_STEP;
+         if ( ((ptr[0])) || (cnf_sweep_max < cnf_sweep_min) || (cnf_sweep_max > MY_SWEEP_MAX) || (!(cnf_sweep_step)) )
+         {
+            my_usage_error("invalid size sweep `%s'", optarg);
+            return(1);
+         };
+         cnf_sweep = 1;
+         break;
+
          case 'V':
          printf("%s (%s) %s\n", prog_name, PACKAGE_NAME, PACKAGE_VERSION);
          return(0);
@@ -347,48 +1338,177 @@ main(
          return(1);
       };
    };
-   if (optind >= argc)
+   if ( (optind >= argc) && (!(cnf_file)) )
    {
       my_usage_error("missing remote host");
       return(1);
    };
-   cnf_host = argv[optind++];
-   if (optind < argc)
+
+   // every argument is a host with more than two arguments, -f, or -p,
+   // otherwise the optional second argument is the port if it is numeric
+   // or a known service, and a second host if not
+   hosts = ( ((hosts)) || ((cnf_file)) || ((argc - optind) > 2) ) ? 1 : 0;
+   if ( (!(hosts)) && ((argc - optind) == 2) )
+      if ( ((argv[argc-1][strspn(argv[argc-1], "0123456789")])) && (getservbyname(argv[argc-1], "udp") == NULL) )
+         hosts = 1;
+   if ( (!(hosts)) && ((argc - optind) == 2) )
+      cnf_port = argv[argc-1];
+
+   // resolve targets
+   rc = 0;
+   for(; ( (optind < argc) && ((hosts) || (!(targets_len))) ); optind++)
+      if ((my_target_add(argv[optind])))
+         rc = 1;
+   if ( ((cnf_file)) && ((my_target_file(cnf_file))) )
+      rc = 1;
+   if ( ((rc)) && (!(hosts)) )
+      return(1);
+   if (!(targets_len))
    {
-      cnf_port = argv[optind++];
+      fprintf(stderr, "%s: no valid targets\n", prog_name);
+      return(1);
    };
-   if (optind < argc)
+   if ((my_target_index()))
    {
-      my_usage_error("unknown argument `%s'", argv[optind++]);
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
       return(1);
    };
+   cnf_multi = (targets_len > 1) ? 1 : 0;
 
-   // adjust defaults
-   if (cnf_packetsize < sizeof(echoplus_t))
-      cnf_packetsize = sizeof(echoplus_t);
-
-   // allocate receive buffer
-   if ((rcvbuff = malloc(cnf_packetsize)) == NULL)
+   // probe each target once per traffic class, ECN without a class list
+   // marks best effort requests
+   targets_base = targets_len;
+   if ( ((cnf_ecn)) && (!(cnf_tos_len)) )
+   {
+      cnf_tos_name[0] = "be";
+      cnf_tos_len     = 1;
+   };
+   for(idx = 0; (idx < cnf_tos_len); idx++)
+      cnf_tos[idx] |= ((cnf_ecn)) ? 0x02 : 0x00;
+   if ( ((cnf_tos_len)) && ((cnf_capacity)) )
+   {
+      my_usage_error("capacity test does not support traffic classes");
+      return(1);
+   };
+   if ( ((cnf_tos_len)) && ((my_target_classes())) )
    {
       fprintf(stderr, "%s: out of virtual memory\n", prog_name);
       return(1);
    };
+   if ((cnf_tos_len))
+      cnf_multi = 1;
+
+   // capacity test loads a single path and reports its own results
+   if ((cnf_capacity))
+   {
+      if ((cnf_multi))
+      {
+         my_usage_error("capacity test requires a single target");
+         return(1);
+      };
+      if (cnf_format != MY_FORMAT_TEXT)
+      {
+         my_usage_error("capacity test only supports text output");
+         return(1);
+      };
+      if ( ((cnf_report)) || ((cnf_metrics)) )
+      {
+         my_usage_error("capacity test does not support interval reports or metrics");
+         return(1);
+      };
+      if ((cnf_count))
+      {
+         my_usage_error("capacity test is limited with `-N' instead of `-c'");
+         return(1);
+      };
+      cnf_sub_intervals = ((cnf_sub_intervals)) ? cnf_sub_intervals : MY_CAP_SUB_INTERVALS;
+      cnf_echoplus     = 0;
+      cnf_stamp        = 0;
+      cnf_threads      = 1;
+      cnf_burst        = 1;
+      cnf_timestamping = MY_TS_NONE;
+      cnf_packetsize   = ((sized)) ? cnf_packetsize : MY_CAP_SIZE;
+   };
+
+   // size sweep probes a single path one size at a time
+   if ((cnf_sweep))
+   {
+      if ( ((cnf_multi)) || ((cnf_capacity)) )
+      {
+         my_usage_error("size sweep requires a single target");
+         return(1);
+      };
+      if (cnf_format != MY_FORMAT_TEXT)
+      {
+         my_usage_error("size sweep only supports text output");
+         return(1);
+      };
+      if ( ((cnf_report)) || ((cnf_metrics)) || ((cnf_stamp)) )
+      {
+         my_usage_error("size sweep does not support interval reports, metrics, or STAMP");
+         return(1);
+      };
+      cnf_threads      = 1;
+      cnf_burst        = 1;
+      cnf_timestamping = MY_TS_NONE;
+      cnf_count        = ((cnf_count)) ? cnf_count : MY_SWEEP_COUNT;
+      cnf_sweep_min    = (cnf_sweep_min < sizeof(echoplus_t)) ? sizeof(echoplus_t) : cnf_sweep_min;
+      cnf_sweep_max    = (cnf_sweep_max < cnf_sweep_min)      ? cnf_sweep_min      : cnf_sweep_max;
+      cnf_packetsize   = cnf_sweep_max;
+   };
+
+   // traffic profile replaces the fixed request size
+   if ((cnf_profile_len))
+   {
+      if ( ((sized)) || ((cnf_capacity)) || ((cnf_sweep)) )
+      {
+         my_usage_error("traffic profile cannot be combined with -s, -C, or -z");
+         return(1);
+      };
+      cnf_packetsize_avg = 0;
+      for(idx = 0; (idx < cnf_profile_len); idx++)
+      {
+         hdr                   = ((cnf_stamp)) ? MY_STAMP_SIZE : sizeof(echoplus_t);
+         cnf_profile[idx].min  = (cnf_profile[idx].min < hdr) ? hdr : cnf_profile[idx].min;
+         cnf_profile[idx].max  = (cnf_profile[idx].max < hdr) ? hdr : cnf_profile[idx].max;
+         cnf_packetsize        = (cnf_profile[idx].max > cnf_packetsize) ? cnf_profile[idx].max : cnf_packetsize;
+         cnf_packetsize_avg   += ((cnf_profile[idx].min + cnf_profile[idx].max) * cnf_profile[idx].weight) / 2;
+      };
+      cnf_packetsize_avg /= cnf_profile_weight;
+   };
+
+   // a burst is never longer than the requests of the test
+   if ( ((cnf_count)) && (cnf_burst > cnf_count) )
+      cnf_burst = cnf_count;
+
+   // adjust defaults
+   if (cnf_packetsize < sizeof(echoplus_t))
+      cnf_packetsize = sizeof(echoplus_t);
+   if ( ((cnf_stamp)) && (cnf_packetsize < MY_STAMP_SIZE) )
+      cnf_packetsize = MY_STAMP_SIZE;
+   if (!(cnf_profile_len))
+      cnf_packetsize_avg = cnf_packetsize;
+#if defined(PR_SET_TIMERSLACK)
+   // default 50us timer slack would dominate sub-millisecond intervals
+   if (cnf_interval < my_msec2nsec(1ULL))
+      prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+#endif
 
-   // allocate send buffer
+   // allocate request template
    if ((sndbuff = malloc(cnf_packetsize)) == NULL)
    {
       fprintf(stderr, "%s: out of virtual memory\n", prog_name);
-      free(rcvbuff);
       return(1);
    };
    memset(sndbuff, 0, sizeof(echoplus_t));
-   sndbuff->iteration  = htonl(1);
+   memset(&echoplus, 0, sizeof(echoplus));
+   echoplus.iteration = 1;
+   akudp_echoplus_encode(sndbuff->hdr, sizeof(sndbuff->hdr), &echoplus);
    if (cnf_packetsize > sizeof(echoplus_t))
    {
       if ((fd = open("/dev/urandom", O_RDONLY)) == -1)
       {
          fprintf(stderr, "%s: open(/dev/urandom): %s\n", prog_name, strerror(errno));
-         free(rcvbuff);
          free(sndbuff);
          return(1);
       };
@@ -397,15 +1517,24 @@ main(
          fprintf(stderr, "%s: read(): %s\n", prog_name, strerror(errno));
          close(fd);
          free(sndbuff);
-         free(rcvbuff);
          return(1);
       };
       close(fd);
    };
 
+   // create pipes used to wake worker threads and to signal completion
+   if ( (pipe(stop_pipe) == -1) || (pipe(done_pipe) == -1) )
+   {
+      fprintf(stderr, "%s: pipe(): %s\n", prog_name, strerror(errno));
+      free(sndbuff);
+      return(1);
+   };
+   fcntl(stop_pipe[1], F_SETFL, O_NONBLOCK);
+   fcntl(done_pipe[0], F_SETFL, O_NONBLOCK);
+
    // configure signals
    signal(SIGPIPE, SIG_IGN);
-   signal(SIGUSR1, SIG_IGN);
+   signal(SIGUSR1, ( ((cnf_capacity)) || ((cnf_sweep)) ) ? SIG_IGN : my_summary);
    signal(SIGUSR2, SIG_IGN);
    signal(SIGHUP,  my_stop);
    signal(SIGINT,  my_stop);
@@ -413,334 +1542,3982 @@ main(
    signal(SIGALRM, my_stop);
    signal(SIGTERM, my_stop);
 
-   // resolve host
-   if ((s = my_socket(cnf_host, cnf_port, cnf_ai_family)) == -1)
+   // initialize workers
+   if ((workers = calloc(cnf_threads, sizeof(my_worker_t))) == NULL)
    {
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
       free(sndbuff);
-      free(rcvbuff);
       return(1);
    };
+   for(idx = 0; (idx < cnf_threads); idx++)
+      for(pos = 0; (pos < MY_SOCK_MAX); pos++)
+         workers[idx].fds[pos].fd = -1;
 
-   if ((my_loop(s, rcvbuff, sndbuff)))
+   // each worker contributes to every round of the combined reports until
+   // it exits
+   report_interval.workers = cnf_threads;
+   report_summary.workers  = cnf_threads;
+   report_metrics.workers  = cnf_threads;
+   report_interval.state   = calloc(cnf_threads, sizeof(uint8_t));
+   report_summary.state    = calloc(cnf_threads, sizeof(uint8_t));
+   report_metrics.state    = calloc(cnf_threads, sizeof(uint8_t));
+   if ( (!(report_interval.state)) || (!(report_summary.state)) || (!(report_metrics.state)) )
    {
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+      free(report_interval.state);
+      free(report_summary.state);
+      free(report_metrics.state);
+      free(workers);
       free(sndbuff);
-      free(rcvbuff);
-      close(s);
       return(1);
    };
+   clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+   rc = 0;
+   for(idx = 0; ( (idx < cnf_threads) && (!(rc)) ); idx++)
+   {
+      // stagger the schedule of each thread across the interval
+      workers[idx].start_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec
+                              + ((idx * cnf_interval) / (cnf_threads * targets_len));
+      rc = my_worker_init(&workers[idx], sndbuff);
+   };
+
+   if ( (!(cnf_silent)) && (!(rc)) && (cnf_format == MY_FORMAT_TEXT) && (!(cnf_capacity)) && (!(cnf_sweep)) )
+   {
+      if ((cnf_multi))
+         printf("UDPECHO %zu targets: %zu bytes\n", targets_len, cnf_packetsize);
+      else
+      {
+         port = ntohs((targets[0].sa.sa.sa_family == AF_INET6) ? targets[0].sa.sin6.sin6_port : targets[0].sa.sin.sin_port);
+         printf( ((targets[0].sa.sa.sa_family == AF_INET6) ? "UDPECHO %s:%hu ([%s]:%hu): %zu bytes\n" : "UDPECHO %s:%hu (%s:%hu): %zu bytes\n"),
+                 targets[0].host, port, targets[0].addrstr, port, cnf_packetsize);
+      };
+   };
+
+   // structured records report monotonic send and receive times as wall
+   // clock nanoseconds since the epoch
+   if ( (!(rc)) && (cnf_format != MY_FORMAT_TEXT) )
+   {
+      clock_gettime(CLOCK_REALTIME, &real);
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+      clock_offset = (((int64_t)real.tv_sec - (int64_t)now.tv_sec) * 1000000000LL) + (real.tv_nsec - now.tv_nsec);
+      my_record_header();
+   };
+
+   // serve metrics from a separate thread, scrapes read the snapshot
+   // published by the workers
+   metrics_fd = -1;
+   if ( (!(rc)) && ((cnf_metrics)) )
+   {
+      if ((metrics_fd = my_metrics_listen(cnf_metrics)) == -1)
+         rc = 1;
+      else if ((errno = pthread_create(&metrics_thread, NULL, my_metrics_run, &metrics_fd)) != 0)
+      {
+         fprintf(stderr, "%s: pthread_create(): %s\n", prog_name, strerror(errno));
+         close(metrics_fd);
+         metrics_fd = -1;
+         rc         = 1;
+      };
+   };
+
+   // run probes in the main thread, or in worker threads and wait for them
+   if ( (!(rc)) && ((cnf_capacity)) )
+      rc = my_capacity(&targets[0]);
+   else if ( (!(rc)) && ((cnf_sweep)) )
+      rc = my_sweep(&targets[0], sndbuff);
+   else if ( (!(rc)) && (cnf_threads == 1) )
+      rc = my_loop(&workers[0]);
+   else if (!(rc))
+      rc = my_threads();
+
+   // stop metrics endpoint
+   if (metrics_fd != -1)
+   {
+      should_stop = 1;
+      while ( (write(stop_pipe[1], "", 1) == -1) && (errno == EINTR) );
+      pthread_join(metrics_thread, NULL);
+      close(metrics_fd);
+   };
+
+   // merge statistics of all threads and print summary
+   for(idx = 0; ( (idx < cnf_threads) && (!(rc)) && (cnf_burst > 1) ); idx++)
+      for(pos = 0; (pos < targets_len); pos++)
+         my_burst_finish(&workers[idx].stats[pos]);
+   for(idx = 1; ( (idx < cnf_threads) && (!(rc)) ); idx++)
+   {
+      for(pos = 0; (pos < targets_len); pos++)
+         my_stats_merge(&workers[0].stats[pos], &workers[idx].stats[pos]);
+      for(pos = 0; (pos < cnf_profile_len); pos++)
+      {
+         bp = &workers[idx].buckets[pos];
+         if ( ((bp->rcvd)) && ( (!(workers[0].buckets[pos].rcvd)) || (bp->rtt_min < workers[0].buckets[pos].rtt_min) ) )
+            workers[0].buckets[pos].rtt_min = bp->rtt_min;
+         if (bp->rtt_max > workers[0].buckets[pos].rtt_max)
+            workers[0].buckets[pos].rtt_max = bp->rtt_max;
+         workers[0].buckets[pos].rtt_sum += bp->rtt_sum;
+         workers[0].buckets[pos].sent    += bp->sent;
+         workers[0].buckets[pos].rcvd    += bp->rcvd;
+         workers[0].buckets[pos].corrupt += bp->corrupt;
+      };
+   };
+   if ( (!(rc)) && ( (cnf_format != MY_FORMAT_TEXT) || ( (!(cnf_silent)) && (!(cnf_capacity)) && (!(cnf_sweep)) ) ) )
+      my_stats_summary(workers[0].stats);
+   if ( (!(rc)) && ((cnf_profile_len)) && ( (cnf_format != MY_FORMAT_TEXT) || (!(cnf_silent)) ) )
+      my_profile_summary(workers[0].buckets);
 
    // free resources
    free(sndbuff);
-   free(rcvbuff);
-   close(s);
+   for(idx = 0; (idx < cnf_threads); idx++)
+      my_worker_free(&workers[idx]);
+   free(workers);
+   my_stats_free(report_interval.stats);
+   my_stats_free(report_interval.prev);
+   my_stats_free(report_summary.stats);
+   my_stats_free(report_metrics.stats);
+   free(report_interval.state);
+   free(report_summary.state);
+   free(report_metrics.state);
+   my_stats_free(metrics_stats);
+   my_stats_free(metrics_render);
+   free(metrics_text);
+   for(pos = 0; (pos < targets_len); pos++)
+      free(targets[pos].host);
+   free(targets);
+   free(target_hash);
+   close(stop_pipe[0]);
+   close(stop_pipe[1]);
+   close(done_pipe[0]);
+   close(done_pipe[1]);
+
+   if ((rc))
+      return(1);
 
 
    return(0);
 }
 
 
+// close burst of most recent response and record dispersion and loss
+void
+my_burst_finish(
+         my_stats_t *                  st )
+{
+   uint64_t                   expected;
+   uint64_t                   disp;
+
+   if (!(st->burst_rcvd))
+      return;
+
+   // final burst may be short when -c is not a multiple of the burst size
+   expected = (uint64_t)st->seq - ((uint64_t)st->burst_id * cnf_burst);
+   expected = (expected > cnf_burst) ? cnf_burst : expected;
+
+   st->bursts++;
+   if (st->burst_rcvd < expected)
+      st->bursts_lossy++;
+   if ( (st->burst_rcvd > 1) && ((st->burst_first)) && ((st->burst_last)) )
+   {
+      disp             = st->burst_last - st->burst_first;
+      st->disp_min     = ( (!(st->disp_cnt)) || (disp < st->disp_min) ) ? disp : st->disp_min;
+      st->disp_max     = (disp > st->disp_max) ? disp : st->disp_max;
+      st->disp_sum    += disp;
+      st->disp_bytes  += st->burst_bytes;
+      st->disp_cnt++;
+   };
+   st->burst_rcvd = 0;
+
+   return;
+}
+
+
+// record response in burst statistics
+void
+my_burst_update(
+         my_stats_t *                  st,
+         uint32_t                      seq,
+         uint64_t                      rtt,
+         uint64_t                      recv_ns,
+         size_t                        size )
+{
+   uint32_t                   id;
+   uint32_t                   pos;
+
+   id  = (seq - 1) / cnf_burst;
+   pos = (seq - 1) % cnf_burst;
+   st->burst_rtt[pos] += rtt;
+   st->burst_cnt[pos]++;
+
+   // responses reordered into an earlier burst only count by position
+   if ( ((st->burst_rcvd)) && ((int32_t)(id - st->burst_id) < 0) )
+      return;
+   // arrivals are kernel RX timestamps, a response without one voids the
+   // dispersion of its burst
+   if ( (!(st->burst_rcvd)) || (id != st->burst_id) )
+   {
+      my_burst_finish(st);
+      st->burst_id    = id;
+      st->burst_first = recv_ns;
+      st->burst_bytes = 0;
+   } else
+   {
+      st->burst_bytes += size;
+   };
+   if (!(recv_ns))
+      st->burst_first = 0;
+   st->burst_rcvd++;
+   st->burst_last = recv_ns;
+
+   return;
+}
+
+
+// run RFC 9097 style IP capacity test against target
 int
-my_loop(
-         int                           s,
-         echoplus_t *                  rcvbuff,
-         echoplus_t *                  sndbuff )
+my_capacity(
+         my_target_t *                 tgt )
 {
-   uint64_t                pckt_time;
-   uint64_t                pckt_time_adj;
-   uint64_t                epoch_usec;
-   uint64_t                pckt_delay;
-   uint32_t                stats_sent;
-   uint32_t                stats_rcvd;
-   uint64_t                stats_max;
-   uint64_t                stats_max_adj;
-   uint64_t                stats_min;
-   uint64_t                stats_min_adj;
-   uint64_t                stats_avg;
-   uint64_t                stats_avg_adj;
-   struct pollfd           fds[2];
-   struct timespec         ts_sent;
-   struct timespec         start;
-   struct timespec         now;
+   int                        fd;
+   int                        opt;
+   int                        congested;
+   unsigned                   pos;
+   unsigned                   count;
+   unsigned                   rate_idx;
+   unsigned                   impaired;
+   unsigned                   sub;
+   unsigned                   sub_max;
+   unsigned                   quiet;
+   uint32_t                   session;
+   uint32_t                   seq;
+   uint64_t                   hdr;
+   uint64_t                   wire;
+   uint64_t                   backlog;
+   uint64_t                   now_nsec;
+   uint64_t                   start_nsec;
+   uint64_t                   end_nsec;
+   uint64_t                   sub_nsec;
+   uint64_t                   phase_nsec;
+   uint64_t                   due;
+   uint64_t                   phase_bytes;
+   uint64_t                   sub_sent;
+   uint64_t                   sub_rcvd;
+   uint64_t                   sub_rx_bytes;
+   uint64_t                   sub_lost;
+   uint64_t                   sub_drops;
+   uint32_t                   sub_dvar;
+   uint64_t                   offered;
+   uint64_t                   received;
+   uint64_t                   cap_max;
+   uint64_t                   total_sent;
+   uint64_t                   total_rcvd;
+   uint64_t                   total_lost;
+   uint64_t                   total_drops;
+   uint64_t                   unaccounted;
+   uint32_t                   dvar_max;
+   uint32_t                   seq_err;
+   char *                     buff;
+   capacity_load_t *          load;
+   capacity_status_t          status;
+   struct timespec            now;
+   struct pollfd              fds[2];
 
-   // initialize poller data
-   fds[0].fd      = s;
-   fds[0].events  = POLLIN;
-   fds[0].revents = 0;
-   fds[1].fd      = -1;
-   fds[1].events  = 0;
-   fds[1].revents = 0;
-
-   // initialize statistics
-   stats_sent     = 0;
-   stats_rcvd     = 0;
-   stats_min      = 0;
-   stats_min_adj  = 0;
-   stats_max      = 0;
-   stats_max_adj  = 0;
-   stats_avg      = 0;
-   stats_avg_adj  = 0;
-
-   // initialize timers
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   start.tv_sec -= cnf_interval;
-   ts_sent.tv_sec  = start.tv_sec;
-   ts_sent.tv_nsec = start.tv_nsec;
+   if ((fd = my_socket(tgt->sa.sa.sa_family, -1)) == -1)
+      return(1);
+   opt = MY_CAP_SNDBUF;
+   setsockopt(fd, SOL_SOCKET, SO_SNDBUF, (void *)&opt, sizeof(int));
+   if ((buff = calloc(MY_BURST_MAX, cnf_packetsize)) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+      close(fd);
+      return(1);
+   };
 
-   // master loop
-   while (!(should_stop))
+   // IP and UDP header bytes count toward IP-layer capacity
+   hdr  = (tgt->sa.sa.sa_family == AF_INET6) ? 48 : 28;
+   wire = cnf_packetsize + hdr;
+
+   clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+   session = htonl((uint32_t)now.tv_nsec ^ (uint32_t)getpid());
+   for(pos = 0; (pos < MY_BURST_MAX); pos++)
+   {
+      load          = (capacity_load_t *)&buff[pos * cnf_packetsize];
+      load->magic   = htonl(MY_CAP_LOAD_MAGIC);
+      load->session = session;
+   };
+
+   fds[0].fd     = fd;
+   fds[0].events = POLLIN;
+   fds[1].fd     = stop_pipe[0];
+   fds[1].events = POLLIN;
+
+   sub_max     = cnf_sub_intervals;
+   start_nsec  = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
+   end_nsec    = start_nsec + (sub_max * cnf_interval);
+   sub_nsec    = start_nsec + cnf_interval;
+   phase_nsec  = start_nsec;
+   phase_bytes = 0;
+   rate_idx    = 0;
+   impaired    = 0;
+   congested   = 0;
+   seq         = 0;
+   sub         = 1;
+   cap_max     = 0;
+   dvar_max    = 0;
+   total_sent  = 0;
+   total_rcvd  = 0;
+   total_lost  = 0;
+   total_drops = 0;
+   sub_sent    = 0;
+   sub_rcvd    = 0;
+   sub_rx_bytes= 0;
+   sub_lost    = 0;
+   sub_drops   = 0;
+   sub_dvar    = 0;
+
+   if (!(cnf_silent))
+      printf("UDPECHO capacity %s (%s): %zu bytes, %u sub-intervals\n", tgt->host, tgt->addrstr, cnf_packetsize, sub_max);
+
+   while ( (!(should_stop)) && (sub <= sub_max) )
    {
-      // calculate loop epoch
       clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-      epoch_usec  = my_sec2usec((uint64_t)now.tv_sec)   + my_nsec2usec((uint64_t)now.tv_nsec);
-      epoch_usec -= my_sec2usec((uint64_t)start.tv_sec) + my_nsec2usec((uint64_t)start.tv_nsec);
+      now_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
 
-      // trigger stop
-      if ( ((cnf_count)) && (stats_sent >= cnf_count) )
+      // report sub-interval using feedback received during it
+      if (now_nsec >= sub_nsec)
       {
-         if (stats_rcvd == stats_sent)
-         {
-            should_stop = 1;
-            continue;
-         };
-         if (my_timespec_delta(&now, &ts_sent, NULL) > my_sec2usec((uint64_t)cnf_timeout))
-         {
-            should_stop = 1;
-            continue;
-         };
+         offered  = (uint64_t)(((double)(sub_sent * wire) * 8e9) / (double)cnf_interval);
+         received = (uint64_t)(((double)(sub_rx_bytes + (sub_rcvd * hdr)) * 8e9) / (double)cnf_interval);
+         cap_max  = (received > cap_max) ? received : cap_max;
+         if (!(cnf_silent))
+            printf("%us: offered %" PRIu64 ".%" PRIu64 " Mbit/s, received %" PRIu64 ".%" PRIu64 " Mbit/s, %" PRIu64 " lost (%" PRIu64 " by receiver), delay variation %" PRIu32 ".%" PRIu32 " ms\n",
+                   sub,
+                   offered / 1000000,  (offered / 100000) % 10,
+                   received / 1000000, (received / 100000) % 10,
+                   sub_lost, sub_drops,
+                   my_usec2msec(sub_dvar), my_usec2msec_tenths(sub_dvar)
+            );
+         fflush(stdout);
+         sub_sent     = 0;
+         sub_rcvd     = 0;
+         sub_rx_bytes = 0;
+         sub_lost     = 0;
+         sub_drops    = 0;
+         sub_dvar     = 0;
+         sub_nsec    += cnf_interval;
+         sub++;
+         continue;
       };
 
-      // send UDP echo request
-      if ((stats_sent < (epoch_usec/my_sec2usec(cnf_interval))) && ((stats_sent < cnf_count) || (!(cnf_count))) )
+      // send load due at current rate, the backlog is capped so a stall is
+      // not followed by a burst above the offered rate
+      due     = (uint64_t)(((double)my_capacity_rate(rate_idx) / 8e9) * (double)(now_nsec - phase_nsec));
+      backlog = (uint64_t)(((double)my_capacity_rate(rate_idx) / 8e9) * (double)MY_CAP_CATCHUP);
+      if (due > (phase_bytes + backlog))
+         phase_bytes = due - backlog;
+      while ( (phase_bytes < due) && (now_nsec < end_nsec) )
       {
-         stats_sent++;
-         sndbuff->req_sn            = htonl((uint32_t)stats_sent);
-         sndbuff->send_time.tv_sec  = now.tv_sec;
-         sndbuff->send_time.tv_nsec = now.tv_nsec;
-         ts_sent.tv_sec             = now.tv_sec;
-         ts_sent.tv_nsec            = now.tv_nsec;
-         send(s, sndbuff, cnf_packetsize, 0);
+         count = (unsigned)((due - phase_bytes + wire - 1) / wire);
+         count = (count > MY_BURST_MAX) ? MY_BURST_MAX : count;
+         for(pos = 0; (pos < count); pos++)
+         {
+            load          = (capacity_load_t *)&buff[pos * cnf_packetsize];
+            load->seq     = htonl(seq + pos);
+            load->tx_sec  = htonl((uint32_t)now.tv_sec);
+            load->tx_nsec = htonl((uint32_t)now.tv_nsec);
+         };
+         if ((pos = my_send(fd, tgt, buff, NULL, count)) == 0)
+            break;
+         seq         += (uint32_t)pos;
+         phase_bytes += (uint64_t)pos * wire;
+         sub_sent    += (uint64_t)pos;
+         total_sent  += (uint64_t)pos;
+         if (pos < count)
+            break;
       };
 
-      // receive UDP echo response
-      if (poll(fds, 1, 0) <= 0)
-      {
-         usleep(50);
+      // wait for feedback until next packet is due
+      due      = phase_nsec + (uint64_t)(((double)(phase_bytes + wire) * 8e9) / (double)my_capacity_rate(rate_idx));
+      due      = (due < sub_nsec) ? due : sub_nsec;
+      if (my_poll(fds, 2, (due > now_nsec) ? (due - now_nsec) : 0) < 1)
          continue;
-      };
-
-      // reads packet
-      if (recv(s, rcvbuff, cnf_packetsize, 0) != (ssize_t)cnf_packetsize)
+      if (!(fds[0].revents & POLLIN))
          continue;
-      rcvbuff->req_sn      = ntohl(rcvbuff->req_sn);
-      rcvbuff->res_sn      = ntohl(rcvbuff->res_sn);
-      rcvbuff->recv_time   = ntohl(rcvbuff->recv_time);
-      rcvbuff->reply_time  = ntohl(rcvbuff->reply_time);
-      rcvbuff->failures    = ntohl(rcvbuff->failures);
-      rcvbuff->iteration   = ntohl(1);
-      if ((cnf_debug))
+
+      // apply status feedback
+      while(recv(fd, &status, sizeof(status), 0) == (ssize_t)sizeof(status))
       {
-         printf("   packet: GenSN/REspSN:    %08" PRIx32 " %08" PRIx32 "\n", rcvbuff->req_sn, rcvbuff->res_sn);
-         printf("           Recv/Reply Time: %08" PRIx32 " %08" PRIx32 "\n", rcvbuff->recv_time, rcvbuff->reply_time);
-         printf("           Failures:        %08" PRIx32 "\n",               rcvbuff->failures);
-         printf("           Iteration:       %08" PRIx32 "\n",               rcvbuff->iteration);
+         if ( (ntohl(status.magic) != MY_CAP_STATUS_MAGIC) || (status.session != session) )
+            continue;
+         seq_err       = ntohl(status.seq_gap) + ntohl(status.seq_ooo);
+         sub_rcvd     += ntohl(status.rx_pkts);
+         sub_rx_bytes += ntohl(status.rx_bytes);
+         sub_lost     += (ntohl(status.seq_gap) > ntohl(status.seq_ooo)) ? (ntohl(status.seq_gap) - ntohl(status.seq_ooo)) : 0;
+         sub_dvar      = (ntohl(status.dvar_max) > sub_dvar) ? ntohl(status.dvar_max) : sub_dvar;
+         dvar_max      = (sub_dvar > dvar_max) ? sub_dvar : dvar_max;
+         total_rcvd   += ntohl(status.rx_pkts);
+         total_lost   += (ntohl(status.seq_gap) > ntohl(status.seq_ooo)) ? (ntohl(status.seq_gap) - ntohl(status.seq_ooo)) : 0;
+         sub_drops    += ntohl(status.rx_drops);
+         total_drops  += ntohl(status.rx_drops);
+         pos           = my_capacity_adjust(rate_idx, seq_err, ntohl(status.dvar_max), &impaired, &congested);
+         if (pos == rate_idx)
+            continue;
+         // restart pacing at the new rate
+         rate_idx    = pos;
+         phase_nsec  = now_nsec;
+         phase_bytes = 0;
       };
-      stats_rcvd++;
+   };
 
-      // performs stats on packet
+   // drain feedback still in flight after the last send until the receiver
+   // accounts for every packet, reports no new packets, or the timeout ends
+   clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+   end_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec + my_sec2nsec((uint64_t)cnf_timeout);
+   quiet    = 0;
+   while ( (!(should_stop)) && ((total_rcvd + total_lost) < total_sent) && (quiet < MY_CAP_QUIET) )
+   {
       clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-      pckt_time      = my_timespec_delta(&now, &rcvbuff->send_time, NULL);
-      pckt_delay     = (rcvbuff->reply_time > rcvbuff->recv_time)
-                     ? (rcvbuff->reply_time - rcvbuff->recv_time)
-                     : (((uint32_t)-1) - rcvbuff->recv_time) + rcvbuff->reply_time + 1;
-      pckt_time_adj  = (pckt_time > pckt_delay)
-                     ? (pckt_time - pckt_delay)
-                     : pckt_time;
-      stats_avg      += pckt_time;
-      stats_avg_adj  += pckt_time_adj;
-      stats_min      = ( (!(stats_min)) || (pckt_time < stats_min) ) ? pckt_time : stats_min;
-      stats_max      = ( (!(stats_max)) || (pckt_time > stats_max) ) ? pckt_time : stats_max;
-      stats_min_adj  = ( (!(stats_min_adj)) || (pckt_time_adj < stats_min_adj) ) ? pckt_time_adj : stats_min_adj;
-      stats_max_adj  = ( (!(stats_max_adj)) || (pckt_time_adj > stats_max_adj) ) ? pckt_time_adj : stats_max_adj;
-
-      // print packet
-      if (cnf_echoplus == -1)
-         cnf_echoplus = (((rcvbuff->res_sn)) || ((rcvbuff->recv_time)) || ((rcvbuff->reply_time))) ? 1 : 0;
-      if (!(cnf_echoplus))
-      {
-         printf("udpecho_seq=%u time=%" PRIu64 ".%" PRIu64 " ms\n",
-               rcvbuff->req_sn,
-               my_usec2msec(pckt_time), ((pckt_time%1000)/100)
-         );
+      now_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
+      if (now_nsec >= end_nsec)
+         break;
+      if (my_poll(fds, 2, end_nsec - now_nsec) < 1)
          continue;
+      if (!(fds[0].revents & POLLIN))
+         continue;
+      while(recv(fd, &status, sizeof(status), 0) == (ssize_t)sizeof(status))
+      {
+         if ( (ntohl(status.magic) != MY_CAP_STATUS_MAGIC) || (status.session != session) )
+            continue;
+         quiet         = ((status.rx_pkts)) ? 0 : (quiet + 1);
+         dvar_max      = (ntohl(status.dvar_max) > dvar_max) ? ntohl(status.dvar_max) : dvar_max;
+         total_rcvd   += ntohl(status.rx_pkts);
+         total_lost   += (ntohl(status.seq_gap) > ntohl(status.seq_ooo)) ? (ntohl(status.seq_gap) - ntohl(status.seq_ooo)) : 0;
+         total_drops  += ntohl(status.rx_drops);
       };
-      printf("udpecho_seq=%u failures=%" PRIu32 " time=%" PRIu64 ".%" PRIu64 " ms delay=%" PRIu64 ".%" PRIu64 " ms adj_time=%" PRIu64 ".%" PRIu64 " ms\n",
-               rcvbuff->req_sn,
-               rcvbuff->failures,
-               my_usec2msec(pckt_time),     my_usec2msec_tenths(pckt_time),
-               my_usec2msec(pckt_delay),    my_usec2msec_tenths(pckt_delay),
-               my_usec2msec(pckt_time_adj), my_usec2msec_tenths(pckt_time_adj)
-      );
    };
+   unaccounted = ((total_rcvd + total_lost) < total_sent) ? (total_sent - total_rcvd - total_lost) : 0;
 
    if (!(cnf_silent))
    {
       printf("\n");
-      printf("--- %s udpecho statistics ---\n", cnf_host);
-      if ((stats_sent))
-      {
-         printf("%i packets transmitted, %i packets received, %i.%i%% packet loss\n",
-                stats_sent,
-                stats_rcvd,
-                ((stats_sent - stats_rcvd) * 100) / stats_sent,
-                (((stats_sent - stats_rcvd) * 1000) / stats_sent) % 10
-         );
-      };
-      if ((stats_rcvd))
-      {
-         printf("round-trip min/avg/max = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms\n",
-                my_usec2msec(stats_min),            my_usec2msec_tenths(stats_min),
-                my_usec2msec(stats_avg/stats_rcvd), my_usec2msec_tenths(stats_avg/stats_rcvd),
-                my_usec2msec(stats_max),            my_usec2msec_tenths(stats_max)
-         );
-         if ((cnf_echoplus))
-         {
-            printf("adjusted round-trip min/avg/max = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms\n",
-                   my_usec2msec(stats_min_adj),            my_usec2msec_tenths(stats_min_adj),
-                   my_usec2msec(stats_avg_adj/stats_rcvd), my_usec2msec_tenths(stats_avg_adj/stats_rcvd),
-                   my_usec2msec(stats_max_adj),            my_usec2msec_tenths(stats_max_adj)
-            );
-         };
-      };
+      printf("--- %s capacity statistics ---\n", tgt->host);
+      printf("%" PRIu64 " packets transmitted, %" PRIu64 " packets received, %" PRIu64 " lost", total_sent, total_rcvd, total_lost);
+      if ((unaccounted))
+         printf(", %" PRIu64 " unaccounted", unaccounted);
+      printf("\n");
+      printf("maximum IP-layer capacity = %" PRIu64 ".%" PRIu64 " Mbit/s, delay variation max = %" PRIu32 ".%" PRIu32 " ms\n",
+             cap_max / 1000000, (cap_max / 100000) % 10,
+             my_usec2msec(dvar_max), my_usec2msec_tenths(dvar_max)
+      );
+      if ((total_drops))
+         printf("receiver saturated, %" PRIu64 " packets dropped by the server receive buffer, capacity may be limited by the server\n", total_drops);
    };
 
+   free(buff);
+   close(fd);
+
    return(0);
 }
 
 
-int
-my_socket(
-         const char *                  host,
-         const char *                  service,
-         int                           family )
+// adjust capacity load rate from status feedback
+unsigned
+my_capacity_adjust(
+         unsigned                      idx,
+         uint32_t                      seq_err,
+         uint32_t                      dvar,
+         unsigned *                    impaired,
+         int *                         congested )
 {
-   int                        rc;
-   int                        s;
-   unsigned short             port;
-   socklen_t                  socklen;
-   struct addrinfo *          res;
-   struct addrinfo *          info;
-   struct addrinfo            hints;
-   union my_sa                sa;
-   char                       addrstr[INET6_ADDRSTRLEN];
-   char                       logmsg[256];
-
-   memset(&hints, 0, sizeof(struct addrinfo));
-   hints.ai_flags     = AI_ADDRCONFIG | AI_V4MAPPED | AI_ALL;
-   hints.ai_family    = family;
-   hints.ai_socktype  = SOCK_DGRAM;
-   hints.ai_protocol  = IPPROTO_UDP;
-
-   // resolve host
-   memset(&sa,     0, sizeof(sa));
-   memset(addrstr, 0, sizeof(addrstr));
-   socklen = 0;
-   if ((rc = getaddrinfo(host, service, &hints, &res)) != 0)
+   // no impairment, increase quickly until congestion is first confirmed
+   if ( (seq_err <= MY_CAP_SEQ_ERR_THRESH) && (dvar < MY_CAP_LOW_THRESH) )
    {
-      fprintf(stderr, "%s: getaddrinfo(): %s\n", prog_name, gai_strerror(rc));
-      return(-1);
+      *impaired = 0;
+      idx += (!(*congested)) ? MY_CAP_HIGH_SPEED_DELTA : 1;
+      return((idx > MY_CAP_RATE_MAX) ? MY_CAP_RATE_MAX : idx);
    };
-   // use first IPv6 address
-   for(info = res; ((info != NULL) && (!(socklen)) ); info = info->ai_next)
+
+   // between thresholds, hold rate
+   if ( (seq_err <= MY_CAP_SEQ_ERR_THRESH) && (dvar <= MY_CAP_UPPER_THRESH) )
    {
-      if (info->ai_addr->sa_family != AF_INET6)
-         continue;
-      socklen = info->ai_addrlen;
-      memcpy(&sa, info->ai_addr, socklen);
-      inet_ntop(AF_INET6, &sa.sin6.sin6_addr, addrstr, sizeof(addrstr));
-      port = ntohs(sa.sin6.sin6_port);
-      snprintf(logmsg, sizeof(logmsg), "UDPECHO %s:%hu ([%s]:%hu): %zu bytes\n", cnf_host, port, addrstr, port, cnf_packetsize);
+      *impaired = 0;
+      return(idx);
    };
-   // use first IPv4 address, if no IPv6 address
-   for(info = res; ((info != NULL) && (!(socklen)) ); info = info->ai_next)
+
+   // impaired, congestion is confirmed by consecutive impaired feedback and
+   // the first confirmation backs off by the rows of the RFC 9097 example
+   (*impaired)++;
+   if ( (*impaired >= MY_CAP_SLOW_ADJ_THRESH) && (!(*congested)) )
    {
-      if (info->ai_addr->sa_family != AF_INET)
-         continue;
-      socklen = res->ai_addrlen;
-      memcpy(&sa.sa, res->ai_addr, socklen);
-      inet_ntop(AF_INET, &sa.sin.sin_addr, addrstr, sizeof(addrstr));
-      port = ntohs(sa.sin.sin_port);
-      snprintf(logmsg, sizeof(logmsg), "UDPECHO %s:%hu (%s:%hu): %zu bytes\n", cnf_host, port, addrstr, port, cnf_packetsize);
+      *congested = 1;
+      *impaired  = 0;
+      return((idx > MY_CAP_BACKOFF) ? (idx - MY_CAP_BACKOFF) : 0);
    };
-   freeaddrinfo(res);
-   if (!(socklen))
+   return(((idx)) ? (idx - 1) : 0);
+}
+
+
+// IP capacity load rate of rate table index in bits per second
+uint64_t
+my_capacity_rate(
+         unsigned                      idx )
+{
+   // 0.5 Mbit/s, then 1 Mbit/s steps to 1 Gbit/s, then 100 Mbit/s steps
+   if (!(idx))
+      return(500000ULL);
+   if (idx <= 1000)
+      return((uint64_t)idx * 1000000ULL);
+   return(1000000000ULL + ((uint64_t)(idx - 1000) * 100000000ULL));
+}
+
+
+// estimated server clock offset relative to base at client time in usec
+int64_t
+my_clock_offset(
+         const my_stats_t *            st,
+         int64_t                       t )
+{
+   double                     n;
+   double                     slope;
+   double                     intercept;
+
+   // until the drift is known the offset is the mean of recent samples
+   if (!(st->clk_n))
+      return(st->clk_best_offset);
+   if ( (st->clk_n < MY_CLOCK_DRIFT_MIN) || (st->clk_span < MY_CLOCK_DRIFT_SPAN) )
+      return((int64_t)(st->clk_so / (double)st->clk_n));
+
+   n         = (double)st->clk_n;
+   slope     = ((n * st->clk_sto) - (st->clk_st * st->clk_so)) / ((n * st->clk_stt) - (st->clk_st * st->clk_st));
+   intercept = (st->clk_so - (slope * st->clk_st)) / n;
+
+   return((int64_t)(intercept + (slope * (double)(t - st->clk_t0))));
+}
+
+// estimated server clock drift in parts per million, returns -1 until
+// enough samples span enough time
+int
+my_clock_drift(
+         const my_stats_t *            st,
+         double *                      driftp )
+{
+   double                     n;
+
+   *driftp = 0.0;
+   if ( (st->clk_n < MY_CLOCK_DRIFT_MIN) || (st->clk_span < MY_CLOCK_DRIFT_SPAN) )
+      return(-1);
+   n       = (double)st->clk_n;
+   *driftp = (((n * st->clk_sto) - (st->clk_st * st->clk_so)) / ((n * st->clk_stt) - (st->clk_st * st->clk_st))) * 1000000.0;
+   return(0);
+}
+
+
+// update server clock estimate from echo plus timestamps and estimate
+// one-way delays of response
+void
+my_clock_update(
+         my_stats_t *                  st,
+         int64_t                       t1,
+         uint32_t                      t2,
+         int64_t                       delay,
+         int64_t *                     owd_fwd,
+         int64_t *                     owd_rev )
+{
+   int64_t                    raw;
+   int64_t                    offset;
+   uint32_t                   pos;
+   uint32_t                   idx;
+   double                     t;
+
+   // the server timestamp is 32 bits of microseconds of an unknown epoch,
+   // offsets are kept relative to the first estimate so the arithmetic
+   // stays within 32 bits regardless of the server epoch
+   if (!(st->clk_valid))
+   {
+      st->clk_base  = (t2 - (uint32_t)t1) - (uint32_t)(delay / 2);
+      st->clk_t0    = t1;
+      st->clk_valid = 1;
+   };
+   raw    = (int32_t)((t2 - (uint32_t)t1) - st->clk_base);
+   offset = raw - (delay / 2);
+
+   // NTP style clock filter, the sample with the least delay of each window
+   // of at least eight probes and one second has the least queueing and
+   // therefore the most symmetric delays
+   if (!(st->clk_cnt))
+      st->clk_start = t1;
+   if ( (!(st->clk_cnt)) || (delay < st->clk_best_delay) )
+   {
+      st->clk_best_delay  = delay;
+      st->clk_best_offset = offset;
+      st->clk_best_time   = t1;
+   };
+   if ( ((++st->clk_cnt) >= MY_CLOCK_FILTER) && ((t1 - st->clk_start) >= MY_CLOCK_PERIOD) )
+   {
+      // drift is the slope of a least squares fit of the recent filtered
+      // offsets, so a changing drift is followed instead of averaged
+      idx                = st->clk_total % MY_CLOCK_WINDOW;
+      st->clk_win_t[idx] = st->clk_best_time - st->clk_t0;
+      st->clk_win_o[idx] = st->clk_best_offset;
+      st->clk_total++;
+      st->clk_n          = (st->clk_total < MY_CLOCK_WINDOW) ? st->clk_total : MY_CLOCK_WINDOW;
+      st->clk_span       = st->clk_win_t[idx] - st->clk_win_t[(st->clk_total - st->clk_n) % MY_CLOCK_WINDOW];
+      st->clk_st         = 0.0;
+      st->clk_so         = 0.0;
+      st->clk_stt        = 0.0;
+      st->clk_sto        = 0.0;
+      for(pos = 0; (pos < st->clk_n); pos++)
+      {
+         t            = (double)st->clk_win_t[pos];
+         st->clk_st  += t;
+         st->clk_so  += (double)st->clk_win_o[pos];
+         st->clk_stt += t * t;
+         st->clk_sto += t * (double)st->clk_win_o[pos];
+      };
+      st->clk_cnt        = 0;
+   };
+
+   // one-way delays are measured against the estimated offset, assuming the
+   // least delayed probes were symmetric
+   *owd_fwd = raw - my_clock_offset(st, t1);
+   *owd_rev = delay - *owd_fwd;
+
+   return;
+}
+
+
+// send requests and process responses of a worker
+int
+my_loop(
+         my_worker_t *                 w )
+{
+   int                     pos;
+   int                     done;
+   int                     sock;
+   unsigned                batch;
+   unsigned                count;
+   unsigned                sent;
+   unsigned                n;
+   uint64_t                now_nsec;
+   uint64_t                start_nsec;
+   uint64_t                sent_nsec;
+   uint64_t                next_nsec;
+   uint64_t                deadline;
+   uint64_t                report_nsec;
+   uint64_t                total_count;
+   uint64_t                total_issued;
+   uint64_t                total_sent;
+   uint64_t                total_rcvd;
+   uint64_t                slots;
+   uint64_t                report_sent;
+   uint64_t                report_rcvd;
+   uint64_t                report_loss[3];
+   uint64_t                loss[3];
+   size_t                  idx;
+   my_target_t *           tgt;
+   my_stats_t *            st;
+   my_txmap_t *            map;
+   unsigned                bucket;
+   akudp_stamp_t           stamp_req;
+   akudp_echoplus_t        echoplus_req;
+   struct timespec         now;
+   struct pollfd *         fds;
+   echoplus_t *            sndbuff;
+   my_stats_t *            stats;
+
+   fds     = w->fds;
+   stats   = w->stats;
+   memset(&echoplus_req, 0, sizeof(echoplus_req));
+   echoplus_req.iteration = 1;
+
+   // initialize poller data
+   for(pos = 0; (pos <= MY_SOCK_MAX); pos++)
+   {
+      fds[pos].events  = POLLIN;
+      fds[pos].revents = 0;
+   };
+
+   total_count  = (uint64_t)cnf_count * targets_len;
+   total_issued = 0;
+   total_sent   = 0;
+   total_rcvd  = 0;
+   slots       = 0;
+   done        = 0;
+
+   // initialize timers, first request is sent at the worker's start time
+   start_nsec  = w->start_nsec;
+   sent_nsec   = start_nsec;
+   next_nsec   = start_nsec;
+   report_nsec = start_nsec + my_sec2nsec(1ULL);
+   report_sent = 0;
+   report_rcvd = 0;
+   memset(report_loss, 0, sizeof(report_loss));
+
+   // interval reports of all workers share the boundaries of the first
+   w->report_nsec  = workers[0].start_nsec + cnf_report;
+   w->metrics_nsec = workers[0].start_nsec + my_sec2nsec(MY_METRICS_PERIOD);
+
+   // master loop
+   while ( (!(should_stop)) && (!(done)) )
+   {
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+      now_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
+
+      // trigger stop
+      if ( ((cnf_count)) && (total_issued >= total_count) )
+      {
+         if (total_rcvd == total_sent)
+         {
+            done = 1;
+            continue;
+         };
+         if ((now_nsec - sent_nsec) > my_sec2nsec((uint64_t)cnf_timeout))
+         {
+            done = 1;
+            continue;
+         };
+      };
+
+      // print throughput of previous second, the reporting thread prints
+      // the combined throughput when more than one worker is running
+      if ( ((cnf_throughput)) && (cnf_threads == 1) && (now_nsec >= report_nsec) )
+      {
+         for(pos = 0; (pos < 3); pos++)
+         {
+            loss[pos]         = (w->total_loss[pos] > report_loss[pos]) ? (w->total_loss[pos] - report_loss[pos]) : 0;
+            report_loss[pos]  = w->total_loss[pos];
+         };
+         my_throughput(my_nsec2sec((report_nsec - start_nsec)), total_sent - report_sent, total_rcvd - report_rcvd, loss);
+         report_sent  = total_sent;
+         report_rcvd  = total_rcvd;
+         report_nsec += my_sec2nsec(1ULL);
+      };
+
+      // contribute to interval reports and requested summaries
+      if ( ((cnf_report)) && (now_nsec >= w->report_nsec) )
+      {
+         my_report(w, &report_interval);
+         w->report_nsec += cnf_report;
+      };
+      if ( ((cnf_metrics)) && (now_nsec >= w->metrics_nsec) )
+      {
+         my_report(w, &report_metrics);
+         w->metrics_nsec += my_sec2nsec(MY_METRICS_PERIOD);
+      };
+      if (w->summary_gen != __atomic_load_n(&summary_gen, __ATOMIC_RELAXED))
+      {
+         w->summary_gen = __atomic_load_n(&summary_gen, __ATOMIC_RELAXED);
+         my_report(w, &report_summary);
+      };
+
+      // send UDP echo requests whose deadlines have passed, schedule is
+      // anchored to the start time so late wakeups do not accumulate drift.
+      // Each target is sent one burst per interval with the bursts to
+      // individual targets spread evenly across the interval.
+      for(batch = 0; ( (batch < MY_BATCH_MAX) && (now_nsec >= next_nsec) && ((total_issued < total_count) || (!(cnf_count))) ); batch++)
+      {
+         idx   = (size_t)(slots % targets_len);
+         tgt   = &targets[idx];
+         st    = &stats[idx];
+         count = ( ((cnf_count)) && ((cnf_count - st->seq) < cnf_burst) ) ? (cnf_count - st->seq) : cnf_burst;
+         slots++;
+         st->bursts_sent++;
+         next_nsec = start_nsec
+                   + ((slots / targets_len) * cnf_interval)
+                   + (((slots % targets_len) * cnf_interval) / targets_len);
+         sent_nsec = now_nsec;
+         for(n = 0; (n < count); n++)
+         {
+            st->seq++;
+            if ((st->ktx))
+               st->ktx[st->seq % MY_SEQ_WINDOW] = 0;
+            if ((st->stx))
+               st->stx[st->seq % MY_SEQ_WINDOW] = (int64_t)my_sec2nsec((uint64_t)now.tv_sec) + now.tv_nsec;
+            sndbuff                    = (echoplus_t *)&((char *)w->sndbuff)[n * cnf_packetsize];
+            w->sndlen[n]               = my_profile_size(tgt, st->seq, &bucket);
+            echoplus_req.req_sn        = st->seq;
+            akudp_echoplus_encode(sndbuff->hdr, sizeof(sndbuff->hdr), &echoplus_req);
+            sndbuff->send_time.tv_sec  = now.tv_sec;
+            sndbuff->send_time.tv_nsec = now.tv_nsec;
+            if ((cnf_stamp))
+            {
+               struct timespec ts_real;
+               clock_gettime(CLOCK_REALTIME, &ts_real);
+               memset(&stamp_req, 0, sizeof(stamp_req));
+               stamp_req.seq     = st->seq;
+               stamp_req.errest  = my_stamp_errest(w, ts_real.tv_sec);
+               akudp_timespec2ntp(&ts_real, &stamp_req.ts_sec, &stamp_req.ts_frac);
+               akudp_stamp_encode(sndbuff, MY_STAMP_SIZE, &stamp_req);
+            };
+         };
+         total_issued += count;
+         sock = (int)(tgt->cls * 2) + ((tgt->sa.sa.sa_family == AF_INET6) ? 1 : 0);
+         sent = my_send(fds[sock].fd, tgt, (char *)w->sndbuff, w->sndlen, count);
+
+         // requests refused by the kernel never left and are not counted
+         // as lost, their sequence numbers are skipped
+         st->sent   += sent;
+         total_sent += sent;
+         __atomic_store_n(&w->total_sent, total_sent, __ATOMIC_RELAXED);
+         for(n = 0; (n < sent); n++)
+         {
+            my_profile_size(tgt, st->seq - count + 1 + n, &bucket);
+            w->buckets[bucket].sent++;
+         };
+
+         // map OPT_ID of each datagram to its sequence for TX timestamps
+         for(n = 0; ( ((w->tx_map[sock])) && (n < sent) ); n++)
+         {
+            map         = &w->tx_map[sock][w->tx_id[sock] % MY_TX_RING];
+            map->id     = w->tx_id[sock]++;
+            map->target = (uint32_t)idx;
+            map->seq    = st->seq - count + 1 + n;
+         };
+         clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+         now_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
+      };
+
+      // sleep until a response arrives or the next deadline
+      if ( ((cnf_count)) && (total_issued >= total_count) )
+         deadline = sent_nsec + my_sec2nsec((uint64_t)cnf_timeout) + 1;
+      else
+         deadline = next_nsec;
+      if ( ((cnf_throughput)) && (cnf_threads == 1) && (report_nsec < deadline) )
+         deadline = report_nsec;
+      if ( ((cnf_report)) && (w->report_nsec < deadline) )
+         deadline = w->report_nsec;
+      if ( ((cnf_metrics)) && (w->metrics_nsec < deadline) )
+         deadline = w->metrics_nsec;
+      if (my_poll(fds, MY_SOCK_MAX+1, (deadline > now_nsec) ? (deadline - now_nsec) : 0) <= 0)
+         continue;
+
+      // drain pending TX timestamps before the responses that use them
+      for(pos = 0; (pos < MY_SOCK_MAX); pos++)
+      {
+         if ((fds[pos].revents & POLLERR))
+            my_txstamp(w, pos);
+         if ((fds[pos].revents & (POLLIN|POLLERR)))
+            total_rcvd += my_recv(w, fds[pos].fd, (unsigned)pos / 2);
+      };
+      __atomic_store_n(&w->total_rcvd, total_rcvd, __ATOMIC_RELAXED);
+      my_record_flush(w);
+   };
+
+   return(0);
+}
+
+
+// attribute lost requests to direction using echo plus counters
+void
+my_loss_update(
+         my_worker_t *                 w,
+         my_stats_t *                  st,
+         const akudp_echoplus_t *      msg,
+         int                           status )
+{
+   uint32_t                   requests;
+   uint32_t                   replies;
+   uint32_t                   dropped;
+   uint32_t                   loss[3];
+   int                        pos;
+
+   // first response establishes baseline
+   if (!(st->loss_valid))
+   {
+      st->loss_req_sn   = msg->req_sn;
+      st->loss_res_sn   = msg->res_sn;
+      st->loss_failures = msg->failures;
+      st->loss_valid    = 1;
+      return;
+   };
+
+   // a reordered response was previously attributed to the direction in
+   // which it was delayed, reflected before the last in order response
+   // means it was held on the return path
+   if (status == MY_SEQ_REORDERED)
+   {
+      if ((st->loss_shared))
+         return;
+      pos = ((int32_t)(msg->res_sn - st->loss_res_sn) < 0) ? MY_LOSS_RETURN : MY_LOSS_FORWARD;
+      if (!(st->loss[pos]))
+         return;
+      st->loss[pos]--;
+      __atomic_fetch_sub(&w->total_loss[pos], 1, __ATOMIC_RELAXED);
+      if (pos == MY_LOSS_FORWARD)
+         st->loss_res_sn = msg->res_sn;
+      return;
+   };
+
+   requests          = msg->req_sn   - st->loss_req_sn;
+   replies           = msg->res_sn   - st->loss_res_sn;
+   dropped           = msg->failures - st->loss_failures;
+   st->loss_req_sn   = msg->req_sn;
+   st->loss_res_sn   = msg->res_sn;
+   st->loss_failures = msg->failures;
+
+   // reflector counters advanced by more than this client sent, counters
+   // are shared with other clients and cannot be attributed
+   if ( ((st->loss_shared)) || (((uint64_t)replies + dropped) > requests) || (!(replies)) )
+   {
+      st->loss_shared = 1;
+      return;
+   };
+
+   loss[MY_LOSS_FORWARD]   = requests - replies - dropped;
+   loss[MY_LOSS_RETURN]    = replies - 1;
+   loss[MY_LOSS_REFLECTOR] = dropped;
+   for(pos = 0; (pos < 3); pos++)
+   {
+      st->loss[pos] += loss[pos];
+      if ((loss[pos]))
+         __atomic_fetch_add(&w->total_loss[pos], loss[pos], __ATOMIC_RELAXED);
+   };
+
+   return;
+}
+
+
+// parse traffic profile into request size distribution
+int
+my_profile_parse(
+         char *                        spec )
+{
+   size_t                     min;
+   size_t                     max;
+   size_t                     width;
+   unsigned long              weight;
+   unsigned                   pos;
+   char *                     tok;
+   char *                     ptr;
+   char *                     end;
+   char                       imix[] = "40:7,548:4,1472:1";
+
+   // simple IMIX of 68, 576, and 1500 byte IPv4 packets
+   if (!(strcasecmp(spec, "imix")))
+      spec = imix;
+
+   cnf_profile_len    = 0;
+   cnf_profile_weight = 0;
+   for(tok = strtok_r(spec, ",", &ptr); ((tok)); tok = strtok_r(NULL, ",", &ptr))
+   {
+      if (cnf_profile_len >= MY_PROFILE_MAX)
+      {
+         my_usage_error("more than %u traffic profile entries", MY_PROFILE_MAX);
+         return(-1);
+      };
+      min    = (size_t)strtoul(tok, &end, 10);
+      max    = (end[0] == '-') ? (size_t)strtoul(&end[1], &end, 10) : min;
+      weight = (end[0] == ':') ? strtoul(&end[1], &end, 10)         : 1;
+      if ( ((end[0])) || (end == tok) || (max < min) || (max > MY_SWEEP_MAX) || (!(weight)) || (weight > 1000000) )
+      {
+         my_usage_error("invalid traffic profile entry `%s'", tok);
+         return(-1);
+      };
+      cnf_profile[cnf_profile_len].min    = min;
+      cnf_profile[cnf_profile_len].max    = max;
+      cnf_profile[cnf_profile_len].weight = (unsigned)weight;
+      cnf_profile_len++;
+   };
+   if (!(cnf_profile_len))
+   {
+      my_usage_error("empty traffic profile");
+      return(-1);
+   };
+
+   // a single range is split into buckets of equal width weighted by the
+   // number of sizes in each
+   if ( (cnf_profile_len == 1) && (cnf_profile[0].min != cnf_profile[0].max) )
+   {
+      min   = cnf_profile[0].min;
+      width = cnf_profile[0].max - min + 1;
+      for(pos = 0, cnf_profile_len = 0; (pos < MY_PROFILE_BUCKETS); pos++)
+      {
+         if ( ((width * (pos + 1)) / MY_PROFILE_BUCKETS) == ((width * pos) / MY_PROFILE_BUCKETS) )
+            continue;
+         cnf_profile[cnf_profile_len].min    = min + ((width * pos) / MY_PROFILE_BUCKETS);
+         cnf_profile[cnf_profile_len].max    = min + ((width * (pos + 1)) / MY_PROFILE_BUCKETS) - 1;
+         cnf_profile[cnf_profile_len].weight = (unsigned)(cnf_profile[cnf_profile_len].max - cnf_profile[cnf_profile_len].min + 1);
+         cnf_profile_len++;
+      };
+   };
+
+   for(pos = 0; (pos < cnf_profile_len); pos++)
+      cnf_profile_weight += cnf_profile[pos].weight;
+
+   return(0);
+}
+
+
+// size of request to target, drawn from the traffic profile when configured
+size_t
+my_profile_size(
+         const my_target_t *           tgt,
+         uint32_t                      seq,
+         unsigned *                    bucketp )
+{
+   uint64_t                   hash;
+   uint64_t                   pick;
+   unsigned                   pos;
+
+   if (!(cnf_profile_len))
+   {
+      if ((bucketp))
+         *bucketp = 0;
+      return(cnf_packetsize);
+   };
+
+   // size is a function of target and sequence (splitmix64), so responses
+   // are verified without recording the size of each request
+   hash  = (((uint64_t)(tgt - targets)) << 32) | seq;
+   hash += 0x9e3779b97f4a7c15ULL;
+   hash  = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   hash  = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+   hash ^= (hash >> 31);
+
+   pick = (hash & 0xffffffffULL) % cnf_profile_weight;
+   for(pos = 0; (pick >= cnf_profile[pos].weight); pos++)
+      pick -= cnf_profile[pos].weight;
+   if ((bucketp))
+      *bucketp = pos;
+
+   return(cnf_profile[pos].min + (size_t)((hash >> 32) % (cnf_profile[pos].max - cnf_profile[pos].min + 1)));
+}
+
+
+// print statistics of traffic profile size buckets
+void
+my_profile_summary(
+         my_bucket_t *                 buckets )
+{
+   unsigned                   pos;
+   uint64_t                   avg;
+   uint64_t                   avg_ns;
+   uint64_t                   loss;
+   uint64_t                   answered;
+   char                       size[32];
+   my_bucket_t *              bp;
+
+   if (cnf_format == MY_FORMAT_TEXT)
+   {
+      printf("\n");
+      printf("--- size buckets ---\n");
+      printf("%-12s %8s %8s %8s %6s %10s %10s %10s\n", "size", "sent", "rcvd", "corrupt", "loss", "min", "avg", "max");
+   };
+   for(pos = 0; (pos < cnf_profile_len); pos++)
+   {
+      bp  = &buckets[pos];
+      avg    = ((bp->rcvd)) ? (bp->rtt_sum / bp->rcvd) : 0;
+      avg_ns = ((bp->rcvd)) ? (my_usec2nsec(bp->rtt_sum) / bp->rcvd) : 0;
+      if (cnf_format == MY_FORMAT_JSONL)
+      {
+         printf("{\"type\":\"bucket\",\"size_min\":%zu,\"size_max\":%zu,\"sent\":%" PRIu64 ",\"rcvd\":%" PRIu64 ",\"corrupt\":%" PRIu64 ",\"rtt_min_ns\":%" PRIu64 ",\"rtt_avg_ns\":%" PRIu64 ",\"rtt_max_ns\":%" PRIu64 "}\n",
+                cnf_profile[pos].min, cnf_profile[pos].max, bp->sent, bp->rcvd, bp->corrupt, my_usec2nsec(bp->rtt_min), avg_ns, my_usec2nsec(bp->rtt_max));
+         continue;
+      };
+      if (cnf_format == MY_FORMAT_CSV)
+      {
+         printf("bucket,%zu,%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+                cnf_profile[pos].min, cnf_profile[pos].max, bp->sent, bp->rcvd, bp->corrupt, my_usec2nsec(bp->rtt_min), avg_ns, my_usec2nsec(bp->rtt_max));
+         continue;
+      };
+      if (cnf_profile[pos].min == cnf_profile[pos].max)
+         snprintf(size, sizeof(size), "%zu", cnf_profile[pos].min);
+      else
+         snprintf(size, sizeof(size), "%zu-%zu", cnf_profile[pos].min, cnf_profile[pos].max);
+      // corrupted responses arrived and are not counted as loss
+      answered = bp->rcvd + bp->corrupt;
+      loss     = ( (!(bp->sent)) || (answered >= bp->sent) ) ? 0 : (((bp->sent - answered) * 1000) / bp->sent);
+      printf("%-12s %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %3" PRIu64 ".%" PRIu64 "%%", size, bp->sent, bp->rcvd, bp->corrupt, loss / 10, loss % 10);
+      if (!(bp->rcvd))
+      {
+         printf(" %10s %10s %10s\n", "-", "-", "-");
+         continue;
+      };
+      printf(" %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms\n",
+             my_usec2msec(bp->rtt_min), my_usec2msec_tenths(bp->rtt_min),
+             my_usec2msec(avg),         my_usec2msec_tenths(avg),
+             my_usec2msec(bp->rtt_max), my_usec2msec_tenths(bp->rtt_max)
+      );
+   };
+   fflush(stdout);
+
+   return;
+}
+
+
+// write buffered structured records of worker
+void
+my_record_flush(
+         my_worker_t *                 w )
+{
+   if (!(w->outlen))
+      return;
+   // stdio locks the stream, records of different workers do not interleave
+   fwrite(w->outbuf, 1, w->outlen, stdout);
+   fflush(stdout);
+   w->outlen = 0;
+   return;
+}
+
+
+// print column names of structured CSV records
+void
+my_record_header(
+         void )
+{
+   if (cnf_format != MY_FORMAT_CSV)
+      return;
+   printf("type,target,address,seq,send_ns,recv_ns,rtt_ns,delay_ns,adj_rtt_ns,kernel_rtt_ns,size,status\n");
+   if ((cnf_throughput))
+      printf("type,sec,sent,rcvd,loss_forward,loss_return,loss_reflector\n");
+   if ((cnf_report))
+      printf("type,sec,target,address,sent,rcvd,lost,rtt_avg_ns,rtt_p50_ns,rtt_p90_ns,rtt_p99_ns,rtt_p999_ns,jitter_ns\n");
+   printf("type,target,address,sent,rcvd,dups,reordered,late,corrupt,rtt_min_ns,rtt_avg_ns,rtt_max_ns,rtt_p50_ns,rtt_p90_ns,rtt_p99_ns,rtt_p999_ns,rtt_stddev_ns,jitter_ns,loss_forward,loss_return,loss_reflector,kernel_rtt_min_ns,kernel_rtt_avg_ns,kernel_rtt_max_ns,host_overhead_ns,owd_fwd_avg_ns,owd_rev_avg_ns,owd_asymmetry_ns,clock_drift_ppm,dscp,dscp_remarked,ecn_ce\n");
+   if ((cnf_profile_len))
+      printf("type,size_min,size_max,sent,rcvd,corrupt,rtt_min_ns,rtt_avg_ns,rtt_max_ns\n");
+   fflush(stdout);
+   return;
+}
+
+
+// append structured record of a response to worker buffer
+void
+my_record_packet(
+         my_worker_t *                 w,
+         my_target_t *                 tgt,
+         uint32_t                      seq,
+         int64_t                       send_ns,
+         int64_t                       recv_ns,
+         uint64_t                      delay_ns,
+         uint64_t                      krtt_ns,
+         int                           status )
+{
+   int                        len;
+   uint64_t                   rtt_ns;
+   uint64_t                   adj_ns;
+   char                       krtt[24];
+   char                       host[512];
+
+   if ((w->outlen + MY_LINE_MAX) > MY_OUTBUF_SIZE)
+      my_record_flush(w);
+
+   rtt_ns = (recv_ns > send_ns) ? (uint64_t)(recv_ns - send_ns) : 0;
+   adj_ns = (rtt_ns > delay_ns) ? (rtt_ns - delay_ns) : rtt_ns;
+
+   // kernel round-trip is null or empty without kernel timestamps
+   if ((krtt_ns))
+      snprintf(krtt, sizeof(krtt), "%" PRIu64, krtt_ns);
+   else
+      strncpy(krtt, (cnf_format == MY_FORMAT_JSONL) ? "null" : "", sizeof(krtt));
+
+   my_escape(host, sizeof(host), tgt->host, cnf_format);
+   if (cnf_format == MY_FORMAT_JSONL)
+      len = snprintf(&w->outbuf[w->outlen], MY_LINE_MAX,
+            "{\"type\":\"packet\",\"target\":\"%s\",\"address\":\"%s\",\"seq\":%" PRIu32 ",\"send_ns\":%" PRId64 ",\"recv_ns\":%" PRId64 ",\"rtt_ns\":%" PRIu64 ",\"delay_ns\":%" PRIu64 ",\"adj_rtt_ns\":%" PRIu64 ",\"kernel_rtt_ns\":%s,\"size\":%zu,\"status\":\"%s\"}\n",
+            host, tgt->addrstr, seq, send_ns, recv_ns, rtt_ns, delay_ns, adj_ns, krtt, my_profile_size(tgt, seq, NULL), seq_status[status]);
+   else
+      len = snprintf(&w->outbuf[w->outlen], MY_LINE_MAX,
+            "packet,%s,%s,%" PRIu32 ",%" PRId64 ",%" PRId64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%s,%zu,%s\n",
+            host, tgt->addrstr, seq, send_ns, recv_ns, rtt_ns, delay_ns, adj_ns, krtt, my_profile_size(tgt, seq, NULL), seq_status[status]);
+   if ( (len > 0) && (len < MY_LINE_MAX) )
+      w->outlen += (size_t)len;
+
+   return;
+}
+
+
+// print structured summary record of a target
+void
+my_record_summary(
+         my_target_t *                 tgt,
+         my_stats_t *                  st )
+{
+   uint64_t                   avg;
+   uint64_t                   stddev;
+   uint64_t                   jitter;
+   uint64_t                   pct[4];
+   char                       quantiles[256];
+   char                       kernel[128];
+   char                       owd[160];
+   char                       tclass[96];
+   char                       host[512];
+   char                       drift[48];
+   int64_t                    fwd_avg;
+   int64_t                    rev_avg;
+   double                     ppm;
+
+   // durations are reported in nanoseconds like packet records
+   avg    = ((st->rcvd)) ? (my_usec2nsec(st->rtt_sum) / st->rcvd) : 0;
+   stddev = (st->rcvd > 1) ? (uint64_t)((sqrt(st->rtt_m2 / (double)(st->rcvd - 1)) * 1000.0) + 0.5) : 0;
+   jitter = (uint64_t)((st->jitter * 1000.0) + 0.5);
+
+   // quantiles are omitted when no histogram is kept for the target
+   quantiles[0] = '\0';
+   if ( ((st->rtt_hist)) && ((st->rcvd)) )
+   {
+      pct[0] = my_usec2nsec(akudp_hist_quantile(st->rtt_hist, 0.50));
+      pct[1] = my_usec2nsec(akudp_hist_quantile(st->rtt_hist, 0.90));
+      pct[2] = my_usec2nsec(akudp_hist_quantile(st->rtt_hist, 0.99));
+      pct[3] = my_usec2nsec(akudp_hist_quantile(st->rtt_hist, 0.999));
+      snprintf(quantiles, sizeof(quantiles),
+               ((cnf_format == MY_FORMAT_JSONL)
+                  ? ",\"rtt_p50_ns\":%" PRIu64 ",\"rtt_p90_ns\":%" PRIu64 ",\"rtt_p99_ns\":%" PRIu64 ",\"rtt_p999_ns\":%" PRIu64
+                  : "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64),
+               pct[0], pct[1], pct[2], pct[3]);
+   } else if (cnf_format == MY_FORMAT_CSV)
+      strncpy(quantiles, ",,,", sizeof(quantiles));
+
+   // kernel round-trip is omitted without kernel timestamps
+   kernel[0] = '\0';
+   if ((st->krtt_cnt))
+      snprintf(kernel, sizeof(kernel),
+               ((cnf_format == MY_FORMAT_JSONL)
+                  ? ",\"kernel_rtt_min_ns\":%" PRIu64 ",\"kernel_rtt_avg_ns\":%" PRIu64 ",\"kernel_rtt_max_ns\":%" PRIu64 ",\"host_overhead_ns\":%" PRId64
+                  : ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRId64),
+               my_usec2nsec(st->krtt_min), my_usec2nsec(st->krtt_sum) / st->krtt_cnt, my_usec2nsec(st->krtt_max), my_usec2nsec(st->host_sum) / (int64_t)st->krtt_cnt);
+   else if (cnf_format == MY_FORMAT_CSV)
+      strncpy(kernel, ",,,,", sizeof(kernel));
+
+   // one-way delays are omitted without STAMP or echo plus timestamps, and
+   // the drift until enough clock samples were filtered
+   owd[0] = '\0';
+   if ((st->owd_cnt))
+   {
+      fwd_avg = my_usec2nsec(st->fwd_sum) / (int64_t)st->owd_cnt;
+      rev_avg = my_usec2nsec(st->rev_sum) / (int64_t)st->owd_cnt;
+      drift[0] = '\0';
+      if (my_clock_drift(st, &ppm) == 0)
+         snprintf(drift, sizeof(drift), ((cnf_format == MY_FORMAT_JSONL) ? ",\"clock_drift_ppm\":%.1f" : "%.1f"), ppm);
+      snprintf(owd, sizeof(owd),
+               ((cnf_format == MY_FORMAT_JSONL)
+                  ? ",\"owd_fwd_avg_ns\":%" PRId64 ",\"owd_rev_avg_ns\":%" PRId64 ",\"owd_asymmetry_ns\":%" PRId64 "%s"
+                  : ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%s"),
+               fwd_avg, rev_avg, fwd_avg - rev_avg, drift);
+   } else if (cnf_format == MY_FORMAT_CSV)
+      strncpy(owd, ",,,,", sizeof(owd));
+
+   // traffic class is omitted unless requests are marked
+   tclass[0] = '\0';
+   if ( (tgt->tos != -1) && ((cnf_tos_reflected)) )
+      snprintf(tclass, sizeof(tclass),
+               ((cnf_format == MY_FORMAT_JSONL)
+                  ? ",\"dscp\":%i,\"dscp_remarked\":%" PRIu32 ",\"ecn_ce\":%" PRIu32
+                  : ",%i,%" PRIu32 ",%" PRIu32),
+               tgt->tos >> 2, st->tos_remarked, st->tos_ce);
+   else if (tgt->tos != -1)
+      snprintf(tclass, sizeof(tclass), ((cnf_format == MY_FORMAT_JSONL) ? ",\"dscp\":%i" : ",%i,,"), tgt->tos >> 2);
+   else if (cnf_format == MY_FORMAT_CSV)
+      strncpy(tclass, ",,,", sizeof(tclass));
+
+   my_escape(host, sizeof(host), tgt->host, cnf_format);
+   if (cnf_format == MY_FORMAT_JSONL)
+      printf("{\"type\":\"summary\",\"target\":\"%s\",\"address\":\"%s\",\"sent\":%" PRIu32 ",\"rcvd\":%" PRIu32 ",\"dups\":%" PRIu32 ",\"reordered\":%" PRIu32 ",\"late\":%" PRIu32 ",\"corrupt\":%" PRIu32 ",\"rtt_min_ns\":%" PRIu64 ",\"rtt_avg_ns\":%" PRIu64 ",\"rtt_max_ns\":%" PRIu64 "%s,\"rtt_stddev_ns\":%" PRIu64 ",\"jitter_ns\":%" PRIu64 ",\"loss_forward\":%" PRIu32 ",\"loss_return\":%" PRIu32 ",\"loss_reflector\":%" PRIu32 "%s%s%s}\n",
+             host, tgt->addrstr, st->sent, st->rcvd, st->dups, st->reordered, st->late, st->corrupt,
+             my_usec2nsec(st->rtt_min), avg, my_usec2nsec(st->rtt_max), quantiles, stddev, jitter,
+             st->loss[MY_LOSS_FORWARD], st->loss[MY_LOSS_RETURN], st->loss[MY_LOSS_REFLECTOR], kernel, owd, tclass);
+   else
+      printf("summary,%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%s,%" PRIu64 ",%" PRIu64 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "%s%s%s\n",
+             host, tgt->addrstr, st->sent, st->rcvd, st->dups, st->reordered, st->late, st->corrupt,
+             my_usec2nsec(st->rtt_min), avg, my_usec2nsec(st->rtt_max), quantiles, stddev, jitter,
+             st->loss[MY_LOSS_FORWARD], st->loss[MY_LOSS_RETURN], st->loss[MY_LOSS_REFLECTOR], kernel, owd, tclass);
+
+   return;
+}
+
+
+// contribute worker statistics to combined report, last worker prints it
+void
+my_report(
+         my_worker_t *                 w,
+         my_report_t *                 r )
+{
+   size_t                     pos;
+   size_t                     idx;
+
+   // records of earlier responses are written before the report
+   my_record_flush(w);
+
+   pthread_mutex_lock(&r->mutex);
+
+   if ( (!(r->stats)) && ((r->stats = my_stats_alloc()) == NULL) )
+   {
+      pthread_mutex_unlock(&r->mutex);
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+      return;
+   };
+
+   // first worker to contribute starts a new round, which includes the
+   // final statistics of workers which have already exited
+   if (!(r->pending))
+   {
+      r->pending = r->workers;
+      for(pos = 0; (pos < targets_len); pos++)
+         my_stats_reset(&r->stats[pos]);
+      for(idx = 0; (idx < cnf_threads); idx++)
+      {
+         if (r->state[idx] == MY_REPORT_JOINED)
+            r->state[idx] = MY_REPORT_IDLE;
+         for(pos = 0; ( (r->state[idx] == MY_REPORT_EXITED) && (pos < targets_len) ); pos++)
+            my_stats_merge(&r->stats[pos], &workers[idx].stats[pos]);
+      };
+   };
+   for(pos = 0; (pos < targets_len); pos++)
+      my_stats_merge(&r->stats[pos], &w->stats[pos]);
+   r->state[w - workers] = MY_REPORT_JOINED;
+
+   // last worker to contribute prints the combined statistics
+   if (!(--r->pending))
+      my_report_finish(r);
+
+   pthread_mutex_unlock(&r->mutex);
+
+   return;
+}
+
+
+// print or publish combined statistics of completed round
+void
+my_report_finish(
+         my_report_t *                 r )
+{
+   if (r == &report_interval)
+      my_report_print(r);
+   else if (r == &report_metrics)
+      my_metrics_update(r);
+   else
+      my_stats_summary(r->stats);
+   r->rounds++;
+   return;
+}
+
+
+// remove exiting worker from combined report, keeping its final statistics
+void
+my_report_leave(
+         my_worker_t *                 w,
+         my_report_t *                 r )
+{
+   size_t                     pos;
+
+   pthread_mutex_lock(&r->mutex);
+
+   r->workers--;
+
+   // a round waiting for this worker is completed with its final statistics
+   if ( ((r->pending)) && (r->state[w - workers] != MY_REPORT_JOINED) )
+   {
+      for(pos = 0; (pos < targets_len); pos++)
+         my_stats_merge(&r->stats[pos], &w->stats[pos]);
+      if (!(--r->pending))
+         my_report_finish(r);
+   };
+   r->state[w - workers] = MY_REPORT_EXITED;
+
+   pthread_mutex_unlock(&r->mutex);
+
+   return;
+}
+
+
+// print combined statistics of interval since previous report
+void
+my_report_print(
+         my_report_t *                 r )
+{
+   size_t                     idx;
+   uint64_t                   sec;
+   uint64_t                   sent;
+   uint64_t                   rcvd;
+   uint64_t                   lost;
+   uint64_t                   avg;
+   uint64_t                   jitter;
+   uint64_t                   pct[4];
+   char                       quantiles[256];
+   char                       host[512];
+   my_target_t *              tgt;
+   my_stats_t *               st;
+   my_stats_t *               prev;
+
+   if ( (!(r->prev)) && ((r->prev = my_stats_alloc()) == NULL) )
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+      return;
+   };
+
+   sec = my_nsec2sec(((r->rounds + 1) * cnf_report));
+   for(idx = 0; (idx < targets_len); idx++)
+   {
+      tgt  = &targets[idx];
+      st   = &r->stats[idx];
+      prev = &r->prev[idx];
+
+      // late responses of the previous interval may exceed the requests sent
+      sent   = st->sent - prev->sent;
+      rcvd   = st->rcvd - prev->rcvd;
+      lost   = (sent > rcvd) ? (sent - rcvd) : 0;
+      avg    = ((rcvd)) ? ((st->rtt_sum - prev->rtt_sum) / rcvd) : 0;
+
+      // RFC 3550 jitter estimates the mean delay variation of consecutive
+      // arrivals, the interval reports that mean over its own arrivals
+      // instead of the smoothed value carried over from earlier intervals
+      jitter = st->jitter_abs_cnt - prev->jitter_abs_cnt;
+      jitter = ((jitter)) ? ((st->jitter_abs_sum - prev->jitter_abs_sum) / jitter) : 0;
+
+      // quantiles of the interval are read from the difference of the
+      // cumulative histograms, which replaces the previous histogram
+      // until the current one is saved for the next interval
+      memset(pct, 0, sizeof(pct));
+      if ((st->rtt_hist))
+      {
+         akudp_hist_delta(prev->rtt_hist, st->rtt_hist, prev->rtt_hist);
+         pct[0] = akudp_hist_quantile(prev->rtt_hist, 0.50);
+         pct[1] = akudp_hist_quantile(prev->rtt_hist, 0.90);
+         pct[2] = akudp_hist_quantile(prev->rtt_hist, 0.99);
+         pct[3] = akudp_hist_quantile(prev->rtt_hist, 0.999);
+         akudp_hist_copy(prev->rtt_hist, st->rtt_hist);
+      };
+      prev->sent           = st->sent;
+      prev->rcvd           = st->rcvd;
+      prev->rtt_sum        = st->rtt_sum;
+      prev->jitter_abs_sum = st->jitter_abs_sum;
+      prev->jitter_abs_cnt = st->jitter_abs_cnt;
+
+      // quantiles are omitted when no histogram is kept for the target
+      quantiles[0] = '\0';
+      if ( ((st->rtt_hist)) && ((rcvd)) )
+         snprintf(quantiles, sizeof(quantiles),
+                  ((cnf_format == MY_FORMAT_JSONL)
+                     ? ",\"rtt_p50_ns\":%" PRIu64 ",\"rtt_p90_ns\":%" PRIu64 ",\"rtt_p99_ns\":%" PRIu64 ",\"rtt_p999_ns\":%" PRIu64
+                     : "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64),
+                  my_usec2nsec(pct[0]), my_usec2nsec(pct[1]), my_usec2nsec(pct[2]), my_usec2nsec(pct[3]));
+      else if (cnf_format == MY_FORMAT_CSV)
+         strncpy(quantiles, ",,,", sizeof(quantiles));
+
+      if (cnf_format != MY_FORMAT_TEXT)
+         my_escape(host, sizeof(host), tgt->host, cnf_format);
+      if (cnf_format == MY_FORMAT_JSONL)
+      {
+         printf("{\"type\":\"report\",\"sec\":%" PRIu64 ",\"target\":\"%s\",\"address\":\"%s\",\"sent\":%" PRIu64 ",\"rcvd\":%" PRIu64 ",\"lost\":%" PRIu64 ",\"rtt_avg_ns\":%" PRIu64 "%s,\"jitter_ns\":%" PRIu64 "}\n",
+                sec, host, tgt->addrstr, sent, rcvd, lost, my_usec2nsec(avg), quantiles, my_usec2nsec(jitter));
+         continue;
+      };
+      if (cnf_format == MY_FORMAT_CSV)
+      {
+         printf("report,%" PRIu64 ",%s,%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%s,%" PRIu64 "\n",
+                sec, host, tgt->addrstr, sent, rcvd, lost, my_usec2nsec(avg), quantiles, my_usec2nsec(jitter));
+         continue;
+      };
+
+      if ((cnf_multi))
+         printf("%" PRIu64 "s %s (%s): ", sec, tgt->host, tgt->addrstr);
+      else
+         printf("%" PRIu64 "s: ", sec);
+      printf("%" PRIu64 " sent, %" PRIu64 " rcvd, %" PRIu64 ".%" PRIu64 "%% loss",
+             sent, rcvd,
+             ((lost)) ? (lost * 100) / sent : 0,
+             ((lost)) ? ((lost * 1000) / sent) % 10 : 0
+      );
+      if (!(rcvd))
+      {
+         printf("\n");
+         continue;
+      };
+      if ((st->rtt_hist))
+         printf(", rtt avg/p50/p90/p99/p99.9 = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms",
+                my_usec2msec(avg),    my_usec2msec_tenths(avg),
+                my_usec2msec(pct[0]), my_usec2msec_tenths(pct[0]),
+                my_usec2msec(pct[1]), my_usec2msec_tenths(pct[1]),
+                my_usec2msec(pct[2]), my_usec2msec_tenths(pct[2]),
+                my_usec2msec(pct[3]), my_usec2msec_tenths(pct[3])
+         );
+      else
+         printf(", rtt avg = %" PRIu64 ".%" PRIu64 " ms", my_usec2msec(avg), my_usec2msec_tenths(avg));
+      printf(", jitter = %" PRIu64 ".%" PRIu64 " ms\n", my_usec2msec(jitter), my_usec2msec_tenths(jitter));
+   };
+   fflush(stdout);
+
+   return;
+}
+
+
+// receive and process pending responses, returns number counted
+uint64_t
+my_recv(
+         my_worker_t *                 w,
+         int                           fd,
+         unsigned                      cls )
+{
+   unsigned                   pos;
+   uint64_t                   rcvd;
+   my_target_t *              tgt;
+   char *                     buff;
+   my_stats_t *               st;
+#ifdef HAVE_RECVMMSG
+   int                        len;
+   struct mmsghdr             msgs[MY_BATCH_MAX];
+   struct iovec               iovs[MY_BATCH_MAX];
+   union my_sa                addrs[MY_BATCH_MAX];
+   char                       ctrl[MY_BATCH_MAX][MY_CMSG_SIZE];
+#else
+   ssize_t                    ssize;
+   struct msghdr              msg;
+   struct iovec               iov;
+   union my_sa                sa;
+   char                       ctrl[MY_CMSG_SIZE];
+#endif
+
+   rcvd = 0;
+   buff = (char *)w->rcvbuff;
+
+#ifdef HAVE_RECVMMSG
+   // receive a batch of datagrams with a single system call
+   memset(msgs, 0, sizeof(msgs));
+   for(pos = 0; (pos < MY_BATCH_MAX); pos++)
+   {
+      iovs[pos].iov_base            = &buff[pos * cnf_packetsize];
+      iovs[pos].iov_len             = cnf_packetsize;
+      msgs[pos].msg_hdr.msg_name    = &addrs[pos];
+      msgs[pos].msg_hdr.msg_namelen = sizeof(union my_sa);
+      msgs[pos].msg_hdr.msg_iov     = &iovs[pos];
+      msgs[pos].msg_hdr.msg_iovlen  = 1;
+      if ( (cnf_timestamping != MY_TS_NONE) || ((cnf_tos_len)) )
+      {
+         msgs[pos].msg_hdr.msg_control    = ctrl[pos];
+         msgs[pos].msg_hdr.msg_controllen = MY_CMSG_SIZE;
+      };
+   };
+   // MSG_TRUNC returns the full size of oversized datagrams
+   if ((len = recvmmsg(fd, msgs, MY_BATCH_MAX, MSG_TRUNC, NULL)) <= 0)
+   {
+      my_recv_error(errno);
+      return(0);
+   };
+   for(pos = 0; (pos < (unsigned)len); pos++)
+   {
+      if ((tgt = my_target_lookup(&addrs[pos])) == NULL)
+         continue;
+      tgt = &targets[(size_t)(tgt - targets) + (cls * targets_base)];
+      st  = &w->stats[tgt - targets];
+      if ((my_verify(w, tgt, st, iovs[pos].iov_base, msgs[pos].msg_len)))
+         continue;
+      my_tos_update(st, tgt, &msgs[pos].msg_hdr);
+      rcvd += (uint64_t)my_response(w, tgt, st, iovs[pos].iov_base, my_kernel_time(&msgs[pos].msg_hdr));
+   };
+#else
+   for(pos = 0; (pos < MY_BATCH_MAX); pos++)
+   {
+      memset(&msg, 0, sizeof(msg));
+      iov.iov_base    = buff;
+      iov.iov_len     = cnf_packetsize;
+      msg.msg_name    = &sa;
+      msg.msg_namelen = sizeof(sa);
+      msg.msg_iov     = &iov;
+      msg.msg_iovlen  = 1;
+      if ( (cnf_timestamping != MY_TS_NONE) || ((cnf_tos_len)) )
+      {
+         msg.msg_control    = ctrl;
+         msg.msg_controllen = sizeof(ctrl);
+      };
+      if ((ssize = recvmsg(fd, &msg, 0)) == -1)
+      {
+         my_recv_error(errno);
+         break;
+      };
+      if ((msg.msg_flags & MSG_TRUNC))
+         ssize = (ssize_t)cnf_packetsize + 1;
+      if ((tgt = my_target_lookup(&sa)) == NULL)
+         continue;
+      tgt = &targets[(size_t)(tgt - targets) + (cls * targets_base)];
+      st  = &w->stats[tgt - targets];
+      if ((my_verify(w, tgt, st, buff, (size_t)ssize)))
+         continue;
+      my_tos_update(st, tgt, &msg);
+      rcvd += (uint64_t)my_response(w, tgt, st, (echoplus_t *)buff, my_kernel_time(&msg));
+   };
+#endif
+
+   return(rcvd);
+}
+
+
+// report ICMP error received on connected socket of single target
+void
+my_recv_error(
+         int                           err )
+{
+   if ( (err == EAGAIN) || (err == EWOULDBLOCK) || (err == EINTR) )
+      return;
+   if ( (!(cnf_silent)) && (cnf_format == MY_FORMAT_TEXT) )
+      printf("%s: %s\n", targets[0].host, strerror(err));
+   return;
+}
+
+
+// process echo response from target, returns 1 if counted as received
+int
+my_response(
+         my_worker_t *                 w,
+         my_target_t *                 tgt,
+         my_stats_t *                  st,
+         echoplus_t *                  rcvbuff,
+         int64_t                       rx_kern )
+{
+   uint64_t                pckt_time;
+   uint64_t                pckt_time_adj;
+   uint64_t                pckt_delay;
+   int64_t                 owd_fwd;
+   int64_t                 owd_rev;
+   int64_t                 send_ns;
+   int64_t                 recv_ns;
+   uint64_t                delay_ns;
+   uint64_t                krtt;
+   uint64_t                krtt_ns;
+   int64_t                 tx_kern;
+   int                     status;
+   int                     counted;
+   int                     echoplus;
+   int                     detected;
+   unsigned                bucket;
+   my_bucket_t *           bp;
+   const char *            note;
+   char                    ktime[48];
+   akudp_stamp_t           stamp_res;
+   akudp_echoplus_t        msg;
+   struct timespec         now;
+
+   memset(&stamp_res, 0, sizeof(stamp_res));
+   memset(&msg, 0, sizeof(msg));
+   owd_fwd = 0;
+   owd_rev = 0;
+
+   // process STAMP session-reflector packet
+   if ((cnf_stamp))
+   {
+      struct timespec ts_real;
+      int64_t         t1, t2, t3, t4, tx;
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+      clock_gettime(CLOCK_REALTIME, &ts_real);
+      akudp_stamp_decode(&stamp_res, rcvbuff, MY_STAMP_SIZE);
+      t1 = akudp_ntp2nsec(stamp_res.ss_sec, stamp_res.ss_frac);
+      t2 = akudp_ntp2nsec(stamp_res.rx_sec, stamp_res.rx_frac);
+      t3 = akudp_ntp2nsec(stamp_res.ts_sec, stamp_res.ts_frac);
+      t4 = ((int64_t)ts_real.tv_sec * 1000000000LL) + ts_real.tv_nsec;
+      if ((cnf_debug))
+      {
+         printf("   packet: Seq/SenderSeq:   %08" PRIx32 " %08" PRIx32 "\n", stamp_res.seq, stamp_res.ss_seq);
+         printf("           Recv/Reply Time: %08" PRIx32 ".%08" PRIx32 " %08" PRIx32 ".%08" PRIx32 "\n", stamp_res.rx_sec, stamp_res.rx_frac, stamp_res.ts_sec, stamp_res.ts_frac);
+         printf("           Error Estimate:  %04" PRIx16 " %04" PRIx16 "\n", stamp_res.errest, stamp_res.ss_errest);
+         printf("           Sender TTL:      %u\n", stamp_res.ss_ttl);
+      };
+      // round-trip is measured on the monotonic clock, the wall clock
+      // timestamps are only used for one-way delays
+      tx             = st->stx[stamp_res.ss_seq % MY_SEQ_WINDOW];
+      recv_ns        = ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec;
+      pckt_time      = ( ((tx)) && (recv_ns > tx) ) ? (uint64_t)(recv_ns - tx) / 1000 : 0;
+      pckt_delay     = (t3 > t2) ? (uint64_t)(t3 - t2) / 1000 : 0;
+      pckt_time_adj  = (pckt_time > pckt_delay) ? (pckt_time - pckt_delay) : pckt_time;
+      owd_fwd        = (t2 - t1) / 1000;
+      owd_rev        = (t4 - t3) / 1000;
+      send_ns        = tx + clock_offset;
+      recv_ns       += clock_offset;
+      delay_ns       = (t3 > t2) ? (uint64_t)(t3 - t2) : 0;
+      st->stamp_sync = ( ((st->stamp_sync)) && ((stamp_res.errest & 0x8000)) && ((stamp_res.ss_errest & 0x8000)) ) ? 1 : 0;
+      msg.req_sn     = stamp_res.ss_seq;
+   } else
+   {
+      akudp_echoplus_decode(&msg, rcvbuff->hdr, sizeof(rcvbuff->hdr));
+      if ((cnf_debug))
+      {
+         printf("   packet: GenSN/REspSN:    %08" PRIx32 " %08" PRIx32 "\n", msg.req_sn, msg.res_sn);
+         printf("           Recv/Reply Time: %08" PRIx32 " %08" PRIx32 "\n", msg.recv_time, msg.reply_time);
+         printf("           Failures:        %08" PRIx32 "\n",               msg.failures);
+         printf("           Iteration:       %08" PRIx32 "\n",               msg.iteration);
+      };
+
+      // performs stats on packet
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+      pckt_time      = akudp_timespec_delta(&now, &rcvbuff->send_time, NULL);
+      pckt_delay     = (uint32_t)(msg.reply_time - msg.recv_time);
+      send_ns        = ((int64_t)rcvbuff->send_time.tv_sec * 1000000000LL) + rcvbuff->send_time.tv_nsec + clock_offset;
+      recv_ns        = ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec + clock_offset;
+      delay_ns       = my_usec2nsec(pckt_delay);
+      pckt_time_adj  = (pckt_time > pckt_delay)
+                     ? (pckt_time - pckt_delay)
+                     : pckt_time;
+   };
+
+   // classify by sequence number, duplicates and late responses are not
+   // counted as received
+   if ((status = my_seq_update(st, msg.req_sn, pckt_time)) == MY_SEQ_INVALID)
+      return(0);
+   if (status == MY_SEQ_DUPLICATE)
+      note = " (DUP!)";
+   else if (status == MY_SEQ_LATE)
+      note = " (late)";
+   else if (status == MY_SEQ_REORDERED)
+      note = " (reordered)";
+   else
+      note = "";
+   if ((counted = (status <= MY_SEQ_REORDERED) ? 1 : 0))
+      my_stats_record(st, msg.req_sn, pckt_time, pckt_time_adj);
+   if ( ((counted)) && ((cnf_profile_len)) )
+   {
+      my_profile_size(tgt, msg.req_sn, &bucket);
+      bp           = &w->buckets[bucket];
+      bp->rtt_min  = ( (!(bp->rcvd)) || (pckt_time < bp->rtt_min) ) ? pckt_time : bp->rtt_min;
+      bp->rtt_max  = (pckt_time > bp->rtt_max) ? pckt_time : bp->rtt_max;
+      bp->rtt_sum += pckt_time;
+      bp->rcvd++;
+   };
+   if ( ((counted)) && (cnf_burst > 1) )
+      my_burst_update(st, msg.req_sn, pckt_time, (uint64_t)rx_kern, my_profile_size(tgt, msg.req_sn, NULL));
+
+   // first response of any worker resolves auto detection for all workers
+   echoplus = __atomic_load_n(&cnf_echoplus, __ATOMIC_RELAXED);
+   if ( (!(cnf_stamp)) && (echoplus == -1) )
+   {
+      detected = (((msg.res_sn)) || ((msg.recv_time)) || ((msg.reply_time))) ? 1 : 0;
+      if ((__atomic_compare_exchange_n(&cnf_echoplus, &echoplus, detected, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)))
+         echoplus = detected;
+   };
+   if ( (!(cnf_stamp)) && (echoplus == 1) && ((counted)) )
+   {
+      my_loss_update(w, st, &msg, status);
+      my_clock_update(st, (int64_t)my_nsec2usec((((uint64_t)rcvbuff->send_time.tv_sec * 1000000000ULL) + (uint64_t)rcvbuff->send_time.tv_nsec)),
+                      msg.recv_time, (int64_t)pckt_time - (int64_t)pckt_delay, &owd_fwd, &owd_rev);
+   };
+   if ( ((counted)) && ( ((cnf_stamp)) || (echoplus == 1) ) )
+      my_stats_owd(st, owd_fwd, owd_rev);
+
+   // kernel round-trip excludes scheduling and system call latency of the
+   // client, the remainder of the application round-trip is host overhead
+   krtt_ns  = 0;
+   krtt     = 0;
+   ktime[0] = '\0';
+   if ( ((counted)) && ((rx_kern)) && ((st->ktx)) && ((tx_kern = st->ktx[msg.req_sn % MY_SEQ_WINDOW])) && (rx_kern > tx_kern) )
+   {
+      krtt_ns       = (uint64_t)(rx_kern - tx_kern);
+      krtt          = krtt_ns / 1000;
+      st->krtt_min  = ( (!(st->krtt_cnt)) || (krtt < st->krtt_min) ) ? krtt : st->krtt_min;
+      st->krtt_max  = (krtt > st->krtt_max) ? krtt : st->krtt_max;
+      st->krtt_sum += krtt;
+      st->host_sum += (int64_t)pckt_time - (int64_t)krtt;
+      st->krtt_cnt++;
+      snprintf(ktime, sizeof(ktime), " ktime=%" PRIu64 ".%" PRIu64 " ms", my_usec2msec(krtt), my_usec2msec_tenths(krtt));
+   };
+
+   // print packet
+   if (cnf_format != MY_FORMAT_TEXT)
+   {
+      my_record_packet(w, tgt, msg.req_sn, send_ns, recv_ns, delay_ns, krtt_ns, status);
+      return(counted);
+   };
+   if ( ((cnf_throughput)) || ((cnf_metrics)) )
+      return(counted);
+   if ((cnf_all_addrs))
+      printf("%s (%s): ", tgt->host, tgt->addrstr);
+   else if ((cnf_multi))
+      printf("%s: ", tgt->host);
+   if ((cnf_stamp))
+   {
+      printf("stamp_seq=%u ttl=%u time=%" PRIu64 ".%" PRIu64 " ms delay=%" PRIu64 ".%" PRIu64 " ms adj_time=%" PRIu64 ".%" PRIu64 " ms fwd=%s%" PRIu64 ".%" PRIu64 " ms rev=%s%" PRIu64 ".%" PRIu64 " ms%s%s\n",
+            msg.req_sn,
+            stamp_res.ss_ttl,
+            my_usec2msec(pckt_time),     my_usec2msec_tenths(pckt_time),
+            my_usec2msec(pckt_delay),    my_usec2msec_tenths(pckt_delay),
+            my_usec2msec(pckt_time_adj), my_usec2msec_tenths(pckt_time_adj),
+            (owd_fwd < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(owd_fwd)), my_usec2msec_tenths((uint64_t)llabs(owd_fwd)),
+            (owd_rev < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(owd_rev)), my_usec2msec_tenths((uint64_t)llabs(owd_rev)),
+            ktime,
+            note
+      );
+      return(counted);
+   };
+   if (!(echoplus))
+   {
+      printf("udpecho_seq=%u time=%" PRIu64 ".%" PRIu64 " ms%s%s\n",
+            msg.req_sn,
+            my_usec2msec(pckt_time), ((pckt_time%1000)/100),
+            ktime,
+            note
+      );
+      return(counted);
+   };
+   printf("udpecho_seq=%u failures=%" PRIu32 " time=%" PRIu64 ".%" PRIu64 " ms delay=%" PRIu64 ".%" PRIu64 " ms adj_time=%" PRIu64 ".%" PRIu64 " ms%s%s\n",
+            msg.req_sn,
+            msg.failures,
+            my_usec2msec(pckt_time),     my_usec2msec_tenths(pckt_time),
+            my_usec2msec(pckt_delay),    my_usec2msec_tenths(pckt_delay),
+            my_usec2msec(pckt_time_adj), my_usec2msec_tenths(pckt_time_adj),
+            ktime,
+            note
+   );
+
+   return(counted);
+}
+
+
+// track sequence number and classify response
+int
+my_seq_update(
+         my_stats_t *                  st,
+         uint32_t                      seq,
+         uint64_t                      rtt )
+{
+   int                        status;
+
+   status = akudp_seq_classify(&st->seqwin, seq, st->seq, rtt, my_sec2usec((uint64_t)cnf_timeout));
+   switch(status)
+   {
+      case MY_SEQ_DUPLICATE: st->dups++;      break;
+      case MY_SEQ_LATE:      st->late++;      break;
+      case MY_SEQ_REORDERED: st->reordered++; break;
+      default:                                break;
+   };
+
+   return(status);
+}
+
+
+// open unconnected socket for address family
+int
+my_socket(
+         int                           family,
+         int                           tos )
+{
+   int                        s;
+   int                        opt;
+
+   if ((s = socket(family, SOCK_DGRAM, 0)) == -1)
+   {
+      fprintf(stderr, "%s: socket(): %s\n", prog_name, strerror(errno));
+      return(-1);
+   };
+
+   // configure socket
+   fcntl(s, F_SETFL, O_NONBLOCK);
+
+   // mark requests with traffic class and report that of responses
+   if ( (tos != -1) && (akudp_socket_tclass(s, family, tos) == -1) )
+   {
+      fprintf(stderr, "%s: setsockopt(%s): %s\n", prog_name, (family == AF_INET6) ? "IPV6_TCLASS" : "IP_TOS", strerror(errno));
+      close(s);
+      return(-1);
+   };
+
+#ifdef HAVE_SO_TIMESTAMPING
+   // TX timestamps are queued to the error queue with a per socket datagram
+   // counter (OPT_ID) instead of a copy of the datagram
+   if (cnf_timestamping != MY_TS_NONE)
+   {
+      opt = (cnf_timestamping == MY_TS_HARDWARE)
+          ? (SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE)
+          : (SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE);
+      opt |= SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+      if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMPING, &opt, sizeof(opt)) == -1)
+      {
+         fprintf(stderr, "%s: setsockopt(SO_TIMESTAMPING): %s\n", prog_name, strerror(errno));
+         close(s);
+         return(-1);
+      };
+   };
+#endif
+
+   return(s);
+}
+
+
+// determine STAMP error estimate of local clock
+uint16_t
+my_stamp_errest(
+         my_worker_t *                 w,
+         time_t                        now )
+{
+   // each worker refreshes its estimate as often as the reflector does
+   if ( ((w->errest)) && ((now - w->errest_time) < AKUDP_STAMP_ERREST_REFRESH) )
+      return(w->errest);
+   w->errest_time = now;
+   w->errest      = akudp_stamp_errest();
+   return(w->errest);
+}
+
+
+// parse list of DSCP names or values into traffic classes
+int
+my_dscp_parse(
+         char *                        list )
+{
+   size_t                     pos;
+   unsigned long              dscp;
+   char *                     tok;
+   char *                     end;
+   char *                     ptr;
+   static const struct
+   {
+      const char *            name;
+      unsigned                dscp;
+   } names[] =
+   {
+      { "be",    0 }, { "df",    0 }, { "le",    1 }, { "cs0",   0 },
+      { "cs1",   8 }, { "af11", 10 }, { "af12", 12 }, { "af13", 14 },
+      { "cs2",  16 }, { "af21", 18 }, { "af22", 20 }, { "af23", 22 },
+      { "cs3",  24 }, { "af31", 26 }, { "af32", 28 }, { "af33", 30 },
+      { "cs4",  32 }, { "af41", 34 }, { "af42", 36 }, { "af43", 38 },
+      { "cs5",  40 }, { "va",   44 }, { "ef",   46 }, { "cs6",  48 },
+      { "cs7",  56 }, { NULL,    0 }
+   };
+
+   for(tok = strtok_r(list, ",", &ptr); ((tok)); tok = strtok_r(NULL, ",", &ptr))
+   {
+      if (cnf_tos_len >= MY_DSCP_MAX)
+      {
+         my_usage_error("more than %u traffic classes", MY_DSCP_MAX);
+         return(-1);
+      };
+      for(pos = 0; ( ((names[pos].name)) && ((strcasecmp(tok, names[pos].name))) ); pos++);
+      if ((names[pos].name))
+         dscp = names[pos].dscp;
+      else if ( ((dscp = strtoul(tok, &end, 0)) > 63) || ((end[0])) || (end == tok) )
+      {
+         my_usage_error("invalid DSCP `%s'", tok);
+         return(-1);
+      };
+      cnf_tos_name[cnf_tos_len] = tok;
+      cnf_tos[cnf_tos_len]      = (int)(dscp << 2);
+      cnf_tos_len++;
+   };
+
+   return(0);
+}
+
+
+// escape string as JSON string, CSV field, or label value, truncating to size
+char *
+my_escape(
+         char *                        dst,
+         size_t                        size,
+         const char *                  src,
+         int                           format )
+{
+   size_t                     len;
+   size_t                     pos;
+   int                        quote;
+   unsigned char              c;
+
+   // CSV fields are quoted only when they contain separators or quotes,
+   // which are doubled (RFC 4180)
+   quote = ( (format == MY_FORMAT_CSV) && ((strpbrk(src, ",\"\r\n"))) ) ? 1 : 0;
+   len   = 0;
+   if ((quote))
+      dst[len++] = '"';
+
+   // leave room for the longest escape, closing quote, and terminator
+   for(pos = 0; ( ((c = (unsigned char)src[pos])) && ((len + 9) < size) ); pos++)
+   {
+      if ( (format == MY_FORMAT_CSV) && (c == '"') )
+         dst[len++] = '"';
+      else if ( (format != MY_FORMAT_CSV) && ( (c == '"') || (c == '\\') ) )
+         dst[len++] = '\\';
+      else if ( (format == MY_FORMAT_METRICS) && (c == '\n') )
+      {
+         dst[len++] = '\\';
+         c          = 'n';
+      }
+      else if ( (format == MY_FORMAT_JSONL) && (c < 0x20) )
+      {
+         len += (size_t)snprintf(&dst[len], size - len, "\\u%04x", c);
+         continue;
+      };
+      dst[len++] = (char)c;
+   };
+
+   if ((quote))
+      dst[len++] = '"';
+   dst[len] = '\0';
+
+   return(dst);
+}
+
+
+// parse interval with optional s, ms, or us suffix into nanoseconds
+int
+my_interval_parse(
+         const char *                  str,
+         uint64_t *                    nsecp )
+{
+   double                     val;
+   char *                     end;
+
+   errno = 0;
+   val   = strtod(str, &end);
+   if ( ((errno)) || (end == str) || (!(isfinite(val))) )
+      return(-1);
+
+   if ( (!(end[0])) || (!(strcmp(end, "s"))) )
+      val *= 1000000000.0;
+   else if (!(strcmp(end, "ms")))
+      val *= 1000000.0;
+   else if (!(strcmp(end, "us")))
+      val *= 1000.0;
+   else
+      return(-1);
+
+   // reject intervals shorter than one microsecond
+   if ( (val < 1000.0) || (val > 1e18) )
+      return(-1);
+   *nsecp = (uint64_t)(val + 0.5);
+
+   return(0);
+}
+
+
+// kernel timestamp of datagram in nanoseconds, returns 0 if not present
+int64_t
+my_kernel_time(
+         struct msghdr *               msg )
+{
+#ifdef HAVE_SO_TIMESTAMPING
+   struct cmsghdr *           cmsg;
+   struct scm_timestamping    tss;
+   struct timespec *          ts;
+
+   for(cmsg = CMSG_FIRSTHDR(msg); ((cmsg)); cmsg = CMSG_NXTHDR(msg, cmsg))
+   {
+      if ( (cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_TIMESTAMPING) )
+         continue;
+      // software timestamps are in ts[0] and raw hardware timestamps in
+      // ts[2], an unset timestamp is zero
+      memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+      ts = &tss.ts[(cnf_timestamping == MY_TS_HARDWARE) ? 2 : 0];
+      return(((int64_t)ts->tv_sec * 1000000000LL) + ts->tv_nsec);
+   };
+#else
+   (void)msg;
+#endif
+   return(0);
+}
+
+
+// open listening socket of metrics endpoint, returns -1 on error
+int
+my_metrics_listen(
+         const char *                  arg )
+{
+   int                        fd;
+   int                        rc;
+   int                        opt;
+   char *                     node;
+   char *                     port;
+   char *                     ptr;
+   char                       buff[256];
+   struct addrinfo            hints;
+   struct addrinfo *          res;
+   struct addrinfo *          ai;
+
+   // split [address]:port, address:port, or port, only the loopback
+   // address is used when no address is given
+   strncpy(buff, arg, sizeof(buff)-1);
+   buff[sizeof(buff)-1] = '\0';
+   node = NULL;
+   port = buff;
+   if (buff[0] == '[')
+   {
+      if ((ptr = strchr(buff, ']')) == NULL)
+         return(-1);
+      *ptr = '\0';
+      node = &buff[1];
+      port = (ptr[1] == ':') ? &ptr[2] : &ptr[1];
+   } else if ((ptr = strrchr(buff, ':')) != NULL)
+   {
+      *ptr = '\0';
+      node = buff;
+      port = &ptr[1];
+   };
+
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family   = cnf_ai_family;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags    = AI_NUMERICSERV;
+   if ( (!(node)) || (!(node[0])) )
+      node = "localhost";
+   if ((rc = getaddrinfo(node, port, &hints, &res)) != 0)
+   {
+      fprintf(stderr, "%s: %s: %s\n", prog_name, arg, gai_strerror(rc));
+      return(-1);
+   };
+
+   fd = -1;
+   for(ai = res; ( (ai != NULL) && (fd == -1) ); ai = ai->ai_next)
+   {
+      if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) == -1)
+         continue;
+      opt = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+      if ( (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0) && (listen(fd, 16) == 0) )
+         break;
+      fprintf(stderr, "%s: %s: %s\n", prog_name, arg, strerror(errno));
+      close(fd);
+      fd = -1;
+   };
+   freeaddrinfo(res);
+
+   return(fd);
+}
+
+
+// metrics endpoint thread, answers scrapes until the test stops
+void *
+my_metrics_run(
+         void *                        arg )
+{
+   int                        fd;
+   struct pollfd              fds[2];
+
+   fds[0].fd     = *(int *)arg;
+   fds[0].events = POLLIN;
+   fds[1].fd     = stop_pipe[0];
+   fds[1].events = POLLIN;
+
+   while (!(should_stop))
+   {
+      if (poll(fds, 2, -1) <= 0)
+         continue;
+      if ((fds[1].revents))
+         break;
+      if ((fd = accept(fds[0].fd, NULL, NULL)) == -1)
+         continue;
+      my_metrics_serve(fd);
+      close(fd);
+   };
+
+   return(NULL);
+}
+
+
+// render most recent published snapshot if it changed
+void
+my_metrics_render(
+         void )
+{
+   int                        fresh;
+   size_t                     idx;
+   size_t                     len;
+   size_t                     le;
+   char *                     text;
+   char                       host[512];
+   FILE *                     fp;
+   my_target_t *              tgt;
+   my_stats_t *               st;
+   my_stats_t *               stats;
+   static const uint64_t      bounds[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000 };
+
+   // take the published snapshot, the previous one is returned to the
+   // workers which clear it before the next round
+   pthread_mutex_lock(&metrics_mutex);
+   if ((fresh = metrics_fresh))
+   {
+      stats          = metrics_stats;
+      metrics_stats  = metrics_render;
+      metrics_render = stats;
+      metrics_fresh  = 0;
+   };
+   pthread_mutex_unlock(&metrics_mutex);
+   if ( (!(fresh)) || (!(metrics_render)) )
+      return;
+   stats = metrics_render;
+
+   text = NULL;
+   len  = 0;
+   if ((fp = open_memstream(&text, &len)) == NULL)
+      return;
+
+   fprintf(fp, "# HELP udpecho_requests_total Echo requests sent.\n");
+   fprintf(fp, "# TYPE udpecho_requests_total counter\n");
+   for(idx = 0; (idx < targets_len); idx++)
+   {
+      my_escape(host, sizeof(host), targets[idx].host, MY_FORMAT_METRICS);
+      fprintf(fp, "udpecho_requests_total{target=\"%s\",address=\"%s\"} %" PRIu32 "\n", host, targets[idx].addrstr, stats[idx].sent);
+   };
+
+   fprintf(fp, "# HELP udpecho_responses_total Echo responses received, excluding duplicate, late, and corrupted responses.\n");
+   fprintf(fp, "# TYPE udpecho_responses_total counter\n");
+   for(idx = 0; (idx < targets_len); idx++)
+   {
+      my_escape(host, sizeof(host), targets[idx].host, MY_FORMAT_METRICS);
+      fprintf(fp, "udpecho_responses_total{target=\"%s\",address=\"%s\"} %" PRIu32 "\n", host, targets[idx].addrstr, stats[idx].rcvd);
+   };
+
+   fprintf(fp, "# HELP udpecho_responses_discarded_total Echo responses not counted as received.\n");
+   fprintf(fp, "# TYPE udpecho_responses_discarded_total counter\n");
+   for(idx = 0; (idx < targets_len); idx++)
+   {
+      tgt = &targets[idx];
+      st  = &stats[idx];
+      my_escape(host, sizeof(host), tgt->host, MY_FORMAT_METRICS);
+      fprintf(fp, "udpecho_responses_discarded_total{target=\"%s\",address=\"%s\",reason=\"duplicate\"} %" PRIu32 "\n", host, tgt->addrstr, st->dups);
+      fprintf(fp, "udpecho_responses_discarded_total{target=\"%s\",address=\"%s\",reason=\"late\"} %" PRIu32 "\n", host, tgt->addrstr, st->late);
+      fprintf(fp, "udpecho_responses_discarded_total{target=\"%s\",address=\"%s\",reason=\"corrupt\"} %" PRIu32 "\n", host, tgt->addrstr, st->corrupt);
+   };
+
+   fprintf(fp, "# HELP udpecho_responses_reordered_total Echo responses received after a higher sequence number.\n");
+   fprintf(fp, "# TYPE udpecho_responses_reordered_total counter\n");
+   for(idx = 0; (idx < targets_len); idx++)
+   {
+      my_escape(host, sizeof(host), targets[idx].host, MY_FORMAT_METRICS);
+      fprintf(fp, "udpecho_responses_reordered_total{target=\"%s\",address=\"%s\"} %" PRIu32 "\n", host, targets[idx].addrstr, stats[idx].reordered);
+   };
+
+   fprintf(fp, "# HELP udpecho_jitter_seconds RFC 3550 interarrival jitter of round-trip times.\n");
+   fprintf(fp, "# TYPE udpecho_jitter_seconds gauge\n");
+   for(idx = 0; (idx < targets_len); idx++)
+   {
+      my_escape(host, sizeof(host), targets[idx].host, MY_FORMAT_METRICS);
+      fprintf(fp, "udpecho_jitter_seconds{target=\"%s\",address=\"%s\"} %.6f\n", host, targets[idx].addrstr, stats[idx].jitter / 1000000.0);
+   };
+
+   // directional loss and failures are only known from echo plus counters
+   if ( (__atomic_load_n(&cnf_echoplus, __ATOMIC_RELAXED) == 1) && (!(cnf_stamp)) )
+   {
+      fprintf(fp, "# HELP udpecho_lost_total Echo requests lost, attributed by direction.\n");
+      fprintf(fp, "# TYPE udpecho_lost_total counter\n");
+      for(idx = 0; (idx < targets_len); idx++)
+      {
+         tgt = &targets[idx];
+         st  = &stats[idx];
+         my_escape(host, sizeof(host), tgt->host, MY_FORMAT_METRICS);
+         fprintf(fp, "udpecho_lost_total{target=\"%s\",address=\"%s\",direction=\"forward\"} %" PRIu32 "\n", host, tgt->addrstr, st->loss[MY_LOSS_FORWARD]);
+         fprintf(fp, "udpecho_lost_total{target=\"%s\",address=\"%s\",direction=\"return\"} %" PRIu32 "\n", host, tgt->addrstr, st->loss[MY_LOSS_RETURN]);
+         fprintf(fp, "udpecho_lost_total{target=\"%s\",address=\"%s\",direction=\"reflector\"} %" PRIu32 "\n", host, tgt->addrstr, st->loss[MY_LOSS_REFLECTOR]);
+      };
+
+      fprintf(fp, "# HELP udpecho_reflector_failures Reply failure count last reported by the reflector.\n");
+      fprintf(fp, "# TYPE udpecho_reflector_failures gauge\n");
+      for(idx = 0; (idx < targets_len); idx++)
+      {
+         my_escape(host, sizeof(host), targets[idx].host, MY_FORMAT_METRICS);
+         fprintf(fp, "udpecho_reflector_failures{target=\"%s\",address=\"%s\"} %" PRIu32 "\n", host, targets[idx].addrstr, stats[idx].loss_failures);
+      };
+   };
+
+   // histogram buckets are summed from the log-linear latency histogram
+   if ((stats[0].rtt_hist))
+   {
+      fprintf(fp, "# HELP udpecho_rtt_seconds Round-trip time of echo responses.\n");
+      fprintf(fp, "# TYPE udpecho_rtt_seconds histogram\n");
+      for(idx = 0; (idx < targets_len); idx++)
+      {
+         tgt = &targets[idx];
+         st  = &stats[idx];
+         my_escape(host, sizeof(host), tgt->host, MY_FORMAT_METRICS);
+         for(le = 0; (le < (sizeof(bounds) / sizeof(bounds[0]))); le++)
+            fprintf(fp, "udpecho_rtt_seconds_bucket{target=\"%s\",address=\"%s\",le=\"%g\"} %" PRIu64 "\n", host, tgt->addrstr, (double)bounds[le] / 1000000.0, akudp_hist_count_le(st->rtt_hist, bounds[le]));
+         fprintf(fp, "udpecho_rtt_seconds_bucket{target=\"%s\",address=\"%s\",le=\"+Inf\"} %" PRIu64 "\n", host, tgt->addrstr, akudp_hist_count(st->rtt_hist));
+         fprintf(fp, "udpecho_rtt_seconds_sum{target=\"%s\",address=\"%s\"} %.6f\n", host, tgt->addrstr, (double)st->rtt_sum / 1000000.0);
+         fprintf(fp, "udpecho_rtt_seconds_count{target=\"%s\",address=\"%s\"} %" PRIu64 "\n", host, tgt->addrstr, akudp_hist_count(st->rtt_hist));
+      };
+   };
+
+   if (fclose(fp) != 0)
+   {
+      free(text);
+      return;
+   };
+
+   free(metrics_text);
+   metrics_text = text;
+   metrics_len  = len;
+
+   return;
+}
+
+
+// answer HTTP request for metrics with most recent published snapshot
+void
+my_metrics_serve(
+         int                           fd )
+{
+   size_t                     len;
+   size_t                     off;
+   ssize_t                    ssize;
+   const char *               body;
+   const char *               status;
+   char                       req[MY_METRICS_REQ];
+   char                       hdr[256];
+   struct timeval             tv;
+
+   // a slow or idle client must not hold the endpoint
+   tv.tv_sec  = MY_METRICS_TIMEOUT;
+   tv.tv_usec = 0;
+   setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+   setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+   // read request headers, only the request line is used
+   off    = 0;
+   req[0] = '\0';
+   while ( (off < (sizeof(req) - 1)) && (strstr(req, "\r\n\r\n") == NULL) )
+   {
+      if ((ssize = recv(fd, &req[off], sizeof(req) - 1 - off, 0)) <= 0)
+         break;
+      off      += (size_t)ssize;
+      req[off]  = '\0';
+   };
+
+   // the probe threads publish snapshots without waiting for the response
+   body = NULL;
+   len  = 0;
+   if (strncmp(req, "GET ", 4) != 0)
+      status = "405 Method Not Allowed";
+   else if ( (strncmp(&req[4], "/metrics ", 9) != 0) && (strncmp(&req[4], "/metrics?", 9) != 0) )
+      status = "404 Not Found";
+   else
+   {
+      status = "200 OK";
+      my_metrics_render();
+      body   = metrics_text;
+      len    = metrics_len;
+   };
+
+   snprintf(hdr, sizeof(hdr),
+            "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+            status, len);
+   my_metrics_write(fd, hdr, strlen(hdr));
+   my_metrics_write(fd, body, len);
+
+   return;
+}
+
+
+// render and publish metrics of combined statistics
+
+// publish combined statistics of report to metrics endpoint
+void
+my_metrics_update(
+         my_report_t *                 r )
+{
+   my_stats_t *               stats;
+
+   // exchange buffers instead of rendering while the workers wait on the
+   // report, the endpoint renders the snapshot when it is scraped
+   pthread_mutex_lock(&metrics_mutex);
+   stats         = metrics_stats;
+   metrics_stats = r->stats;
+   metrics_fresh = 1;
+   pthread_mutex_unlock(&metrics_mutex);
+   r->stats      = stats;
+
+   return;
+}
+
+
+// write buffer to stream socket
+void
+my_metrics_write(
+         int                           fd,
+         const char *                  buff,
+         size_t                        len )
+{
+   size_t                     off;
+   ssize_t                    ssize;
+
+   for(off = 0; (off < len); off += (size_t)ssize)
+   {
+      if ((ssize = send(fd, &buff[off], len - off, MSG_NOSIGNAL)) > 0)
+         continue;
+      if ( (ssize == -1) && (errno == EINTR) )
+      {
+         ssize = 0;
+         continue;
+      };
+      return;
+   };
+
+   return;
+}
+
+
+// wait for socket events or until timeout in nanoseconds expires
+int
+my_poll(
+         struct pollfd *               fds,
+         nfds_t                        nfds,
+         uint64_t                      timeout )
+{
+#ifdef HAVE_PPOLL
+   struct timespec            ts;
+
+   ts.tv_sec  = (time_t)my_nsec2sec(timeout);
+   ts.tv_nsec = (long)(timeout % 1000000000ULL);
+   return(ppoll(fds, nfds, &ts, NULL));
+#else
+   // round up to avoid waking before deadline
+   return(poll(fds, nfds, (int)((timeout + 999999ULL) / 1000000ULL)));
+#endif
+}
+
+
+// send burst of requests to target, returns number of datagrams sent
+unsigned
+my_send(
+         int                           fd,
+         my_target_t *                 tgt,
+         char *                        buff,
+         const size_t *                lens,
+         unsigned                      count )
+{
+   unsigned                   sent;
+#ifdef HAVE_SENDMMSG
+   int                        len;
+   unsigned                   pos;
+   struct mmsghdr             msgs[MY_BURST_MAX];
+   struct iovec               iovs[MY_BURST_MAX];
+
+   // queue the whole burst with a single system call so requests leave
+   // back to back
+   memset(msgs, 0, sizeof(struct mmsghdr) * count);
+   for(pos = 0; (pos < count); pos++)
+   {
+      iovs[pos].iov_base            = &buff[pos * cnf_packetsize];
+      iovs[pos].iov_len             = ((lens)) ? lens[pos] : cnf_packetsize;
+      msgs[pos].msg_hdr.msg_name    = &tgt->sa;
+      msgs[pos].msg_hdr.msg_namelen = tgt->salen;
+      msgs[pos].msg_hdr.msg_iov     = &iovs[pos];
+      msgs[pos].msg_hdr.msg_iovlen  = 1;
+   };
+   for(sent = 0; (sent < count); sent += (unsigned)len)
+      if ((len = sendmmsg(fd, &msgs[sent], count - sent, 0)) <= 0)
+         break;
+#else
+   for(sent = 0; (sent < count); sent++)
+      if (sendto(fd, &buff[sent * cnf_packetsize], ((lens)) ? lens[sent] : cnf_packetsize, 0, &tgt->sa.sa, tgt->salen) == -1)
+         break;
+#endif
+
+   return(sent);
+}
+
+
+// allocate statistics of all targets
+my_stats_t *
+my_stats_alloc(
+         void )
+{
+   size_t                     pos;
+   my_stats_t *               stats;
+   my_stats_t *               st;
+
+   if ((stats = calloc(targets_len, sizeof(my_stats_t))) == NULL)
+      return(NULL);
+
+   // latency histograms are only kept for a limited number of targets to
+   // bound memory
+   for(pos = 0; (pos < targets_len); pos++)
+   {
+      st = &stats[pos];
+      if (cnf_burst > 1)
+      {
+         st->burst_rtt = calloc(cnf_burst, sizeof(uint64_t));
+         st->burst_cnt = calloc(cnf_burst, sizeof(uint32_t));
+         if ( (!(st->burst_rtt)) || (!(st->burst_cnt)) )
+         {
+            my_stats_free(stats);
+            return(NULL);
+         };
+      };
+      if (targets_len <= MY_HIST_TARGETS)
+      {
+         st->rtt_hist = akudp_hist_alloc();
+         st->adj_hist = akudp_hist_alloc();
+         if ( (!(st->rtt_hist)) || (!(st->adj_hist)) )
+         {
+            my_stats_free(stats);
+            return(NULL);
+         };
+      };
+      my_stats_reset(st);
+   };
+
+   return(stats);
+}
+
+
+// release statistics of all targets
+void
+my_stats_free(
+         my_stats_t *                  stats )
+{
+   size_t                     pos;
+
+   for(pos = 0; ( ((stats)) && (pos < targets_len) ); pos++)
+   {
+      akudp_hist_free(stats[pos].rtt_hist);
+      akudp_hist_free(stats[pos].adj_hist);
+      free(stats[pos].burst_rtt);
+      free(stats[pos].burst_cnt);
+      free(stats[pos].ktx);
+      free(stats[pos].stx);
+   };
+   free(stats);
+
+   return;
+}
+
+
+// print summary statistics of a single target
+void
+my_stats_print(
+         my_target_t *                 tgt,
+         my_stats_t *                  st )
+{
+   uint64_t                   jitter;
+   uint64_t                   pdv;
+   uint64_t                   ipdv_avg;
+   uint64_t                   lost;
+   uint64_t                   attributed;
+   int64_t                    host;
+   double                     drift;
+
+   printf("\n");
+   printf("--- %s udpecho statistics ---\n", tgt->host);
+   if ((st->sent))
+   {
+      printf("%" PRIu32 " packets transmitted, %" PRIu32 " packets received, %" PRIu64 ".%" PRIu64 "%% packet loss\n",
+             st->sent,
+             st->rcvd,
+             (st->rcvd >= st->sent) ? 0 : ((uint64_t)(st->sent - st->rcvd) * 100) / st->sent,
+             (st->rcvd >= st->sent) ? 0 : (((uint64_t)(st->sent - st->rcvd) * 1000) / st->sent) % 10
+      );
+   };
+   if ((st->corrupt))
+      printf("%" PRIu32 " corrupted replies discarded\n", st->corrupt);
+   if (!(st->rcvd))
+      return;
+
+   printf("round-trip min/avg/max = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms\n",
+          my_usec2msec(st->rtt_min),              my_usec2msec_tenths(st->rtt_min),
+          my_usec2msec(st->rtt_sum/st->rcvd),     my_usec2msec_tenths(st->rtt_sum/st->rcvd),
+          my_usec2msec(st->rtt_max),              my_usec2msec_tenths(st->rtt_max)
+   );
+   my_stats_quantiles("round-trip", st->rtt_hist, st->rtt_m2, st->rcvd);
+   if ((st->krtt_cnt))
+   {
+      host = st->host_sum / (int64_t)st->krtt_cnt;
+      printf("kernel round-trip min/avg/max = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms, host overhead avg = %" PRId64 " us (%" PRIu64 " samples)\n",
+             my_usec2msec(st->krtt_min),                 my_usec2msec_tenths(st->krtt_min),
+             my_usec2msec(st->krtt_sum/st->krtt_cnt),    my_usec2msec_tenths(st->krtt_sum/st->krtt_cnt),
+             my_usec2msec(st->krtt_max),                 my_usec2msec_tenths(st->krtt_max),
+             host, st->krtt_cnt
+      );
+   } else if ( (cnf_timestamping != MY_TS_NONE) && ((st->ktx)) )
+      printf("kernel round-trip unavailable, no kernel timestamps received\n");
+   printf("%" PRIu32 " duplicates, %" PRIu32 " reordered, %" PRIu32 " late\n", st->dups, st->reordered, st->late);
+   if ( (__atomic_load_n(&cnf_echoplus, __ATOMIC_RELAXED) == 1) && (!(cnf_stamp)) )
+   {
+      attributed = st->loss[MY_LOSS_FORWARD] + st->loss[MY_LOSS_RETURN] + st->loss[MY_LOSS_REFLECTOR];
+      lost       = (st->sent > st->rcvd) ? (st->sent - st->rcvd) : 0;
+      printf("loss forward/return/reflector/unattributed = %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu64 " packets\n",
+             st->loss[MY_LOSS_FORWARD], st->loss[MY_LOSS_RETURN], st->loss[MY_LOSS_REFLECTOR],
+             (lost > attributed) ? (lost - attributed) : 0
+      );
+      if ((st->loss_shared))
+         printf("loss attribution is incomplete, reflector counters are shared with other clients\n");
+   };
+   if (cnf_burst > 1)
+      my_stats_burst(st);
+   jitter   = (uint64_t)(st->jitter + 0.5);
+   // without a histogram PDV falls back to the maximum and is labelled so
+   pdv      = ((st->rtt_hist)) ? akudp_hist_quantile(st->rtt_hist, 0.99) : st->rtt_max;
+   pdv      = (pdv > st->rtt_min) ? (pdv - st->rtt_min) : 0;
+   ipdv_avg = ((st->ipdv_cnt)) ? (st->ipdv_abs_sum / st->ipdv_cnt) : 0;
+   printf("jitter = %" PRIu64 ".%" PRIu64 " ms, ipdv min/max = %s%" PRIu64 ".%" PRIu64 "/%s%" PRIu64 ".%" PRIu64 " ms, mean |ipdv| = %" PRIu64 ".%" PRIu64 " ms, %s = %" PRIu64 ".%" PRIu64 " ms\n",
+          my_usec2msec(jitter), my_usec2msec_tenths(jitter),
+          (st->ipdv_min < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(st->ipdv_min)), my_usec2msec_tenths((uint64_t)llabs(st->ipdv_min)),
+          (st->ipdv_max < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(st->ipdv_max)), my_usec2msec_tenths((uint64_t)llabs(st->ipdv_max)),
+          my_usec2msec(ipdv_avg), my_usec2msec_tenths(ipdv_avg),
+          ((st->rtt_hist)) ? "pdv p99" : "pdv max",
+          my_usec2msec(pdv), my_usec2msec_tenths(pdv)
+   );
+   if ((__atomic_load_n(&cnf_echoplus, __ATOMIC_RELAXED)))
+   {
+      printf("adjusted round-trip min/avg/max = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms\n",
+             my_usec2msec(st->adj_min),          my_usec2msec_tenths(st->adj_min),
+             my_usec2msec(st->adj_sum/st->rcvd), my_usec2msec_tenths(st->adj_sum/st->rcvd),
+             my_usec2msec(st->adj_max),          my_usec2msec_tenths(st->adj_max)
+      );
+      my_stats_quantiles("adjusted round-trip", st->adj_hist, st->adj_m2, st->rcvd);
+   };
+   if ((st->owd_cnt))
+   {
+      int64_t fwd_avg = st->fwd_sum / (int64_t)st->owd_cnt;
+      int64_t rev_avg = st->rev_sum / (int64_t)st->owd_cnt;
+      int64_t asym    = fwd_avg - rev_avg;
+      printf("one-way forward min/avg/max = %s%" PRIu64 ".%" PRIu64 "/%s%" PRIu64 ".%" PRIu64 "/%s%" PRIu64 ".%" PRIu64 " ms\n",
+             (st->fwd_min < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(st->fwd_min)), my_usec2msec_tenths((uint64_t)llabs(st->fwd_min)),
+             (fwd_avg     < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(fwd_avg)),     my_usec2msec_tenths((uint64_t)llabs(fwd_avg)),
+             (st->fwd_max < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(st->fwd_max)), my_usec2msec_tenths((uint64_t)llabs(st->fwd_max))
+      );
+      printf("one-way return min/avg/max = %s%" PRIu64 ".%" PRIu64 "/%s%" PRIu64 ".%" PRIu64 "/%s%" PRIu64 ".%" PRIu64 " ms\n",
+             (st->rev_min < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(st->rev_min)), my_usec2msec_tenths((uint64_t)llabs(st->rev_min)),
+             (rev_avg     < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(rev_avg)),     my_usec2msec_tenths((uint64_t)llabs(rev_avg)),
+             (st->rev_max < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(st->rev_max)), my_usec2msec_tenths((uint64_t)llabs(st->rev_max))
+      );
+      printf("one-way asymmetry (forward - return) avg = %s%" PRIu64 ".%" PRIu64 " ms\n",
+             (asym < 0) ? "-" : "", my_usec2msec((uint64_t)llabs(asym)), my_usec2msec_tenths((uint64_t)llabs(asym))
+      );
+      if ( ((cnf_stamp)) && (!(st->stamp_sync)) )
+         printf("one-way delays are unreliable, clocks are not synchronized\n");
+      if ( (!(cnf_stamp)) && (my_clock_drift(st, &drift) == 0) )
+         printf("one-way delays are estimated from server clock offset, drift = %.1f ppm (%" PRIu32 " filtered samples)\n", drift, st->clk_n);
+      else if (!(cnf_stamp))
+         printf("one-way delays are estimated from server clock offset, drift = - (%" PRIu32 " filtered samples)\n", st->clk_n);
+   };
+
+   return;
+}
+
+
+// merge statistics of a target
+void
+my_stats_merge(
+         my_stats_t *                  dst,
+         const my_stats_t *            src )
+{
+   double                     n;
+   double                     delta;
+   unsigned                   pos;
+
+   if ( ((src->rcvd)) && ( (!(dst->rcvd)) || (src->rtt_min < dst->rtt_min) ) )
+      dst->rtt_min = src->rtt_min;
+   if ( ((src->rcvd)) && ( (!(dst->rcvd)) || (src->adj_min < dst->adj_min) ) )
+      dst->adj_min = src->adj_min;
+   dst->rtt_max    = (src->rtt_max > dst->rtt_max) ? src->rtt_max : dst->rtt_max;
+   dst->adj_max    = (src->adj_max > dst->adj_max) ? src->adj_max : dst->adj_max;
+   dst->fwd_min    = (src->fwd_min < dst->fwd_min) ? src->fwd_min : dst->fwd_min;
+   dst->fwd_max    = (src->fwd_max > dst->fwd_max) ? src->fwd_max : dst->fwd_max;
+   dst->rev_min    = (src->rev_min < dst->rev_min) ? src->rev_min : dst->rev_min;
+   dst->rev_max    = (src->rev_max > dst->rev_max) ? src->rev_max : dst->rev_max;
+   if ((src->rcvd))
+   {
+      // combine running variance (Chan et al.)
+      n               = (double)dst->rcvd + (double)src->rcvd;
+      delta           = src->rtt_mean - dst->rtt_mean;
+      dst->rtt_m2    += src->rtt_m2 + ((delta * delta) * (double)dst->rcvd * (double)src->rcvd / n);
+      dst->rtt_mean  += delta * (double)src->rcvd / n;
+      delta           = src->adj_mean - dst->adj_mean;
+      dst->adj_m2    += src->adj_m2 + ((delta * delta) * (double)dst->rcvd * (double)src->rcvd / n);
+      dst->adj_mean  += delta * (double)src->rcvd / n;
+   };
+   if ( ((dst->rtt_hist)) && ((src->rtt_hist)) )
+   {
+      akudp_hist_merge(dst->rtt_hist, src->rtt_hist);
+      akudp_hist_merge(dst->adj_hist, src->adj_hist);
+   };
+   // RFC 3550 jitter is a running filter that can not be combined, the count
+   // weighted mean of the threads' jitter is only an approximation
+   if ((src->jitter_cnt))
+      dst->jitter = ((dst->jitter * (double)dst->jitter_cnt) + (src->jitter * (double)src->jitter_cnt))
+                  / ((double)dst->jitter_cnt + (double)src->jitter_cnt);
+   if ((src->ipdv_cnt))
+   {
+      dst->ipdv_min = ( (!(dst->ipdv_cnt)) || (src->ipdv_min < dst->ipdv_min) ) ? src->ipdv_min : dst->ipdv_min;
+      dst->ipdv_max = ( (!(dst->ipdv_cnt)) || (src->ipdv_max > dst->ipdv_max) ) ? src->ipdv_max : dst->ipdv_max;
+   };
+   dst->jitter_cnt   += src->jitter_cnt;
+   dst->jitter_abs_sum += src->jitter_abs_sum;
+   dst->jitter_abs_cnt += src->jitter_abs_cnt;
+   dst->ipdv_abs_sum += src->ipdv_abs_sum;
+   dst->ipdv_cnt     += src->ipdv_cnt;
+   dst->dups         += src->dups;
+   dst->reordered    += src->reordered;
+   dst->late         += src->late;
+   dst->corrupt      += src->corrupt;
+   dst->tos_rcvd     += src->tos_rcvd;
+   dst->tos_remarked += src->tos_remarked;
+   dst->tos_ce       += src->tos_ce;
+   dst->loss[MY_LOSS_FORWARD]   += src->loss[MY_LOSS_FORWARD];
+   dst->loss[MY_LOSS_RETURN]    += src->loss[MY_LOSS_RETURN];
+   dst->loss[MY_LOSS_REFLECTOR] += src->loss[MY_LOSS_REFLECTOR];
+   dst->loss_shared  |= src->loss_shared;
+   dst->loss_failures = (src->loss_failures > dst->loss_failures) ? src->loss_failures : dst->loss_failures;
+   if ((src->disp_cnt))
+   {
+      dst->disp_min = ( (!(dst->disp_cnt)) || (src->disp_min < dst->disp_min) ) ? src->disp_min : dst->disp_min;
+      dst->disp_max = (src->disp_max > dst->disp_max) ? src->disp_max : dst->disp_max;
+   };
+   dst->disp_sum     += src->disp_sum;
+   dst->disp_bytes   += src->disp_bytes;
+   dst->disp_cnt     += src->disp_cnt;
+   dst->bursts_sent  += src->bursts_sent;
+   dst->bursts       += src->bursts;
+   dst->bursts_lossy += src->bursts_lossy;
+   for(pos = 0; ( ((dst->burst_rtt)) && ((src->burst_rtt)) && (pos < cnf_burst) ); pos++)
+   {
+      dst->burst_rtt[pos] += src->burst_rtt[pos];
+      dst->burst_cnt[pos] += src->burst_cnt[pos];
+   };
+   if ((src->krtt_cnt))
+   {
+      dst->krtt_min = ( (!(dst->krtt_cnt)) || (src->krtt_min < dst->krtt_min) ) ? src->krtt_min : dst->krtt_min;
+      dst->krtt_max = (src->krtt_max > dst->krtt_max) ? src->krtt_max : dst->krtt_max;
+   };
+   if (src->clk_n > dst->clk_n)
+   {
+      // each thread estimates the server clock separately, keep the
+      // estimate with the most filtered samples
+      dst->clk_n   = src->clk_n;
+      dst->clk_span = src->clk_span;
+      dst->clk_t0  = src->clk_t0;
+      dst->clk_st  = src->clk_st;
+      dst->clk_so  = src->clk_so;
+      dst->clk_stt = src->clk_stt;
+      dst->clk_sto = src->clk_sto;
+   };
+   dst->krtt_sum  += src->krtt_sum;
+   dst->krtt_cnt  += src->krtt_cnt;
+   dst->host_sum  += src->host_sum;
+   dst->seq       += src->seq;
+   dst->sent      += src->sent;
+   dst->rcvd      += src->rcvd;
+   dst->rtt_sum   += src->rtt_sum;
+   dst->adj_sum   += src->adj_sum;
+   dst->fwd_sum   += src->fwd_sum;
+   dst->rev_sum   += src->rev_sum;
+   dst->owd_cnt   += src->owd_cnt;
+   dst->stamp_sync = ( ((dst->stamp_sync)) && ((src->stamp_sync)) ) ? 1 : 0;
+
+   return;
+}
+
+
+// print burst loss, dispersion, and round-trip by position in burst
+void
+my_stats_burst(
+         my_stats_t *                  st )
+{
+   unsigned                   pos;
+   uint64_t                   avg;
+
+   printf("%" PRIu32 " burst%s of %u, %" PRIu32 " with loss",
+          st->bursts_sent, (st->bursts_sent == 1) ? "" : "s", cnf_burst,
+          st->bursts_lossy + (st->bursts_sent - st->bursts)
+   );
+   if ((st->disp_cnt))
+   {
+      // dispersion is reported in microseconds, loopback and LAN bursts
+      // complete well under the 0.1 ms resolution of other statistics
+      printf(", dispersion min/avg/max = %" PRIu64 "/%" PRIu64 "/%" PRIu64 " us",
+             my_nsec2usec(st->disp_min),
+             my_nsec2usec((st->disp_sum / st->disp_cnt)),
+             my_nsec2usec(st->disp_max)
+      );
+      if ((st->disp_sum))
+         printf(", rate = %" PRIu64 " Mbit/s", (st->disp_bytes * 8000) / st->disp_sum);
+   } else if (cnf_timestamping == MY_TS_NONE)
+   {
+      // userspace arrival times of a recvmmsg() batch are nearly equal and
+      // would measure batch processing instead of the path
+      printf(", dispersion requires -K");
+   };
+   printf("\n");
+
+   // positions without responses are not reported as zero round-trip
+   printf("burst position avg round-trip =");
+   for(pos = 0; (pos < cnf_burst); pos++)
+   {
+      if (!(st->burst_cnt[pos]))
+      {
+         printf("%s-", ((pos)) ? "/" : " ");
+         continue;
+      };
+      avg = st->burst_rtt[pos] / st->burst_cnt[pos];
+      printf("%s%" PRIu64 ".%" PRIu64, ((pos)) ? "/" : " ", my_usec2msec(avg), my_usec2msec_tenths(avg));
+   };
+   printf(" ms\n");
+
+   return;
+}
+
+
+// print latency quantiles and standard deviation
+void
+my_stats_quantiles(
+         const char *                  label,
+         const akudp_hist_t *          hist,
+         double                        m2,
+         uint32_t                      count )
+{
+   uint64_t                   p50;
+   uint64_t                   p90;
+   uint64_t                   p99;
+   uint64_t                   p999;
+   uint64_t                   stddev;
+
+   stddev = (count > 1) ? (uint64_t)(sqrt(m2 / (double)(count - 1)) + 0.5) : 0;
+   if (!(hist))
+   {
+      printf("%s stddev = %" PRIu64 ".%" PRIu64 " ms\n", label, my_usec2msec(stddev), my_usec2msec_tenths(stddev));
+      return;
+   };
+
+   p50  = akudp_hist_quantile(hist, 0.50);
+   p90  = akudp_hist_quantile(hist, 0.90);
+   p99  = akudp_hist_quantile(hist, 0.99);
+   p999 = akudp_hist_quantile(hist, 0.999);
+   printf("%s p50/p90/p99/p99.9/stddev = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms\n",
+          label,
+          my_usec2msec(p50),    my_usec2msec_tenths(p50),
+          my_usec2msec(p90),    my_usec2msec_tenths(p90),
+          my_usec2msec(p99),    my_usec2msec_tenths(p99),
+          my_usec2msec(p999),   my_usec2msec_tenths(p999),
+          my_usec2msec(stddev), my_usec2msec_tenths(stddev)
+   );
+
+   return;
+}
+
+
+// record one-way delays of accepted response
+void
+my_stats_owd(
+         my_stats_t *                  st,
+         int64_t                       owd_fwd,
+         int64_t                       owd_rev )
+{
+   st->fwd_sum += owd_fwd;
+   st->rev_sum += owd_rev;
+   st->fwd_min  = (owd_fwd < st->fwd_min) ? owd_fwd : st->fwd_min;
+   st->fwd_max  = (owd_fwd > st->fwd_max) ? owd_fwd : st->fwd_max;
+   st->rev_min  = (owd_rev < st->rev_min) ? owd_rev : st->rev_min;
+   st->rev_max  = (owd_rev > st->rev_max) ? owd_rev : st->rev_max;
+   st->owd_cnt++;
+   return;
+}
+
+
+// record latency of accepted response
+void
+my_stats_record(
+         my_stats_t *                  st,
+         uint32_t                      seq,
+         uint64_t                      rtt,
+         uint64_t                      rtt_adj )
+{
+   int64_t                    ipdv;
+
+   st->rcvd++;
+   st->rtt_sum  += rtt;
+   st->adj_sum  += rtt_adj;
+
+   akudp_welford(&st->rtt_mean, &st->rtt_m2, st->rcvd, (double)rtt);
+   akudp_welford(&st->adj_mean, &st->adj_m2, st->rcvd, (double)rtt_adj);
+   if ((st->rtt_hist))
+   {
+      akudp_hist_record(st->rtt_hist, rtt);
+      akudp_hist_record(st->adj_hist, rtt_adj);
+   };
+   st->rtt_min   = ( (st->rcvd == 1) || (rtt < st->rtt_min) ) ? rtt : st->rtt_min;
+   st->rtt_max   = ( (st->rcvd == 1) || (rtt > st->rtt_max) ) ? rtt : st->rtt_max;
+   st->adj_min   = ( (st->rcvd == 1) || (rtt_adj < st->adj_min) ) ? rtt_adj : st->adj_min;
+   st->adj_max   = ( (st->rcvd == 1) || (rtt_adj > st->adj_max) ) ? rtt_adj : st->adj_max;
+
+   // RFC 3550 interarrival jitter of round-trip times in arrival order and
+   // RFC 5481 inter-packet delay variation of consecutive sequence numbers
+   if ((st->jitter_cnt++))
+   {
+      ipdv        = (int64_t)rtt - (int64_t)st->last_rtt;
+      st->jitter  = akudp_jitter(st->jitter, ipdv);
+      st->jitter_abs_sum += (uint64_t)llabs(ipdv);
+      st->jitter_abs_cnt++;
+      if (seq == (st->last_seq + 1))
+      {
+         st->ipdv_min      = ( (!(st->ipdv_cnt)) || (ipdv < st->ipdv_min) ) ? ipdv : st->ipdv_min;
+         st->ipdv_max      = ( (!(st->ipdv_cnt)) || (ipdv > st->ipdv_max) ) ? ipdv : st->ipdv_max;
+         st->ipdv_abs_sum += (uint64_t)llabs(ipdv);
+         st->ipdv_cnt++;
+      };
+   };
+   st->last_seq = seq;
+   st->last_rtt = rtt;
+
+   return;
+}
+
+
+// clear statistics of a target, keeps allocated histograms and arrays
+void
+my_stats_reset(
+         my_stats_t *                  st )
+{
+   akudp_hist_t *                rtt_hist;
+   akudp_hist_t *                adj_hist;
+   uint64_t *                 burst_rtt;
+   uint32_t *                 burst_cnt;
+   int64_t *                  ktx;
+   int64_t *                  stx;
+
+   rtt_hist  = st->rtt_hist;
+   adj_hist  = st->adj_hist;
+   burst_rtt = st->burst_rtt;
+   burst_cnt = st->burst_cnt;
+   ktx       = st->ktx;
+   stx       = st->stx;
+
+   memset(st, 0, sizeof(my_stats_t));
+   if ((rtt_hist))
+      akudp_hist_reset(rtt_hist);
+   if ((adj_hist))
+      akudp_hist_reset(adj_hist);
+   if ((burst_rtt))
+      memset(burst_rtt, 0, cnf_burst * sizeof(uint64_t));
+   if ((burst_cnt))
+      memset(burst_cnt, 0, cnf_burst * sizeof(uint32_t));
+   if ((ktx))
+      memset(ktx, 0, MY_SEQ_WINDOW * sizeof(int64_t));
+
+   st->rtt_hist   = rtt_hist;
+   st->adj_hist   = adj_hist;
+   st->burst_rtt  = burst_rtt;
+   st->burst_cnt  = burst_cnt;
+   st->ktx        = ktx;
+   st->stx        = stx;
+   st->fwd_min    = INT64_MAX;
+   st->fwd_max    = INT64_MIN;
+   st->rev_min    = INT64_MAX;
+   st->rev_max    = INT64_MIN;
+   st->stamp_sync = 1;
+
+   return;
+}
+
+
+// print summary of all targets in selected output format
+void
+my_stats_summary(
+         my_stats_t *                  stats )
+{
+   size_t                     pos;
+
+   if (cnf_format != MY_FORMAT_TEXT)
+   {
+      for(pos = 0; (pos < targets_len); pos++)
+         my_record_summary(&targets[pos], &stats[pos]);
+   } else if ((cnf_multi))
+   {
+      my_stats_table(stats);
+      if ((cnf_all_addrs))
+         my_stats_family(stats);
+      if ((cnf_tos_len))
+         my_stats_class(stats);
+   } else
+      my_stats_print(&targets[0], &stats[0]);
+   fflush(stdout);
+
+   return;
+}
+
+
+// compare address families of hosts probed at every address
+void
+my_stats_family(
+         my_stats_t *                  stats )
+{
+   size_t                     idx;
+   size_t                     pos;
+   size_t                     fam;
+   int                        header;
+   uint64_t                   sent[2];
+   uint64_t                   rcvd[2];
+   uint64_t                   rtt_sum[2];
+   uint64_t                   loss[2];
+   uint64_t                   avg[2];
+   double                     jitter[2];
+   int64_t                    diff;
+
+   // targets of a host and traffic class are adjacent, IPv6 addresses first
+   header = 0;
+   for(idx = 0; (idx < targets_len); idx = pos)
+   {
+      memset(sent,    0, sizeof(sent));
+      memset(rcvd,    0, sizeof(rcvd));
+      memset(rtt_sum, 0, sizeof(rtt_sum));
+      memset(jitter,  0, sizeof(jitter));
+      for(pos = idx; ( (pos < targets_len) && (targets[pos].cls == targets[idx].cls) && (!(strcmp(targets[pos].host, targets[idx].host))) ); pos++)
+      {
+         fam           = (targets[pos].sa.sa.sa_family == AF_INET6) ? 1 : 0;
+         sent[fam]    += stats[pos].sent;
+         rcvd[fam]    += stats[pos].rcvd;
+         rtt_sum[fam] += stats[pos].rtt_sum;
+         jitter[fam]   = (stats[pos].jitter > jitter[fam]) ? stats[pos].jitter : jitter[fam];
+      };
+      if ( (!(sent[0])) || (!(sent[1])) )
+         continue;
+
+      if (!(header))
+      {
+         printf("\n");
+         printf("--- IPv6 compared to IPv4 ---\n");
+         printf("%-32s %10s %10s %10s %10s %10s %10s\n", "host", "loss v6", "loss v4", "avg v6", "avg v4", "avg diff", "jit diff");
+         header = 1;
+      };
+      for(fam = 0; (fam < 2); fam++)
+      {
+         loss[fam] = (rcvd[fam] >= sent[fam]) ? 0 : (((sent[fam] - rcvd[fam]) * 1000) / sent[fam]);
+         avg[fam]  = ((rcvd[fam])) ? (rtt_sum[fam] / rcvd[fam]) : 0;
+      };
+      printf("%-32s %7" PRIu64 ".%" PRIu64 "%% %7" PRIu64 ".%" PRIu64 "%%",
+             targets[idx].host,
+             loss[1] / 10, loss[1] % 10,
+             loss[0] / 10, loss[0] % 10
+      );
+      if ( (!(rcvd[0])) || (!(rcvd[1])) )
+      {
+         printf(" %10s %10s %10s %10s\n", "-", "-", "-", "-");
+         continue;
+      };
+      printf(" %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms",
+             my_usec2msec(avg[1]), my_usec2msec_tenths(avg[1]),
+             my_usec2msec(avg[0]), my_usec2msec_tenths(avg[0])
+      );
+      diff = (int64_t)avg[1] - (int64_t)avg[0];
+      printf(" %5s%" PRIu64 ".%" PRIu64 "ms", (diff < 0) ? "-" : "+", my_usec2msec((uint64_t)llabs(diff)), my_usec2msec_tenths((uint64_t)llabs(diff)));
+      diff = (int64_t)(jitter[1] + 0.5) - (int64_t)(jitter[0] + 0.5);
+      printf(" %5s%" PRIu64 ".%" PRIu64 "ms\n", (diff < 0) ? "-" : "+", my_usec2msec((uint64_t)llabs(diff)), my_usec2msec_tenths((uint64_t)llabs(diff)));
+   };
+
+   return;
+}
+
+
+// compare traffic classes of all targets
+void
+my_stats_class(
+         my_stats_t *                  stats )
+{
+   size_t                     idx;
+   unsigned                   cls;
+   uint64_t                   sent;
+   uint64_t                   rcvd;
+   uint64_t                   rtt_sum;
+   uint64_t                   loss;
+   uint64_t                   avg;
+   uint64_t                   jitter;
+   uint64_t                   tos_rcvd;
+   uint64_t                   remarked;
+   uint64_t                   ce;
+   double                     jitter_max;
+   my_stats_t *               st;
+
+   printf("\n");
+   printf("--- traffic classes ---\n");
+   printf("%-8s %6s %8s %8s %6s %10s %10s %9s %8s\n", "class", "dscp", "sent", "rcvd", "loss", "avg", "jitter", "remarked", "ce");
+   for(cls = 0; (cls < cnf_tos_len); cls++)
+   {
+      sent       = 0;
+      rcvd       = 0;
+      rtt_sum    = 0;
+      tos_rcvd   = 0;
+      remarked   = 0;
+      ce         = 0;
+      jitter_max = 0.0;
+      for(idx = cls * targets_base; (idx < ((cls + 1) * targets_base)); idx++)
+      {
+         st          = &stats[idx];
+         sent       += st->sent;
+         rcvd       += st->rcvd;
+         rtt_sum    += st->rtt_sum;
+         tos_rcvd   += st->tos_rcvd;
+         remarked   += st->tos_remarked;
+         ce         += st->tos_ce;
+         jitter_max  = (st->jitter > jitter_max) ? st->jitter : jitter_max;
+      };
+      loss = ( (!(sent)) || (rcvd >= sent) ) ? 0 : (((sent - rcvd) * 1000) / sent);
+      printf("%-8s %6i %8" PRIu64 " %8" PRIu64 " %3" PRIu64 ".%" PRIu64 "%%",
+             cnf_tos_name[cls],
+             cnf_tos[cls] >> 2,
+             sent,
+             rcvd,
+             loss / 10, loss % 10
+      );
+      if (!(rcvd))
+      {
+         printf(" %10s %10s %9s %8s\n", "-", "-", "-", "-");
+         continue;
+      };
+      avg    = rtt_sum / rcvd;
+      jitter = (uint64_t)(jitter_max + 0.5);
+      printf(" %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms",
+             my_usec2msec(avg),    my_usec2msec_tenths(avg),
+             my_usec2msec(jitter), my_usec2msec_tenths(jitter)
+      );
+      if (!(tos_rcvd))
+      {
+         printf(" %9s %8s\n", "-", "-");
+         continue;
+      };
+      printf(" %8" PRIu64 "%% %8" PRIu64 "\n", (remarked * 100) / tos_rcvd, ce);
+   };
+
+   return;
+}
+
+
+// print summary statistics table of all targets
+void
+my_stats_table(
+         my_stats_t *                  stats )
+{
+   size_t                     idx;
+   my_stats_t *               st;
+   uint64_t                   avg;
+   uint64_t                   jitter;
+   uint64_t                   p50;
+   uint64_t                   p99;
+
+   printf("\n");
+   printf("--- udpecho statistics ---\n");
+   printf("%-32s %-24s %8s %8s %6s %10s %10s %10s %10s %10s %10s\n", "host", "address", "sent", "rcvd", "loss", "min", "avg", "max", "jitter", "p50", "p99");
+   for(idx = 0; (idx < targets_len); idx++)
+   {
+      st = &stats[idx];
+      printf("%-32s %-24s %8" PRIu32 " %8" PRIu32 " %3" PRIu64 ".%" PRIu64 "%%",
+             targets[idx].host,
+             targets[idx].addrstr,
+             st->sent,
+             st->rcvd,
+             ( (!(st->sent)) || (st->rcvd >= st->sent) ) ? 0 : ((uint64_t)(st->sent - st->rcvd) * 100) / st->sent,
+             ( (!(st->sent)) || (st->rcvd >= st->sent) ) ? 0 : (((uint64_t)(st->sent - st->rcvd) * 1000) / st->sent) % 10
+      );
+      if (!(st->rcvd))
+      {
+         printf(" %10s %10s %10s %10s %10s %10s\n", "-", "-", "-", "-", "-", "-");
+         continue;
+      };
+      avg    = st->rtt_sum / st->rcvd;
+      jitter = (uint64_t)(st->jitter + 0.5);
+      printf(" %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms",
+             my_usec2msec(st->rtt_min), my_usec2msec_tenths(st->rtt_min),
+             my_usec2msec(avg),         my_usec2msec_tenths(avg),
+             my_usec2msec(st->rtt_max), my_usec2msec_tenths(st->rtt_max),
+             my_usec2msec(jitter),      my_usec2msec_tenths(jitter)
+      );
+      if (!(st->rtt_hist))
+      {
+         printf(" %10s %10s\n", "-", "-");
+         continue;
+      };
+      p50 = akudp_hist_quantile(st->rtt_hist, 0.50);
+      p99 = akudp_hist_quantile(st->rtt_hist, 0.99);
+      printf(" %6" PRIu64 ".%" PRIu64 "ms %6" PRIu64 ".%" PRIu64 "ms\n",
+             my_usec2msec(p50), my_usec2msec_tenths(p50),
+             my_usec2msec(p99), my_usec2msec_tenths(p99)
+      );
+   };
+
+   return;
+}
+
+
+// step request size through range with fragmentation disabled
+int
+my_sweep(
+         my_target_t *                 tgt,
+         echoplus_t *                  tmpl )
+{
+   int                        fd;
+   int                        opt;
+   int                        rc;
+   int                        mtu;
+   size_t                     hdr;
+   size_t                     size;
+   size_t                     good;
+   size_t                     bad;
+   size_t                     len;
+   size_t                     idx;
+   uint32_t                   seq;
+   uint64_t                   sent;
+   uint64_t                   rcvd;
+   uint64_t                   avg;
+   double                     n;
+   double                     sx;
+   double                     sy;
+   double                     sxx;
+   double                     sxy;
+   double                     slope;
+   char *                     rcvbuff;
+   my_sweep_t *               results;
+   my_sweep_t *               res;
+#if defined(IP_MTU) && defined(IPV6_MTU)
+   socklen_t                  optlen;
+#endif
+
+   // connected socket reports path MTU updates from ICMP errors
+   if ((fd = my_socket(tgt->sa.sa.sa_family, -1)) == -1)
+      return(1);
+   if (connect(fd, &tgt->sa.sa, tgt->salen) == -1)
+   {
+      fprintf(stderr, "%s: connect(): %s\n", prog_name, strerror(errno));
+      close(fd);
+      return(1);
+   };
+
+   // set DF so oversized requests are rejected or dropped instead of
+   // fragmented
+   rc = 0;
+   if (tgt->sa.sa.sa_family == AF_INET6)
+   {
+#if defined(IPV6_MTU_DISCOVER)
+      opt = IPV6_PMTUDISC_DO;
+      rc  = setsockopt(fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, (void *)&opt, sizeof(int));
+#elif defined(IPV6_DONTFRAG)
+      opt = 1;
+      rc  = setsockopt(fd, IPPROTO_IPV6, IPV6_DONTFRAG, (void *)&opt, sizeof(int));
+#endif
+   } else {
+#if defined(IP_MTU_DISCOVER)
+      opt = IP_PMTUDISC_DO;
+      rc  = setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, (void *)&opt, sizeof(int));
+#elif defined(IP_DONTFRAG)
+      opt = 1;
+      rc  = setsockopt(fd, IPPROTO_IP, IP_DONTFRAG, (void *)&opt, sizeof(int));
+#endif
+   };
+   if (rc == -1)
+   {
+      fprintf(stderr, "%s: setsockopt(DF): %s\n", prog_name, strerror(errno));
+      close(fd);
+      return(1);
+   };
+
+   // linear sweep plus bisection of the boundary, at most 17 steps
+   len     = ((cnf_sweep_max - cnf_sweep_min) / cnf_sweep_step) + 2 + 17;
+   rcvbuff = malloc(cnf_sweep_max);
+   results = calloc(len, sizeof(my_sweep_t));
+   if ( (!(rcvbuff)) || (!(results)) )
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+      free(rcvbuff);
+      free(results);
+      close(fd);
+      return(1);
+   };
+
+   // IP and UDP header bytes count toward the MTU
+   hdr = (tgt->sa.sa.sa_family == AF_INET6) ? 48 : 28;
+
+   if (!(cnf_silent))
+      printf("UDPECHO sweep %s (%s): %zu to %zu bytes, step %zu, %" PRIu32 " requests per size\n",
+             tgt->host, tgt->addrstr, cnf_sweep_min, cnf_sweep_max, cnf_sweep_step, cnf_count);
+
+   // step sizes up until a size is not answered, then bisect between the
+   // largest answered size and the first unanswered size
+   seq  = 1;
+   len  = 0;
+   good = 0;
+   bad  = 0;
+   size = cnf_sweep_min;
+   while (!(should_stop))
+   {
+      if ( ((bad)) && ((bad - good) <= 1) )
+         break;
+      res       = &results[len++];
+      res->size = size;
+      if ((my_sweep_probe(fd, tmpl, rcvbuff, &seq, res)))
+         break;
+
+      if (!(cnf_silent))
+      {
+         printf("size %zu (%zu bytes on wire): %" PRIu32 "/%" PRIu32 " received", res->size, res->size + hdr, res->rcvd, res->sent);
+         if ((res->rcvd))
+         {
+            avg = res->rtt_sum / res->rcvd;
+            printf(", rtt min/avg/max = %" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 "/%" PRIu64 ".%" PRIu64 " ms",
+                   my_usec2msec(res->rtt_min), my_usec2msec_tenths(res->rtt_min),
+                   my_usec2msec(avg),          my_usec2msec_tenths(avg),
+                   my_usec2msec(res->rtt_max), my_usec2msec_tenths(res->rtt_max)
+            );
+         };
+         printf("%s\n", ((res->toobig)) ? ", exceeds path MTU" : "");
+         fflush(stdout);
+      };
+
+      if ((res->rcvd))
+         good = size;
+      else
+         bad  = size;
+      if ((bad))
+         size = good + ((bad - good) / 2);
+      else if (size == cnf_sweep_max)
+         break;
+      else
+         size = ((cnf_sweep_max - size) > cnf_sweep_step) ? (size + cnf_sweep_step) : cnf_sweep_max;
+      if ( ((bad)) && (!(good)) )
+         break;
+   };
+
+   // fit round-trip to size, minimum round-trips exclude queuing delay
+   n     = 0.0;
+   sx    = 0.0;
+   sy    = 0.0;
+   sxx   = 0.0;
+   sxy   = 0.0;
+   sent  = 0;
+   rcvd  = 0;
+   for(idx = 0; (idx < len); idx++)
+   {
+      res   = &results[idx];
+      sent += res->sent;
+      rcvd += res->rcvd;
+      if (!(res->rcvd))
+         continue;
+      n   += 1.0;
+      sx  += (double)res->size;
+      sy  += (double)res->rtt_min;
+      sxx += (double)res->size * (double)res->size;
+      sxy += (double)res->size * (double)res->rtt_min;
+   };
+   slope = ( (n > 1.0) && (((n * sxx) - (sx * sx)) > 0.0) ) ? (((n * sxy) - (sx * sy)) / ((n * sxx) - (sx * sx))) : 0.0;
+
+   // kernel path MTU includes updates from ICMP fragmentation needed
+   mtu = 0;
+#if defined(IP_MTU) && defined(IPV6_MTU)
+   optlen = sizeof(int);
+   if (getsockopt(fd, ((tgt->sa.sa.sa_family == AF_INET6) ? IPPROTO_IPV6 : IPPROTO_IP), ((tgt->sa.sa.sa_family == AF_INET6) ? IPV6_MTU : IP_MTU), (void *)&mtu, &optlen) == -1)
+      mtu = 0;
+#endif
+
+   if (!(cnf_silent))
+   {
+      printf("\n");
+      printf("--- %s size sweep statistics ---\n", tgt->host);
+      printf("%zu sizes probed, %" PRIu64 " packets transmitted, %" PRIu64 " packets received\n", len, sent, rcvd);
+      if (slope > 0.0)
+         printf("rtt slope = %.4f us/byte, serialization rate = %.1f Mbit/s (symmetric path)\n", slope, 16.0 / slope);
+      if (!(good))
+         printf("path MTU unknown, no size answered");
+      else if ((bad))
+         printf("path MTU = %zu bytes (%zu byte payload)", good + hdr, good);
+      else
+         printf("path MTU >= %zu bytes (largest size probed)", good + hdr);
+      if ((mtu))
+         printf(", kernel path MTU = %i bytes", mtu);
+      printf("\n");
+   };
+
+   free(rcvbuff);
+   free(results);
+   close(fd);
+
+   return(0);
+}
+
+
+// send requests of a single size and collect responses
+int
+my_sweep_probe(
+         int                           fd,
+         echoplus_t *                  tmpl,
+         char *                        rcvbuff,
+         uint32_t *                    seqp,
+         my_sweep_t *                  res )
+{
+   uint32_t                   first;
+   uint32_t                   pos;
+   uint32_t                   n;
+   ssize_t                    ssize;
+   int64_t                    delta;
+   uint64_t                   rtt;
+   uint64_t                   now_nsec;
+   uint64_t                   due;
+   uint64_t                   end;
+   uint8_t *                  seen;
+   echoplus_t *               resp;
+   akudp_echoplus_t           msg;
+   struct timespec            now;
+   struct pollfd              fds[2];
+
+   if ((seen = calloc(cnf_count, sizeof(uint8_t))) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+      return(-1);
+   };
+
+   fds[0].fd     = fd;
+   fds[0].events = POLLIN;
+   fds[1].fd     = stop_pipe[0];
+   fds[1].events = POLLIN;
+
+   clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+   first = *seqp;
+   due   = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
+   end   = 0;
+   n     = 0;
+
+   while (!(should_stop))
+   {
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+      now_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
+
+      // send next request, a request larger than the known path MTU is
+      // rejected by the kernel and ends the size
+      if ( (n < cnf_count) && (!(res->toobig)) && (now_nsec >= due) )
+      {
+         akudp_echoplus_decode(&msg, tmpl->hdr, sizeof(tmpl->hdr));
+         msg.req_sn              = first + n;
+         akudp_echoplus_encode(tmpl->hdr, sizeof(tmpl->hdr), &msg);
+         tmpl->send_time.tv_sec  = now.tv_sec;
+         tmpl->send_time.tv_nsec = now.tv_nsec;
+         if (send(fd, tmpl, res->size, 0) != -1)
+            res->sent++;
+         else if (errno == EMSGSIZE)
+            res->toobig = 1;
+         n++;
+         due += cnf_interval;
+         if ( (n == cnf_count) || ((res->toobig)) )
+            end = now_nsec + my_sec2nsec((uint64_t)cnf_timeout);
+         continue;
+      };
+
+      // wait for outstanding responses after the last request
+      if ( (!(end)) && ((res->toobig)) )
+         end = now_nsec + my_sec2nsec((uint64_t)cnf_timeout);
+      if ( ((end)) && ( (res->rcvd == res->sent) || (now_nsec >= end) ) )
+         break;
+      due = ((end)) ? end : due;
+      if (my_poll(fds, 2, (due > now_nsec) ? (due - now_nsec) : 0) < 1)
+         continue;
+      if (!(fds[0].revents & (POLLIN | POLLERR)))
+         continue;
+
+      // ICMP fragmentation needed is reported as an error of the connected
+      // socket
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+      for(;;)
+      {
+         if ((ssize = recv(fd, rcvbuff, cnf_sweep_max, 0)) == -1)
+         {
+            if (errno != EMSGSIZE)
+               break;
+            res->toobig = 1;
+            continue;
+         };
+         resp = (echoplus_t *)(void *)rcvbuff;
+         if ( ((size_t)ssize != res->size) || (akudp_echoplus_decode(&msg, resp->hdr, (size_t)ssize) == -1) )
+            continue;
+         pos  = msg.req_sn - first;
+         if ( (pos >= n) || ((seen[pos])) )
+            continue;
+         seen[pos] = 1;
+         delta = (((int64_t)now.tv_sec - (int64_t)resp->send_time.tv_sec) * 1000000000LL) + (now.tv_nsec - resp->send_time.tv_nsec);
+         rtt   = (delta > 0) ? my_nsec2usec((uint64_t)delta) : 0;
+         res->rtt_min  = ( (!(res->rcvd)) || (rtt < res->rtt_min) ) ? rtt : res->rtt_min;
+         res->rtt_max  = (rtt > res->rtt_max) ? rtt : res->rtt_max;
+         res->rtt_sum += rtt;
+         res->rcvd++;
+      };
+   };
+   *seqp = first + n;
+   free(seen);
+
+   return(0);
+}
+
+
+// signal system stop
+void
+my_stop(
+         int                           signum )
+{
+   int         saved;
+
+   // wake threads waiting on the stop pipe
+   saved       = errno;
+   should_stop = 1;
+   if (stop_pipe[1] != -1)
+      while ( (write(stop_pipe[1], "", 1) == -1) && (errno == EINTR) );
+   errno = saved;
+   signal(signum, my_stop);
+   return;
+}
+
+
+// signal request for cumulative summary
+void
+my_summary(
+         int                           signum )
+{
+   // workers notice the new request on their next wakeup
+   __atomic_add_fetch(&summary_gen, 1, __ATOMIC_RELAXED);
+   signal(signum, my_summary);
+   return;
+}
+
+
+// resolve and append probe target
+int
+my_target_add(
+         const char *                  host )
+{
+   int                        rc;
+   int                        family;
+   size_t                     first;
+   size_t                     pos;
+   struct addrinfo *          res;
+   struct addrinfo *          info;
+   struct addrinfo            hints;
+   my_target_t *              tgt;
+
+   memset(&hints, 0, sizeof(struct addrinfo));
+   hints.ai_flags     = AI_ADDRCONFIG | AI_V4MAPPED | AI_ALL;
+   hints.ai_family    = cnf_ai_family;
+   hints.ai_socktype  = SOCK_DGRAM;
+   hints.ai_protocol  = IPPROTO_UDP;
+
+   // an all numeric host is a misplaced port, not the address 0.x.x.x
+   if (host[strspn(host, "0123456789")] == '\0')
    {
-      fprintf(stderr, "%s: unable to resolve host\n", prog_name);
+      fprintf(stderr, "%s: %s: invalid host address\n", prog_name, host);
       return(-1);
    };
-   if (!(cnf_silent))
-      printf("%s", logmsg);
 
+   // resolve host
+   if ((rc = getaddrinfo(host, cnf_port, &hints, &res)) != 0)
+   {
+      fprintf(stderr, "%s: %s: %s\n", prog_name, host, gai_strerror(rc));
+      return(-1);
+   };
 
-   // open and connect socket
-   if ((s = socket(sa.sa.sa_family, SOCK_DGRAM, 0)) == -1)
+   // use first IPv6 address, otherwise first IPv4 address, or every
+   // address with IPv6 listed first in all addresses mode
+   first = targets_len;
+   for(family = AF_INET6; (family != AF_UNSPEC); family = (family == AF_INET6) ? AF_INET : AF_UNSPEC)
    {
-      fprintf(stderr, "%s: socket(): %s\n", prog_name, strerror(errno));
+      for(info = res; (info != NULL); info = info->ai_next)
+      {
+         if (info->ai_addr->sa_family != family)
+            continue;
+         if ( (!(cnf_all_addrs)) && (targets_len > first) )
+            break;
+
+         // skip addresses returned more than once
+         for(pos = first; (pos < targets_len); pos++)
+            if ( (targets[pos].salen == info->ai_addrlen) && (!(memcmp(&targets[pos].sa, info->ai_addr, info->ai_addrlen))) )
+               break;
+         if (pos < targets_len)
+            continue;
+
+         // grow target table
+         if ((tgt = realloc(targets, sizeof(my_target_t) * (targets_len+1))) == NULL)
+         {
+            freeaddrinfo(res);
+            fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+            return(-1);
+         };
+         targets = tgt;
+         tgt     = &targets[targets_len];
+         memset(tgt, 0, sizeof(my_target_t));
+         tgt->salen = info->ai_addrlen;
+         memcpy(&tgt->sa, info->ai_addr, info->ai_addrlen);
+         if (tgt->sa.sa.sa_family == AF_INET6)
+            inet_ntop(AF_INET6, &tgt->sa.sin6.sin6_addr, tgt->addrstr, sizeof(tgt->addrstr));
+         else
+            inet_ntop(AF_INET,  &tgt->sa.sin.sin_addr,   tgt->addrstr, sizeof(tgt->addrstr));
+         tgt->hash = my_target_hashval(&tgt->sa);
+         tgt->tos  = -1;
+
+         if ((tgt->host = strdup(host)) == NULL)
+         {
+            freeaddrinfo(res);
+            fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+            return(-1);
+         };
+         targets_len++;
+      };
+   };
+   freeaddrinfo(res);
+
+   if (targets_len == first)
+   {
+      fprintf(stderr, "%s: %s: unable to resolve host\n", prog_name, host);
+      return(-1);
+   };
+
+   return(0);
+}
+
+
+// replicate targets for each traffic class
+int
+my_target_classes(
+         void )
+{
+   size_t                     idx;
+   size_t                     len;
+   unsigned                   cls;
+   char *                     host;
+   my_target_t *              tgt;
+
+   if ((tgt = realloc(targets, sizeof(my_target_t) * targets_base * cnf_tos_len)) == NULL)
       return(-1);
+   targets = tgt;
+
+   // targets are grouped by class, the hash table indexes the first class
+   // and responses are mapped to the class of the socket they arrive on
+   for(cls = cnf_tos_len; (cls > 0); cls--)
+   {
+      for(idx = 0; (idx < targets_base); idx++)
+      {
+         tgt  = &targets[((cls-1) * targets_base) + idx];
+         len  = strlen(targets[idx].host) + strlen(cnf_tos_name[cls-1]) + 2;
+         if ((host = malloc(len)) == NULL)
+            return(-1);
+         snprintf(host, len, "%s/%s", targets[idx].host, cnf_tos_name[cls-1]);
+         if ((cls-1))
+            memcpy(tgt, &targets[idx], sizeof(my_target_t));
+         else
+            free(tgt->host);
+         tgt->host = host;
+         tgt->tos  = cnf_tos[cls-1];
+         tgt->cls  = cls-1;
+      };
    };
-   if (connect(s, &sa.sa, socklen) == -1)
+   targets_len = targets_base * cnf_tos_len;
+
+   return(0);
+}
+
+
+// append probe targets listed in file
+int
+my_target_file(
+         const char *                  path )
+{
+   int                        rc;
+   FILE *                     fs;
+   char *                     host;
+   char *                     end;
+   char                       line[MY_LINE_MAX];
+
+   if (!(strcmp(path, "-")))
+      fs = stdin;
+   else if ((fs = fopen(path, "r")) == NULL)
    {
-      fprintf(stderr, "%s: connect(): %s\n", prog_name, strerror(errno));
+      fprintf(stderr, "%s: %s: %s\n", prog_name, path, strerror(errno));
       return(-1);
    };
 
-   // configure socket
-   fcntl(s, F_SETFL, O_NONBLOCK);
+   // one host per line, blank lines and comments are ignored
+   rc = 0;
+   while ((fgets(line, sizeof(line), fs)))
+   {
+      if ((end = strchr(line, '#')) != NULL)
+         end[0] = '\0';
+      for(host = line; ( (host[0] == ' ') || (host[0] == '\t') ); host++);
+      for(end = host; ( ((end[0])) && (end[0] != ' ') && (end[0] != '\t') && (end[0] != '\r') && (end[0] != '\n') ); end++);
+      end[0] = '\0';
+      if (!(host[0]))
+         continue;
+      if ((my_target_add(host)))
+         rc = -1;
+   };
 
-   return(s);
+   if (fs != stdin)
+      fclose(fs);
+
+   return(rc);
 }
 
 
-// signal system stop
-void
-my_stop(
-         int                           signum )
+// calculate hash of target address and port
+uint32_t
+my_target_hashval(
+         const union my_sa *           sap )
 {
-   should_stop = 1;
-   signal(signum, my_stop);
-   return;
+   size_t                     pos;
+   size_t                     len;
+   uint32_t                   hash;
+   const uint8_t            * addr;
+   const uint8_t            * port;
+
+   if (sap->sa.sa_family == AF_INET6)
+   {
+      addr = (const uint8_t *)&sap->sin6.sin6_addr;
+      port = (const uint8_t *)&sap->sin6.sin6_port;
+      len  = sizeof(sap->sin6.sin6_addr);
+   } else
+   {
+      addr = (const uint8_t *)&sap->sin.sin_addr;
+      port = (const uint8_t *)&sap->sin.sin_port;
+      len  = sizeof(sap->sin.sin_addr);
+   };
+
+   // hash address and port (FNV-1a)
+   hash = 2166136261U;
+   for(pos = 0; (pos < len); pos++)
+      hash = (hash ^ addr[pos]) * 16777619U;
+   hash = (hash ^ port[0]) * 16777619U;
+   hash = (hash ^ port[1]) * 16777619U;
+
+   return(hash);
 }
 
 
-// calculates delta between timespecs and returns result as microscond
-uint64_t
-my_timespec_delta(
-         struct timespec *             ts1,
-         struct timespec *             ts2,
-         struct timespec *             delta )
+// build target hash table
+int
+my_target_index(
+         void )
+{
+   size_t                     idx;
+   size_t                     len;
+   size_t                     size;
+   my_target_t *              tgt;
+
+   // size table to a power of two with a load factor of at most one half
+   for(size = 64; (size < (targets_len * 2)); size *= 2);
+   if ((target_hash = calloc(size, sizeof(size_t))) == NULL)
+      return(-1);
+   target_hash_mask = size - 1;
+
+   // index targets, duplicate addresses are dropped because replies from
+   // them could not be told apart
+   for(idx = 0, len = 0; (idx < targets_len); idx++)
+   {
+      if ((tgt = my_target_lookup(&targets[idx].sa)) != NULL)
+      {
+         fprintf(stderr, "%s: %s: duplicate of %s, ignoring\n", prog_name, targets[idx].host, tgt->host);
+         free(targets[idx].host);
+         continue;
+      };
+      if (idx != len)
+         memcpy(&targets[len], &targets[idx], sizeof(my_target_t));
+      targets[len].next = target_hash[targets[len].hash & target_hash_mask];
+      target_hash[targets[len].hash & target_hash_mask] = len + 1;
+      len++;
+   };
+   targets_len = len;
+
+   return(0);
+}
+
+
+// find target by address and port
+my_target_t *
+my_target_lookup(
+         const union my_sa *           sap )
+{
+   size_t                     idx;
+   uint32_t                   hash;
+   my_target_t *              tgt;
+
+   hash = my_target_hashval(sap);
+   for(idx = target_hash[hash & target_hash_mask]; ((idx)); idx = tgt->next)
+   {
+      tgt = &targets[idx-1];
+      if ( (tgt->hash != hash) || (tgt->sa.sa.sa_family != sap->sa.sa_family) )
+         continue;
+      if (sap->sa.sa_family == AF_INET6)
+      {
+         if ( (tgt->sa.sin6.sin6_port == sap->sin6.sin6_port) && (!(memcmp(&tgt->sa.sin6.sin6_addr, &sap->sin6.sin6_addr, sizeof(struct in6_addr)))) )
+            return(tgt);
+         continue;
+      };
+      if ( (tgt->sa.sin.sin_port == sap->sin.sin_port) && (tgt->sa.sin.sin_addr.s_addr == sap->sin.sin_addr.s_addr) )
+         return(tgt);
+   };
+
+   return(NULL);
+}
+
+
+// run worker threads and report progress until they finish
+int
+my_threads(
+         void )
 {
-   struct timespec ts;
-   uint64_t        usec;
+   int                        rc;
+   unsigned                   idx;
+   unsigned                   started;
+   unsigned                   finished;
+   uint64_t                   now_nsec;
+   uint64_t                   start_nsec;
+   uint64_t                   report_nsec;
+   uint64_t                   sent;
+   uint64_t                   rcvd;
+   uint64_t                   report_sent;
+   uint64_t                   report_rcvd;
+   uint64_t                   report_loss[3];
+   uint64_t                   loss[3];
+   uint64_t                   tmp;
+   unsigned                   pos;
+   ssize_t                    len;
+   char                       buff[64];
+   struct pollfd              fds[1];
+   struct timespec            now;
+
+   // start workers
+   rc = 0;
+   for(started = 0; ( (started < cnf_threads) && (!(rc)) ); started++)
+   {
+      if ((rc = pthread_create(&workers[started].thread, NULL, my_worker_run, &workers[started])) == 0)
+         continue;
+      fprintf(stderr, "%s: pthread_create(): %s\n", prog_name, strerror(rc));
+      should_stop = 1;
+      while ( (write(stop_pipe[1], "", 1) == -1) && (errno == EINTR) );
+      break;
+   };
+
+   // wait for workers to finish, printing combined throughput each second
+   fds[0].fd      = done_pipe[0];
+   fds[0].events  = POLLIN;
+   start_nsec     = workers[0].start_nsec;
+   report_nsec    = start_nsec + my_sec2nsec(1ULL);
+   report_sent    = 0;
+   report_rcvd    = 0;
+   finished       = 0;
+   memset(report_loss, 0, sizeof(report_loss));
+   while (finished < started)
+   {
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+      now_nsec = my_sec2nsec((uint64_t)now.tv_sec) + (uint64_t)now.tv_nsec;
+      if ( ((cnf_throughput)) && (now_nsec >= report_nsec) )
+      {
+         memset(loss, 0, sizeof(loss));
+         for(idx = 0, sent = 0, rcvd = 0; (idx < started); idx++)
+         {
+            sent += __atomic_load_n(&workers[idx].total_sent, __ATOMIC_RELAXED);
+            rcvd += __atomic_load_n(&workers[idx].total_rcvd, __ATOMIC_RELAXED);
+            for(pos = 0; (pos < 3); pos++)
+               loss[pos] += __atomic_load_n(&workers[idx].total_loss[pos], __ATOMIC_RELAXED);
+         };
+         for(pos = 0; (pos < 3); pos++)
+         {
+            tmp               = loss[pos];
+            loss[pos]         = (tmp > report_loss[pos]) ? (tmp - report_loss[pos]) : 0;
+            report_loss[pos]  = tmp;
+         };
+         my_throughput(my_nsec2sec((report_nsec - start_nsec)), sent - report_sent, (rcvd > report_rcvd) ? (rcvd - report_rcvd) : 0, loss);
+         report_sent  = sent;
+         report_rcvd  = rcvd;
+         report_nsec += my_sec2nsec(1ULL);
+         continue;
+      };
+      if (my_poll(fds, 1, ((cnf_throughput)) ? (report_nsec - now_nsec) : my_sec2nsec(60ULL)) <= 0)
+         continue;
+      while ((len = read(done_pipe[0], buff, sizeof(buff))) > 0)
+         finished += (unsigned)len;
+   };
+
+   // collect workers
+   for(idx = 0; (idx < started); idx++)
+   {
+      pthread_join(workers[idx].thread, NULL);
+      rc = ((workers[idx].rc)) ? workers[idx].rc : rc;
+   };
 
-   assert(ts1   != NULL);
-   assert(ts2   != NULL);
+   return(rc);
+}
 
-   if (!(delta))
-      delta = &ts;
 
-   delta->tv_sec  = ts1->tv_sec;
-   delta->tv_nsec = ts1->tv_nsec;
-   if (delta->tv_nsec < ts2->tv_nsec)
+// print throughput line
+void
+my_throughput(
+         uint64_t                      sec,
+         uint64_t                      sent,
+         uint64_t                      rcvd,
+         const uint64_t *              loss )
+{
+   if (cnf_format == MY_FORMAT_JSONL)
+   {
+      printf("{\"type\":\"interval\",\"sec\":%" PRIu64 ",\"sent\":%" PRIu64 ",\"rcvd\":%" PRIu64 ",\"loss_forward\":%" PRIu64 ",\"loss_return\":%" PRIu64 ",\"loss_reflector\":%" PRIu64 "}\n",
+             sec, sent, rcvd, loss[MY_LOSS_FORWARD], loss[MY_LOSS_RETURN], loss[MY_LOSS_REFLECTOR]);
+      fflush(stdout);
+      return;
+   };
+   if (cnf_format == MY_FORMAT_CSV)
    {
-      delta->tv_sec--;
-      delta->tv_nsec += my_sec2nsec(1);
+      printf("interval,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+             sec, sent, rcvd, loss[MY_LOSS_FORWARD], loss[MY_LOSS_RETURN], loss[MY_LOSS_REFLECTOR]);
+      fflush(stdout);
+      return;
    };
-   delta->tv_sec  -= ts2->tv_sec;
-   delta->tv_nsec -= ts2->tv_nsec;
+   printf("%" PRIu64 "s: sent %" PRIu64 " pps %" PRIu64 " B/s, received %" PRIu64 " pps %" PRIu64 " B/s, %" PRIu64 ".%" PRIu64 "%% loss",
+          sec,
+          sent, sent * cnf_packetsize_avg,
+          rcvd, rcvd * cnf_packetsize_avg,
+          (rcvd >= sent) ? 0 : ((sent - rcvd) * 100) / sent,
+          (rcvd >= sent) ? 0 : (((sent - rcvd) * 1000) / sent) % 10
+   );
+   if ( (__atomic_load_n(&cnf_echoplus, __ATOMIC_RELAXED) == 1) && (!(cnf_stamp)) )
+      printf(" (forward %" PRIu64 ", return %" PRIu64 ", reflector %" PRIu64 ")",
+             loss[MY_LOSS_FORWARD], loss[MY_LOSS_RETURN], loss[MY_LOSS_REFLECTOR]);
+   printf("\n");
+   fflush(stdout);
+   return;
+}
+
+
+// compare traffic class of response with that of the request
+void
+my_tos_update(
+         my_stats_t *                  st,
+         const my_target_t *           tgt,
+         struct msghdr *               msg )
+{
+   int                        tos;
+
+   // a reflector that answers with its own traffic class would show every
+   // marked class as remarked, so only count when reflection is asserted
+   if ( (!(cnf_tos_reflected)) || (!(cnf_tos_len)) )
+      return;
+   if ((tos = akudp_cmsg_tos(msg)) == -1)
+      return;
+   st->tos_rcvd++;
+   st->tos_remarked += ((tos >> 2) != (tgt->tos >> 2)) ? 1 : 0;
+   st->tos_ce       += ((tos & 0x03) == 0x03) ? 1 : 0;
+
+   return;
+}
+
+
+// read kernel TX timestamps from socket error queue
+void
+my_txstamp(
+         my_worker_t *                 w,
+         int                           idx )
+{
+#ifdef HAVE_SO_TIMESTAMPING
+   int64_t                    ns;
+   char                       ctrl[MY_CMSG_SIZE];
+   my_txmap_t *               map;
+   my_stats_t *               st;
+   struct msghdr              msg;
+   struct cmsghdr *           cmsg;
+   struct sock_extended_err   err;
 
-   usec  = my_sec2usec((uint64_t)delta->tv_sec);
-   usec += my_nsec2usec((uint64_t)delta->tv_nsec);
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_control = ctrl;
+   for(msg.msg_controllen = sizeof(ctrl); (recvmsg(w->fds[idx].fd, &msg, MSG_ERRQUEUE) != -1); msg.msg_controllen = sizeof(ctrl))
+   {
+      if (!(ns = my_kernel_time(&msg)))
+         continue;
 
-   return(usec);
+      // the OPT_ID of the datagram is returned in the extended error
+      for(cmsg = CMSG_FIRSTHDR(&msg); ((cmsg)); cmsg = CMSG_NXTHDR(&msg, cmsg))
+      {
+         if ( ( (cmsg->cmsg_level != IPPROTO_IP)   || (cmsg->cmsg_type != IP_RECVERR)   ) &&
+              ( (cmsg->cmsg_level != IPPROTO_IPV6) || (cmsg->cmsg_type != IPV6_RECVERR) ) )
+            continue;
+         memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+         if (err.ee_origin != SO_EE_ORIGIN_TIMESTAMPING)
+            continue;
+         map = &w->tx_map[idx][err.ee_data % MY_TX_RING];
+         if (map->id != err.ee_data)
+            continue;
+         st = &w->stats[map->target];
+         if ((st->ktx))
+            st->ktx[map->seq % MY_SEQ_WINDOW] = ns;
+      };
+   };
+#else
+   (void)w;
+   (void)idx;
+#endif
+   return;
 }
 
 
@@ -750,20 +5527,40 @@ my_usage(
          void )
 {
    printf("Usage: %s [options] host [port]\n", prog_name);
+   printf("       %s [options] [-p port] [-f file] host ...\n", prog_name);
    printf("OPTIONS:\n");
    printf("  -4                        connect via IPv4 only\n");
    printf("  -6                        connect via IPv6 only\n");
+   printf("  -A, --all-addresses       probe every resolved address of each host\n");
+   printf("  -b, --burst num           send num back to back requests per interval (default: 1)\n");
    printf("  -c count                  stop after sending count packets\n");
+   printf("  -C, --capacity            RFC 9097 style IP capacity test\n");
    printf("  -d, --debug               print packet debugging information\n");
+   printf("  -D, --dump                print first differing byte of corrupted replies\n");
    printf("  -e, --echoplus            expect echo plus response (default: auto detect)\n");
+   printf("  -E, --ecn                 mark requests ECN capable (ECT(0))\n");
+   printf("  -f file                   read list of targets from file (\"-\" for stdin)\n");
+   printf("  -F, --format fmt          output format: text, jsonl, or csv (default: text)\n");
    printf("  -h, --help                print this help and exit\n");
-   printf("  -i interval               interval between packet (default: %lu sec)\n", cnf_interval);
+   printf("  -i interval               interval between packets in s, ms, or us (default: 1s)\n");
+   printf("  -j, --threads num         number of probe threads (default: 1)\n");
+   printf("  -K, --timestamping src    kernel timestamps from software or hardware\n");
+   printf("  -M, --metrics [addr:]port serve Prometheus metrics on HTTP /metrics\n");
+   printf("  -N, --sub-intervals num   sub-intervals of capacity test (default: %u)\n", MY_CAP_SUB_INTERVALS);
+   printf("  -p port                   remote port of all targets (default: %s)\n", cnf_port);
+   printf("  -P, --profile spec        request sizes from imix, min-max, or size[-max]:weight,...\n");
    printf("  -r, --rfc                 expect RFC compliant response (default: auto detect)\n");
+   printf("  -R, --report-interval int print loss and latency of each interval (min: 1s)\n");
    printf("  -q, --quiet, --silent     do not print messages\n");
+   printf("  -Q, --dscp list           probe each target with DSCP values or names (ef,af41,...)\n");
    printf("  -s packetsize             size of data bytes to be sent. (default: %zu bytes)\n", cnf_packetsize);
+   printf("  -S, --stamp               send STAMP (RFC 8762) / TWAMP-Light test packets\n");
    printf("  -t sec                    response timeout (default: %lu sec)\n", cnf_timeout);
+   printf("  -T, --throughput          print per second throughput instead of each response\n");
    printf("  -v, --verbose             enable verbose output\n");
    printf("  -V, --version             print version number and exit\n");
+   printf("  -X, --tos-reflected       reflector returns DSCP/ECN of requests, report remarking\n");
+   printf("  -z, --sweep min:max[:step] step request size with DF set, report path MTU\n");
    printf("\n");
    return;
 }
@@ -789,4 +5586,174 @@ my_usage_error(
 }
 
 
+// verify echoed payload of response, returns -1 if corrupted
+int
+my_verify(
+         my_worker_t *                 w,
+         my_target_t *                 tgt,
+         my_stats_t *                  st,
+         const char *                  buff,
+         size_t                        len )
+{
+   size_t                     off;
+   size_t                     pos;
+   size_t                     size;
+   uint32_t                   seq;
+   unsigned                   bucket;
+   const char *               sent;
+
+   // the reflector only rewrites the protocol header, the payload following
+   // it is compared with the request template (memcmp() is vectorized),
+   // STAMP reflectors need not echo the padding and are only checked for size
+   off  = ((cnf_stamp)) ? MY_STAMP_SIZE : sizeof(echoplus_t);
+   sent = (const char *)w->sndbuff;
+   if (len < off)
+   {
+      // too short to carry a sequence number, the size is unknown
+      st->corrupt++;
+      if ((cnf_dump))
+         fprintf(stderr, "%s: %s: corrupted reply: received %zu bytes, expected at least %zu bytes\n", prog_name, tgt->host, len, off);
+      return(-1);
+   };
+   memcpy(&seq, &buff[((cnf_stamp)) ? MY_STAMP_SS_SEQ : offsetof(echoplus_t, hdr)], sizeof(seq));
+   size = my_profile_size(tgt, ntohl(seq), &bucket);
+   if ( (len == size) && ( ((cnf_stamp)) || (!(memcmp(&buff[off], &sent[off], size - off))) ) )
+      return(0);
+   st->corrupt++;
+   w->buckets[bucket].corrupt++;
+
+   if (!(cnf_dump))
+      return(-1);
+   if (len != size)
+   {
+      fprintf(stderr, "%s: %s: corrupted reply: received %s%zu bytes, expected %zu bytes\n", prog_name, tgt->host, (len > cnf_packetsize) ? "at least " : "", len, size);
+      return(-1);
+   };
+   for(pos = off; (buff[pos] == sent[pos]); pos++);
+   fprintf(stderr, "%s: %s: corrupted reply seq=%" PRIu32 ": offset %zu: expected 0x%02x, received 0x%02x\n",
+           prog_name, tgt->host, ntohl(seq), pos, (uint8_t)sent[pos], (uint8_t)buff[pos]);
+
+   return(-1);
+}
+
+
+// release worker resources
+void
+my_worker_free(
+         my_worker_t *                 w )
+{
+   int                        pos;
+
+   for(pos = 0; (pos < MY_SOCK_MAX); pos++)
+   {
+      if (w->fds[pos].fd != -1)
+         close(w->fds[pos].fd);
+      free(w->tx_map[pos]);
+   };
+   my_stats_free(w->stats);
+   free(w->rcvbuff);
+   free(w->sndbuff);
+   free(w->outbuf);
+   memset(w, 0, sizeof(my_worker_t));
+
+   return;
+}
+
+
+// allocate worker buffers, statistics, and sockets
+int
+my_worker_init(
+         my_worker_t *                 w,
+         const echoplus_t *            tmpl )
+{
+   size_t                     pos;
+   int                        idx;
+
+   w->fds[MY_SOCK_MAX].fd = stop_pipe[0];
+
+   // allocate buffers and statistics, responses are received in batches
+   // and requests are sent in bursts
+   w->rcvbuff = malloc(cnf_packetsize * MY_BATCH_MAX);
+   w->sndbuff = malloc(cnf_packetsize * cnf_burst);
+   w->stats   = my_stats_alloc();
+   if (cnf_format != MY_FORMAT_TEXT)
+      w->outbuf = malloc(MY_OUTBUF_SIZE);
+   if ( (!(w->rcvbuff)) || (!(w->sndbuff)) || (!(w->stats)) || ( (cnf_format != MY_FORMAT_TEXT) && (!(w->outbuf)) ) )
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+      return(1);
+   };
+   for(pos = 0; (pos < cnf_burst); pos++)
+      memcpy(&((char *)w->sndbuff)[pos * cnf_packetsize], tmpl, cnf_packetsize);
+
+   // kernel TX times are kept for the targets with latency histograms
+   for(pos = 0; ( (cnf_timestamping != MY_TS_NONE) && (pos < targets_len) && ((w->stats[pos].rtt_hist)) ); pos++)
+   {
+      if ((w->stats[pos].ktx = calloc(MY_SEQ_WINDOW, sizeof(int64_t))) == NULL)
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+         return(1);
+      };
+   };
+
+   // STAMP responses carry no monotonic send time of the request
+   for(pos = 0; ( ((cnf_stamp)) && (pos < targets_len) ); pos++)
+   {
+      if ((w->stats[pos].stx = calloc(MY_SEQ_WINDOW, sizeof(int64_t))) == NULL)
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+         return(1);
+      };
+   };
+
+   // open one socket per traffic class and address family in use, each
+   // worker is assigned its own source ports, a single target is connected
+   // so ICMP errors are reported
+   for(pos = 0; (pos < targets_len); pos++)
+   {
+      idx = (int)(targets[pos].cls * 2) + ((targets[pos].sa.sa.sa_family == AF_INET6) ? 1 : 0);
+      if (w->fds[idx].fd != -1)
+         continue;
+      if ((w->fds[idx].fd = my_socket(targets[pos].sa.sa.sa_family, targets[pos].tos)) == -1)
+         return(1);
+      if ( (!(cnf_multi)) && (connect(w->fds[idx].fd, &targets[pos].sa.sa, targets[pos].salen) == -1) )
+      {
+         fprintf(stderr, "%s: connect(): %s\n", prog_name, strerror(errno));
+         return(1);
+      };
+
+      // kernel TX timestamps are matched to requests by datagram counter
+      if ( (cnf_timestamping != MY_TS_NONE) && ((w->tx_map[idx] = calloc(MY_TX_RING, sizeof(my_txmap_t))) == NULL) )
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", prog_name);
+         return(1);
+      };
+   };
+
+   return(0);
+}
+
+
+// worker thread entry point
+void *
+my_worker_run(
+         void *                        arg )
+{
+   my_worker_t *              w;
+
+   w     = arg;
+   w->rc = my_loop(w);
+
+   // later rounds of combined reports no longer wait for this worker
+   my_report_leave(w, &report_interval);
+   my_report_leave(w, &report_summary);
+   my_report_leave(w, &report_metrics);
+
+   // notify reporting thread
+   while ( (write(done_pipe[1], "", 1) == -1) && (errno == EINTR) );
+
+   return(NULL);
+}
+
+
 /* end of source file */
@@ -34,15 +34,15 @@
  */
 /*
  *  Simple Build:
- *     export CFLAGS='-Wall -Wno-unknown-pragmas'
- *     gcc ${CFLAGS} -c akcom-udpechod.c
- *     gcc ${CFLAGS} -o akcom-udpechod akcom-udpechod.o
+ *     export CFLAGS='-Wall -Wno-unknown-pragmas -I../include -I../lib/libakcom-udpecho'
+ *     gcc ${CFLAGS} -c akcom-udpechod.c ../lib/libakcom-udpecho/l*.c
+ *     gcc ${CFLAGS} -o akcom-udpechod akcom-udpechod.o l*.o -lpthread -lm
  *
  *  Libtool Build:
- *     export CFLAGS='-Wall -Wno-unknown-pragmas'
+ *     export CFLAGS='-Wall -Wno-unknown-pragmas -I../include'
  *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c akcom-udpechod.c
  *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -o akcom-udpechod \
- *             akcom-udpechod.lo
+ *             akcom-udpechod.lo ../lib/libakcom-udpecho.la
  *
  *  Libtool Clean:
  *     libtool --mode=clean rm -f akcom-udpechod.lo akcom-udpechod
@@ -61,6 +61,11 @@
 #   define _XOPEN_SOURCE 600
 #endif
 
+// required by glibc for struct in6_pktinfo
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE 1
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
@@ -78,6 +83,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -90,6 +96,8 @@
 #include <pwd.h>
 #include <grp.h>
 
+#include <akcom-udpecho.h>
+
 
 ///////////////////
 //               //
@@ -98,7 +106,15 @@
 ///////////////////
 #pragma mark - Definitions
 
-#define MY_BUFF_SIZE             4096    // default buffer size
+#define MY_BUFF_SIZE             65536   // max datagram size
+#define MY_CMSG_SIZE             256     // ancillary data buffer size
+#define MY_LOCAL_MAX             256     // max tracked local addresses
+#define MY_TPROXY_MAX            512     // max cached transparent reply sockets
+#define MY_TPROXY_HASH           1024    // transparent reply socket hash buckets (power of 2)
+#define MY_FLOW_MAX              1024    // size of recent flows ring
+#define MY_FLOW_HASH             2048    // recent flows hash buckets (power of 2)
+#define MY_CTL_MAX               4       // max concurrent control connections
+#define MY_CTL_IDLE              5       // seconds before control connection is dropped
 
 
 #ifndef PROGRAM_NAME
@@ -111,6 +127,20 @@
 #define PACKAGE_VERSION "0.0"
 #endif
 
+#define MY_STAMP_SIZE            AKUDP_STAMP_SIZE
+
+#if !defined(HAVE_CONFIG_H) && (defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__))
+#   define HAVE_RECVMMSG 1
+#endif
+
+#define MY_CAP_LOAD_MAGIC        0x414b434cU    // "AKCL" capacity load packet
+#define MY_CAP_STATUS_MAGIC      0x414b4353U    // "AKCS" capacity status feedback
+#define MY_CAP_SESSIONS          16      // max concurrent capacity sessions
+#define MY_CAP_BATCH             64      // datagrams per recvmmsg() call
+#define MY_CAP_FEEDBACK          50000000ULL    // status interval in nanoseconds
+#define MY_CAP_IDLE              2       // seconds before session expires
+#define MY_CAP_RCVBUF            (8 * 1024 * 1024)
+
 #define MY_SENT 0
 #define MY_RECV 1
 #define MY_DROP 2
@@ -133,14 +163,129 @@ union my_sa
 };
 
 
-struct udp_echo_plus
+// per local address counters
+struct my_local
+{
+   union my_sa               addr;
+   uint64_t                  recv;
+   uint64_t                  sent;
+   uint64_t                  drop;
+   uint64_t                  inval;
+};
+
+
+// flow counters
+struct my_counters
+{
+   uint64_t                  packets;
+   uint64_t                  bytes;
+   uint64_t                  drops;
+   uint64_t                  inval;
+   uint64_t                  proc_sum;       // processing time in nanoseconds
+   uint64_t                  proc_min;
+   uint64_t                  proc_max;
+   uint64_t                  proc_cnt;
+};
+
+
+// recent flow counters, kept per client address and port
+struct my_flow
+{
+   union my_sa               addr;
+   struct my_counters        total;
+   struct my_counters        interval;       // counters since last flow record
+   time_t                    first_seen;
+   time_t                    last_seen;
+   time_t                    interval_start;
+   time_t                    rate_sec;       // second of rate_pkts/rate_bytes
+   uint64_t                  rate_pkts;
+   uint64_t                  rate_bytes;
+   uint64_t                  prev_pkts;      // packets during previous second
+   uint64_t                  prev_bytes;
+   uint32_t                  hash;
+   uint32_t                  next;           // hash chain (index + 1)
+   uint32_t                  newer;          // recency list (index + 1)
+   uint32_t                  older;
+};
+
+
+// control connection, served without blocking the packet loop
+struct my_ctlconn
+{
+   int                       s;
+   time_t                    start;
+   size_t                    len;            // bytes of command read
+   char                    * out;            // buffered response
+   size_t                    out_len;
+   size_t                    out_pos;
+   char                      line[256];
+};
+
+
+// cached reply socket bound to foreign address
+struct my_tproxy
+{
+   union my_sa               addr;
+   int                       s;
+   uint32_t                  hash;
+   uint32_t                  next;           // hash chain (index + 1)
+   uint32_t                  newer;          // recency list (index + 1)
+   uint32_t                  older;
+};
+
+
+// capacity test load packet header, remainder of packet is padding
+struct capacity_load
+{
+   uint32_t  magic;
+   uint32_t  session;
+   uint32_t  seq;
+   uint32_t  tx_sec;          // sender monotonic clock
+   uint32_t  tx_nsec;
+};
+
+
+// capacity test status feedback, counters cover one feedback interval
+struct capacity_status
+{
+   uint32_t  magic;
+   uint32_t  session;
+   uint32_t  seq;             // status message sequence
+   uint32_t  interval;        // microseconds covered by counters
+   uint32_t  rx_pkts;
+   uint32_t  rx_bytes;        // UDP payload bytes
+   uint32_t  seq_gap;         // load sequences skipped
+   uint32_t  seq_ooo;         // load sequences received out of order
+   uint32_t  dvar_max;        // max one-way delay above session minimum (usec)
+   uint32_t  rx_drops;        // load datagrams dropped by receive buffer overflow
+};
+
+
+// capacity test session, one per client address and session id
+struct my_capacity
 {
-   uint32_t  req_sn;
-   uint32_t  res_sn;
-   uint32_t  recv_time;
-   uint32_t  reply_time;
-   uint32_t  failures;
-   uint32_t  iteration;
+   union my_sa               addr;
+   socklen_t                 addrlen;
+   uint32_t                  session;
+   uint32_t                  next_seq;       // next expected load sequence
+   uint32_t                  status_seq;
+   int64_t                   delay_min;      // minimum one-way delay of session
+   int64_t                   dvar_max;       // max delay above minimum in interval
+   uint64_t                  start;          // monotonic nanoseconds
+   uint64_t                  last_rx;
+   uint64_t                  next_status;
+   uint64_t                  interval_start;
+   uint32_t                  rx_pkts;        // counters of current interval
+   uint32_t                  rx_bytes;
+   uint32_t                  seq_gap;
+   uint32_t                  seq_ooo;
+   uint32_t                  rx_drops;
+   uint64_t                  total_pkts;
+   uint64_t                  total_bytes;
+   uint64_t                  total_gap;
+   uint64_t                  total_ooo;
+   uint64_t                  total_drops;
+   int                       active;
 };
 
 
@@ -152,22 +297,29 @@ struct udp_echo_plus
 #pragma mark - Variables
 
 static int           should_stop     = 0;
+static int           should_report   = 0;
 
 static const char  * prog_name       = "a.out";
 
 static const char  * cnf_pidfile     = "/var/run/" PROGRAM_NAME ".pid";
 static uint16_t      cnf_port        = 30006;                            // UDP port number
 static int           cnf_echoplus    = 0;                                // enable echo plus
+static int           cnf_stamp       = 0;                                // enable STAMP session-reflector
+static int           cnf_capacity    = 0;                                // enable capacity test receiver
 static int           cnf_drop_perct  = 0;                                // drop percentage
 static useconds_t    cnf_delay       = 0;                                // Delay range in microseconds
 static int32_t       cnf_verbose     = 0;                                // runtime verbosity
 static int           cnf_facility    = LOG_DAEMON;                       // syslog facility
 static int           cnf_dont_fork   = 0;
 static const char  * cnf_listen      = NULL;                             // IP address to listen for requests
+static int           cnf_transparent = 0;                                // answer for any destination (IP_TRANSPARENT)
+static int           cnf_reflect_tos = 0;                                // reply with traffic class of request
+static const char  * cnf_control     = NULL;                             // control socket path
+static time_t        cnf_aggregate   = 0;                                // flow record interval in seconds
 static uid_t         cnf_uid         = 0;                                // setuid
 static gid_t         cnf_gid         = 0;                                // setgid
 
-static struct udp_echo_plus state =
+static akudp_echoplus_t state =
 {
    .req_sn         = 0,
    .res_sn         = 0,
@@ -176,6 +328,27 @@ static struct udp_echo_plus state =
    .failures       = 0
 };
 
+static struct my_local  local_addrs[MY_LOCAL_MAX];                      // per local address counters
+static struct my_local  local_other;                                     // unknown or untracked addresses
+static uint64_t         tos_dscp[64];                                    // requests received per DSCP
+static uint64_t         tos_ecn[4];                                      // requests received per ECN codepoint
+static struct my_tproxy tproxy_socks[MY_TPROXY_MAX];                     // transparent reply sockets
+static uint32_t         tproxy_hash[MY_TPROXY_HASH];                     // reply socket hash buckets (index + 1)
+static size_t           tproxy_used   = 0;                               // allocated reply socket slots
+static uint32_t         tproxy_newest = 0;                               // most recently used reply socket (index + 1)
+static uint32_t         tproxy_oldest = 0;                               // least recently used reply socket (index + 1)
+static sa_family_t      listen_family = AF_INET6;                        // address family of listening socket
+static int              ctl_sock      = -1;                              // control socket
+static time_t           start_time    = 0;                               // daemon start time
+static struct my_flow   flows[MY_FLOW_MAX];                              // recent flows ring
+static uint32_t         flow_hash[MY_FLOW_HASH];                         // flow hash buckets (index + 1)
+static size_t           flow_used     = 0;                               // allocated flow slots
+static uint32_t         flow_newest   = 0;                               // most recently active flow (index + 1)
+static uint32_t         flow_oldest   = 0;                               // least recently active flow (index + 1)
+static struct my_ctlconn ctl_conns[MY_CTL_MAX];                          // control connections
+static struct my_capacity cap_sessions[MY_CAP_SESSIONS];                 // capacity test sessions
+static uint32_t         cap_ovfl      = 0;                               // receive buffer overflow count last attributed
+
 
 //////////////////
 //              //
@@ -191,6 +364,50 @@ main(
          char *                        argv[] );
 
 
+// receive capacity test load and send status feedback
+static int
+my_capacity_loop(
+         int                           s );
+
+
+// send capacity status feedback and reset interval counters
+static void
+my_capacity_status(
+         int                           s,
+         struct my_capacity *          cap,
+         uint64_t                      now );
+
+
+// close control connection
+static void
+my_control_close(
+         struct my_ctlconn *           connp );
+
+
+// execute control command and buffer response
+static void
+my_control_exec(
+         struct my_ctlconn *           connp );
+
+
+// fill poll descriptors of control socket and connections
+static void
+my_control_fds(
+         struct pollfd *               fds );
+
+
+// open control socket
+static int
+my_control_open(
+         void );
+
+
+// service control socket and connections after poll()
+static void
+my_control_poll(
+         struct pollfd *               fds );
+
+
 // daemonize process
 static int
 my_daemonize(
@@ -211,16 +428,74 @@ my_error(
          ... );
 
 
+// find or allocate recent flow for client address
+static struct my_flow *
+my_flow_lookup(
+         const union my_sa *           sap,
+         time_t                        now );
+
+
+// log flow record and reset interval counters
+static void
+my_flow_export(
+         struct my_flow *              flowp,
+         time_t                        now,
+         const char *                  reason );
+
+
+// update flow counters
+static void
+my_flow_record(
+         struct my_counters *          cntp,
+         int                           mode,
+         uint64_t                      val );
+
+
+// remove flow from recency list
+static void
+my_flow_unlink(
+         uint32_t                      idx );
+
+
+// export flow records of active and idle flows
+static void
+my_flow_sweep(
+         time_t                        now,
+         int                           force );
+
+
+// record packet in recent flow
+static void
+my_flow_update(
+         struct my_flow *              flowp,
+         time_t                        now,
+         size_t                        bytes );
+
+
+// find or allocate counters for local address
+static struct my_local *
+my_local_lookup(
+         union my_sa *                 sap );
+
+
+// log per local address counters
+static void
+my_local_report(
+         void );
+
+
 // log connection
 static int
 my_log_conn(
          int                           mode,
          size_t *                      connp,
          union my_sa *                 sap,
-         struct udp_echo_plus *        msgp,
+         union my_sa *                 localp,
+         const akudp_echoplus_t *      msgp,
          ssize_t                       ssize,
          struct timespec *             tsp,
-         useconds_t                    delay );
+         useconds_t                    delay,
+         uint64_t                      delta );
 
 
 // main loop
@@ -230,6 +505,85 @@ my_loop(
          size_t *                      connp );
 
 
+// receive datagram and destination address
+static ssize_t
+my_recvmsg(
+         int                           s,
+         void *                        buff,
+         size_t                        len,
+         union my_sa *                 sap,
+         socklen_t *                   sinlenp,
+         union my_sa *                 localp,
+         unsigned *                    ifindexp,
+         int *                         ttlp,
+         int *                         tosp );
+
+
+// convert socket address to presentation format
+static int
+my_sa_ntop(
+         union my_sa *                 sap,
+         char *                        dst,
+         size_t                        size,
+         unsigned short *              portp );
+
+
+// nanoseconds elapsed since monotonic timestamp
+static uint64_t
+my_timespec_elapsed(
+         struct timespec *             tsp );
+
+
+// close cached transparent reply sockets
+static void
+my_tproxy_close(
+         void );
+
+
+// send datagram from foreign address and port
+static ssize_t
+my_tproxy_sendto(
+         const void *                  buff,
+         size_t                        len,
+         union my_sa *                 sap,
+         socklen_t                     sinlen,
+         union my_sa *                 localp,
+         int                           tos );
+
+
+// remove transparent reply socket from recency list
+static void
+my_tproxy_unlink(
+         uint32_t                      idx );
+
+
+// set traffic class of transparent reply socket
+static void
+my_tproxy_tos(
+         int                           s,
+         union my_sa *                 sap,
+         int                           tos );
+
+
+// determine STAMP error estimate of local clock
+static uint16_t
+my_stamp_errest(
+         time_t                        now );
+
+
+// send datagram from specified source address
+static ssize_t
+my_sendmsg(
+         int                           s,
+         const void *                  buff,
+         size_t                        len,
+         union my_sa *                 sap,
+         socklen_t                     sinlen,
+         union my_sa *                 localp,
+         unsigned                      ifindex,
+         int                           tos );
+
+
 // signal handler
 static void
 my_sighandler(
@@ -268,14 +622,18 @@ main(
    unsigned                  seed;
    struct timespec           ts;
    size_t                    conn;
+   size_t                    idx;
    int                       opt_index;
    struct passwd           * pw;
    struct group            * gr;
 
    // getopt options
-   static char   short_opt[] = "d:D:efg:hl:np:P:ru:vV";
+   static char   short_opt[] = "A:cC:d:D:efg:hl:np:P:QrSTu:vV";
    static struct option long_opt[] =
    {
+      {"aggregate",     required_argument, 0, 'A'},
+      {"capacity",      no_argument,       0, 'c'},
+      {"control",       required_argument, 0, 'C'},
       {"drop",          required_argument, 0, 'd'},
       {"delay",         required_argument, 0, 'D'},
       {"echoplus",      no_argument,       0, 'e'},
@@ -286,7 +644,10 @@ main(
       {"foreground",    no_argument,       0, 'n'},
       {"port",          required_argument, 0, 'p'},
       {"pidfile",       required_argument, 0, 'P'},
+      {"reflect-tos",   no_argument,       0, 'Q'},
       {"rfc",           no_argument,       0, 'r'},
+      {"stamp",         no_argument,       0, 'S'},
+      {"transparent",   no_argument,       0, 'T'},
       {"user",          required_argument, 0, 'u'},
       {"verbose",       no_argument,       0, 'v'},
       {"version",       no_argument,       0, 'V'},
@@ -308,6 +669,29 @@ main(
          case 0:        // long options toggles
          break;
 
+         case 'A':
+         cnf_aggregate = (time_t)atoi(optarg);
+         if (cnf_aggregate < 1)
+         {
+            my_usage_error("invalid value for `-A'");
+            return(1);
+         };
+         break;
+
+         case 'c':
+#if !defined(HAVE_RECVMMSG)
+         my_usage_error("capacity mode is not supported on this platform");
+         return(1);
+#endif
+         cnf_capacity = 1;
+         cnf_echoplus = 0;
+         cnf_stamp    = 0;
+         break;
+
+         case 'C':
+         cnf_control = optarg;
+         break;
+
          case 'd':
          cnf_drop_perct = atoi(optarg);
          if ((cnf_drop_perct < 0) || (cnf_drop_perct > 99))
@@ -323,6 +707,8 @@ main(
 
          case 'e':
          cnf_echoplus = 1;
+         cnf_stamp    = 0;
+         cnf_capacity = 0;
          break;
 
          case 'f':
@@ -385,6 +771,22 @@ main(
 
          case 'r':
          cnf_echoplus = 0;
+         cnf_stamp    = 0;
+         cnf_capacity = 0;
+         break;
+
+         case 'S':
+         cnf_echoplus = 0;
+         cnf_stamp    = 1;
+         cnf_capacity = 0;
+         break;
+
+         case 'Q':
+         cnf_reflect_tos = 1;
+         break;
+
+         case 'T':
+         cnf_transparent = 1;
          break;
 
          case 'u':
@@ -418,6 +820,13 @@ main(
       };
    };
 
+   // transparent reply sockets are bound after dropping privileges
+   if ( ((cnf_transparent)) && ((cnf_uid)) )
+   {
+      my_usage_error("transparent mode can not be combined with `-u'");
+      return(1);
+   };
+
    // set defaults for setuid/setgid
    cnf_gid = (cnf_gid == 0) ? getgid() : cnf_gid;
    cnf_uid = (cnf_uid == 0) ? getuid() : cnf_uid;
@@ -439,6 +848,7 @@ main(
    signal(SIGINT,  my_sighandler);
    signal(SIGQUIT, my_sighandler);
    signal(SIGTERM, my_sighandler);
+   signal(SIGUSR1, my_sighandler);
 
    // seed psuedo random number generator
    my_debug("seeding psuedo random number generator");
@@ -467,9 +877,31 @@ main(
    // loops
    conn = 0;
    while(!(should_stop))
-      my_loop(s, &conn);
+   {
+      if ((cnf_capacity))
+         my_capacity_loop(s);
+      else
+         my_loop(s, &conn);
+      if ((should_report))
+      {
+         should_report = 0;
+         my_local_report();
+      };
+   };
 
    // close syslog
+   if ((cnf_aggregate))
+      my_flow_sweep(time(NULL), 1);
+   if (ctl_sock != -1)
+   {
+      for(idx = 0; (idx < MY_CTL_MAX); idx++)
+         if ((ctl_conns[idx].start))
+            my_control_close(&ctl_conns[idx]);
+      close(ctl_sock);
+      unlink(cnf_control);
+   };
+   my_tproxy_close();
+   my_local_report();
    syslog(LOG_NOTICE, "daemon stopping");
    close(s);
    unlink(cnf_pidfile);
@@ -479,110 +911,613 @@ main(
 }
 
 
-// daemonize process
+// receive capacity test load and send status feedback
 int
-my_daemonize(
-         void )
+my_capacity_loop(
+         int                           s )
 {
-   int                       s;
-   int                       rc;
-   int                       fd;
-   int                       opt;
-   socklen_t                 socklen;
-   char                      pidfile[512];
-   char                      buff[16];
-   char                      addr_str[512];
-   pid_t                     pid;
-   unsigned short            port;
-   FILE                    * fs;
-   struct stat               sb;
-   union
-   {
-      struct sockaddr         sa;
-      struct sockaddr_in      sin;
-      struct sockaddr_in6     sin6;
-      struct sockaddr_storage ss;
-   } sa;
+#if defined(HAVE_RECVMMSG)
+   int                        rc;
+   int                        len;
+   unsigned                   pos;
+   unsigned                   batch;
+   size_t                     idx;
+   int64_t                    delay;
+   uint32_t                   seq;
+   uint64_t                   now;
+   uint64_t                   tx;
+   struct timespec            ts;
+   struct pollfd              fds[2+MY_CTL_MAX];
+   struct my_capacity       * cap;
+   struct my_capacity       * slot;
+   struct my_capacity       * oldest;
+   char                       addrstr[INET6_ADDRSTRLEN];
+   struct mmsghdr             msgs[MY_CAP_BATCH];
+   struct iovec               iovs[MY_CAP_BATCH];
+   union my_sa                addrs[MY_CAP_BATCH];
+   struct capacity_load       hdrs[MY_CAP_BATCH];
+#if defined(SO_RXQ_OVFL)
+   uint32_t                   ovfl;
+   struct cmsghdr           * cmsg;
+   char                       ctrl[MY_CAP_BATCH][CMSG_SPACE(sizeof(uint32_t))];
+#endif
 
-   // check for existing instance
-   fs = NULL;
-   my_debug("checking for existing PID file (%s)", cnf_pidfile);
-   if (stat(cnf_pidfile, &sb) == -1)
-   {
-      if (errno != ENOENT)
-      {
-         my_error("stat(): %s", strerror(errno));
-         return(-1);
-      };
-   } else if ((fs = fopen(cnf_pidfile, "r")) == NULL)
+   // wake at least once per feedback interval to send status
+   fds[0].fd      = s;
+   fds[0].events  = POLLIN;
+   fds[0].revents = 0;
+   my_control_fds(&fds[1]);
+   rc = poll(fds, 2+MY_CTL_MAX, 10);
+   if ( (rc >= 0) && (ctl_sock != -1) )
+      my_control_poll(&fds[1]);
+
+   // only the load header is copied, MSG_TRUNC reports full datagram size
+   for(batch = 0; ( (rc > 0) && ((fds[0].revents & POLLIN)) && (batch < 16) ); batch++)
    {
-      if (errno != ENOENT)
+      memset(msgs, 0, sizeof(msgs));
+      for(pos = 0; (pos < MY_CAP_BATCH); pos++)
       {
-         my_error("fopen(): %s", strerror(errno));
-         return(-1);
+         iovs[pos].iov_base            = &hdrs[pos];
+         iovs[pos].iov_len             = sizeof(struct capacity_load);
+         msgs[pos].msg_hdr.msg_name    = &addrs[pos];
+         msgs[pos].msg_hdr.msg_namelen = sizeof(union my_sa);
+         msgs[pos].msg_hdr.msg_iov     = &iovs[pos];
+         msgs[pos].msg_hdr.msg_iovlen  = 1;
+#if defined(SO_RXQ_OVFL)
+         msgs[pos].msg_hdr.msg_control    = ctrl[pos];
+         msgs[pos].msg_hdr.msg_controllen = sizeof(ctrl[pos]);
+#endif
       };
-   } else if (fscanf(fs, "%i", &pid) != 1)
-   {
-      fclose(fs);
-   } else
-   {
-      fclose(fs);
-      if (kill(pid, 0) == -1)
+      if ((len = recvmmsg(s, msgs, MY_CAP_BATCH, MSG_DONTWAIT | MSG_TRUNC, NULL)) < 1)
+         break;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      now = ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+
+      for(pos = 0; (pos < (unsigned)len); pos++)
       {
-         if (errno == ESRCH)
+         if ( (msgs[pos].msg_len < sizeof(struct capacity_load)) || (ntohl(hdrs[pos].magic) != MY_CAP_LOAD_MAGIC) )
          {
-            my_debug("removing stale PID file");
-            unlink(cnf_pidfile);
-         } else
+            local_other.inval++;
+            continue;
+         };
+
+         // find session, replacing an unused or least recently active session
+         cap    = NULL;
+         oldest = NULL;
+         for(idx = 0; ( (idx < MY_CAP_SESSIONS) && (!(cap)) ); idx++)
          {
-            my_error("kill(): %s", strerror(errno));
-            return(-1);
+            slot = &cap_sessions[idx];
+            if ( ((slot->active)) && (slot->session == hdrs[pos].session) &&
+                 (!(memcmp(&slot->addr, &addrs[pos], msgs[pos].msg_hdr.msg_namelen))) )
+               cap = slot;
+            else if ( (!(oldest)) || ( ((oldest->active)) && ( (!(slot->active)) || (slot->last_rx < oldest->last_rx) ) ) )
+               oldest = slot;
          };
-      } else
-      {
-         my_error("daemon already running");
-         return(-1);
+         if (!(cap))
+         {
+            cap = oldest;
+            memset(cap, 0, sizeof(struct my_capacity));
+            memcpy(&cap->addr, &addrs[pos], msgs[pos].msg_hdr.msg_namelen);
+            cap->addrlen        = msgs[pos].msg_hdr.msg_namelen;
+            cap->session        = hdrs[pos].session;
+            cap->next_seq       = ntohl(hdrs[pos].seq);
+            cap->delay_min      = INT64_MAX;
+            cap->start          = now;
+            cap->interval_start = now;
+            cap->next_status    = now + MY_CAP_FEEDBACK;
+            cap->active         = 1;
+            my_sa_ntop(&cap->addr, addrstr, sizeof(addrstr), NULL);
+            syslog(LOG_NOTICE, "capacity: client: %s; session %08" PRIx32 " started", addrstr, ntohl(cap->session));
+         };
+         cap->last_rx = now;
+
+#if defined(SO_RXQ_OVFL)
+         // datagrams dropped by the receive buffer show the receiver, not the
+         // path, limits the load and are attributed to the next session read
+         for(cmsg = CMSG_FIRSTHDR(&msgs[pos].msg_hdr); (cmsg != NULL); cmsg = CMSG_NXTHDR(&msgs[pos].msg_hdr, cmsg))
+         {
+            if ( (cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SO_RXQ_OVFL) )
+               continue;
+            memcpy(&ovfl, CMSG_DATA(cmsg), sizeof(ovfl));
+            cap->rx_drops += ovfl - cap_ovfl;
+            cap_ovfl       = ovfl;
+         };
+#endif
+
+         // sequence anomalies
+         seq = ntohl(hdrs[pos].seq);
+         if (seq == cap->next_seq)
+            cap->next_seq++;
+         else if ((int32_t)(seq - cap->next_seq) > 0)
+         {
+            cap->seq_gap  += seq - cap->next_seq;
+            cap->next_seq  = seq + 1;
+         } else
+            cap->seq_ooo++;
+
+         // one-way delay variation above session minimum, clocks of client
+         // and server need not be synchronized
+         tx    = ((uint64_t)ntohl(hdrs[pos].tx_sec) * 1000000000ULL) + ntohl(hdrs[pos].tx_nsec);
+         delay = (int64_t)(now - tx);
+         cap->delay_min = (delay < cap->delay_min) ? delay : cap->delay_min;
+         cap->dvar_max  = ((delay - cap->delay_min) > cap->dvar_max) ? (delay - cap->delay_min) : cap->dvar_max;
+
+         cap->rx_pkts++;
+         cap->rx_bytes += msgs[pos].msg_len;
       };
+      if (len < MY_CAP_BATCH)
+         break;
    };
 
-   // create PID file
-   my_debug("creating PID file");
-   strncpy(pidfile, cnf_pidfile, sizeof(pidfile)-7);
-   strcat(pidfile, "XXXXXX");
-   if ((fd = mkstemp(pidfile)) == -1)
-   {
-      my_error("mkstemp(): %s", strerror(errno));
-      return(-1);
-   };
-   my_debug("temp pidfile: %s", pidfile);
-   if (link(pidfile, cnf_pidfile) == -1)
-   {
-      my_error("mkstemp(): %s", strerror(errno));
-      close(fd);
-      unlink(pidfile);
-      return(-1);
-   };
-   unlink(pidfile);
-   if (fchmod(fd, 0644) == -1)
+   // send status feedback and expire idle sessions
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   now = ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+   for(idx = 0; (idx < MY_CAP_SESSIONS); idx++)
    {
-      my_error("fchmod(): %s", strerror(errno));
-      close(fd);
-      return(-1);
-   };
-   if ( (cnf_uid != getuid()) ||
-        (cnf_gid != getgid()) )
-   {
-      if (fchown(fd, cnf_uid, cnf_gid) == -1)
-      {
-         my_error("fchown(): %s", strerror(errno));
-         close(fd);
-         return(-1);
-      };
+      cap = &cap_sessions[idx];
+      if (!(cap->active))
+         continue;
+      if (now >= cap->next_status)
+         my_capacity_status(s, cap, now);
+      if ((now - cap->last_rx) < ((uint64_t)MY_CAP_IDLE * 1000000000ULL))
+         continue;
+      my_sa_ntop(&cap->addr, addrstr, sizeof(addrstr), NULL);
+      syslog(LOG_NOTICE, "capacity: client: %s; session %08" PRIx32 " ended; packets: %" PRIu64 "; bytes: %" PRIu64 "; seq gaps: %" PRIu64 "; out of order: %" PRIu64 "; receiver drops: %" PRIu64 "; rate: %" PRIu64 " Mbit/s;",
+             addrstr, ntohl(cap->session), cap->total_pkts, cap->total_bytes, cap->total_gap, cap->total_ooo, cap->total_drops,
+             ((cap->last_rx > cap->start)) ? ((cap->total_bytes * 8000) / (cap->last_rx - cap->start)) : 0);
+      cap->active = 0;
    };
-   my_debug("pidfile: %s", cnf_pidfile);
 
-   // determines interface on which to listen
-   memset(&sa, 0, sizeof(sa));
+   return(0);
+#else
+   // rejected during option processing
+   (void)s;
+   should_stop = 1;
+   return(-1);
+#endif
+}
+
+
+// send capacity status feedback and reset interval counters
+void
+my_capacity_status(
+         int                           s,
+         struct my_capacity *          cap,
+         uint64_t                      now )
+{
+   struct capacity_status     msg;
+
+   cap->status_seq++;
+   msg.magic     = htonl(MY_CAP_STATUS_MAGIC);
+   msg.session   = cap->session;
+   msg.seq       = htonl(cap->status_seq);
+   msg.interval  = htonl((uint32_t)((now - cap->interval_start) / 1000));
+   msg.rx_pkts   = htonl(cap->rx_pkts);
+   msg.rx_bytes  = htonl(cap->rx_bytes);
+   msg.seq_gap   = htonl(cap->seq_gap);
+   msg.seq_ooo   = htonl(cap->seq_ooo);
+   msg.dvar_max  = htonl((uint32_t)(cap->dvar_max / 1000));
+   msg.rx_drops  = htonl(cap->rx_drops);
+   sendto(s, &msg, sizeof(msg), 0, &cap->addr.sa, cap->addrlen);
+
+   cap->total_pkts     += cap->rx_pkts;
+   cap->total_bytes    += cap->rx_bytes;
+   cap->total_gap      += cap->seq_gap;
+   cap->total_ooo      += cap->seq_ooo;
+   cap->total_drops    += cap->rx_drops;
+   cap->rx_pkts         = 0;
+   cap->rx_bytes        = 0;
+   cap->seq_gap         = 0;
+   cap->seq_ooo         = 0;
+   cap->rx_drops        = 0;
+   cap->dvar_max        = 0;
+   cap->interval_start  = now;
+   cap->next_status    += MY_CAP_FEEDBACK;
+   if (cap->next_status <= now)
+      cap->next_status = now + MY_CAP_FEEDBACK;
+
+   return;
+}
+
+
+// close control connection
+void
+my_control_close(
+         struct my_ctlconn *           connp )
+{
+   close(connp->s);
+   free(connp->out);
+   memset(connp, 0, sizeof(struct my_ctlconn));
+   connp->s = -1;
+   return;
+}
+
+
+// execute control command and buffer response
+void
+my_control_exec(
+         struct my_ctlconn *           connp )
+{
+   int                        val;
+   size_t                     count;
+   size_t                     limit;
+   size_t                     idx;
+   uint32_t                   pos;
+   time_t                     now;
+   FILE                     * fs;
+   char                     * cmd;
+   char                     * arg;
+   char                     * num;
+   char                     * ptr;
+   char                       addr_str[INET6_ADDRSTRLEN];
+   unsigned short             port;
+   struct my_flow           * flowp;
+   struct my_local          * lap;
+
+   // response is rendered to memory and written as the peer accepts it
+   if ((fs = open_memstream(&connp->out, &connp->out_len)) == NULL)
+   {
+      my_control_close(connp);
+      return;
+   };
+   cmd = strtok_r(connp->line, " \t\r\n", &ptr);
+   arg = strtok_r(NULL, " \t\r\n", &ptr);
+   num = strtok_r(NULL, " \t\r\n", &ptr);
+   now = time(NULL);
+
+   if (!(cmd))
+   {
+      fprintf(fs, "error: missing command\n");
+
+   } else if (!(strcasecmp(cmd, "help")))
+   {
+      fprintf(fs, "flows [count]          list most recent flows\n");
+      fprintf(fs, "help                   list commands\n");
+      fprintf(fs, "local                  list per local address counters\n");
+      fprintf(fs, "set delay <usec>       set echo delay range\n");
+      fprintf(fs, "set drop <num>         set packet drop probability [0-99]\n");
+      fprintf(fs, "set verbose <num>      set runtime verbosity\n");
+      fprintf(fs, "stats                  display daemon counters\n");
+
+   } else if (!(strcasecmp(cmd, "stats")))
+   {
+      fprintf(fs, "uptime: %lu s\n",      (unsigned long)(now - start_time));
+      fprintf(fs, "requests: %" PRIu32 "\n", state.req_sn);
+      fprintf(fs, "replies: %" PRIu32 "\n",  state.res_sn);
+      fprintf(fs, "failures: %" PRIu32 "\n", state.failures);
+      fprintf(fs, "flows: %zu\n",          flow_used);
+      fprintf(fs, "drop: %i%%\n",          cnf_drop_perct);
+      fprintf(fs, "delay: %u us\n",        cnf_delay);
+      fprintf(fs, "verbose: %" PRIi32 "\n", cnf_verbose);
+      fprintf(fs, "ecn: not-ect %" PRIu64 "; ect1 %" PRIu64 "; ect0 %" PRIu64 "; ce %" PRIu64 ";\n",
+         tos_ecn[0], tos_ecn[1], tos_ecn[2], tos_ecn[3]);
+      for(idx = 0; (idx < 64); idx++)
+         if ((tos_dscp[idx]))
+            fprintf(fs, "dscp: %zu; requests: %" PRIu64 ";\n", idx, tos_dscp[idx]);
+
+   } else if (!(strcasecmp(cmd, "flows")))
+   {
+      limit = ((arg)) ? (size_t)strtoul(arg, NULL, 10) : MY_FLOW_MAX;
+      for(pos = flow_newest, count = 0; ( ((pos)) && (count < limit) ); pos = flowp->older)
+      {
+         flowp = &flows[pos-1];
+         count++;
+         if (my_sa_ntop(&flowp->addr, addr_str, sizeof(addr_str), &port) == -1)
+            continue;
+         fprintf(fs,
+            "flow: [%s]:%hu; pkts: %" PRIu64 "; bytes: %" PRIu64 "; pps: %" PRIu64 "; bps: %" PRIu64 "; drops: %" PRIu64 "; invalid: %" PRIu64 "; proc min/avg/max: %" PRIu64 "/%" PRIu64 "/%" PRIu64 " us; first: %lu s; last: %lu s;\n",
+            addr_str,
+            port,
+            flowp->total.packets,
+            flowp->total.bytes,
+            (flowp->rate_sec == now) ? flowp->prev_pkts        : ((flowp->rate_sec == (now-1)) ? flowp->rate_pkts : 0),
+            (flowp->rate_sec == now) ? flowp->prev_bytes * 8   : ((flowp->rate_sec == (now-1)) ? flowp->rate_bytes * 8 : 0),
+            flowp->total.drops,
+            flowp->total.inval,
+            ((flowp->total.proc_cnt)) ? flowp->total.proc_min/1000 : 0,
+            ((flowp->total.proc_cnt)) ? (flowp->total.proc_sum/flowp->total.proc_cnt)/1000 : 0,
+            flowp->total.proc_max/1000,
+            (unsigned long)(now - flowp->first_seen),
+            (unsigned long)(now - flowp->last_seen)
+         );
+      };
+
+   } else if (!(strcasecmp(cmd, "local")))
+   {
+      for(idx = 0; (idx <= MY_LOCAL_MAX); idx++)
+      {
+         lap = (idx < MY_LOCAL_MAX) ? &local_addrs[idx] : &local_other;
+         if (!(lap->recv))
+            continue;
+         if (my_sa_ntop(&lap->addr, addr_str, sizeof(addr_str), NULL) == -1)
+            strncpy(addr_str, "other", sizeof(addr_str));
+         fprintf(fs, "local: [%s]; recv: %" PRIu64 "; sent: %" PRIu64 "; drop: %" PRIu64 "; invalid: %" PRIu64 ";\n",
+            addr_str, lap->recv, lap->sent, lap->drop, lap->inval);
+      };
+
+   } else if ( (!(strcasecmp(cmd, "set"))) && ((arg)) && ((num)) )
+   {
+      val = atoi(num);
+      if ( (!(strcasecmp(arg, "drop"))) && (val >= 0) && (val <= 99) )
+         cnf_drop_perct = val;
+      else if ( (!(strcasecmp(arg, "delay"))) && (val >= 0) )
+         cnf_delay = (useconds_t)val;
+      else if ( (!(strcasecmp(arg, "verbose"))) && (val >= 0) )
+         cnf_verbose = val;
+      else
+         arg = NULL;
+      if ((arg))
+         syslog(LOG_NOTICE, "control: set %s to %i", arg, val);
+      fprintf(fs, ((arg)) ? "ok\n" : "error: invalid setting or value\n");
+
+   } else
+   {
+      fprintf(fs, "error: unknown command `%s'\n", cmd);
+   };
+
+   fclose(fs);
+   connp->out_pos = 0;
+   shutdown(connp->s, SHUT_RD);
+
+   return;
+}
+
+
+// fill poll descriptors of control socket and connections
+void
+my_control_fds(
+         struct pollfd *               fds )
+{
+   size_t                     idx;
+
+   fds[0].fd      = ctl_sock;
+   fds[0].events  = POLLIN;
+   fds[0].revents = 0;
+   for(idx = 0; (idx < MY_CTL_MAX); idx++)
+   {
+      fds[idx+1].fd      = ((ctl_conns[idx].start)) ? ctl_conns[idx].s : -1;
+      fds[idx+1].events  = ((ctl_conns[idx].out)) ? POLLOUT : POLLIN;
+      fds[idx+1].revents = 0;
+   };
+
+   return;
+}
+
+
+// open control socket
+int
+my_control_open(
+         void )
+{
+   struct sockaddr_un         sun;
+
+   my_debug("creating control socket (%s)", cnf_control);
+   memset(&sun, 0, sizeof(sun));
+   sun.sun_family = AF_UNIX;
+   if (strlen(cnf_control) >= sizeof(sun.sun_path))
+   {
+      my_error("control socket path is too long");
+      return(-1);
+   };
+   strncpy(sun.sun_path, cnf_control, sizeof(sun.sun_path)-1);
+
+   if ((ctl_sock = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+   {
+      my_error("socket(): %s", strerror(errno));
+      return(-1);
+   };
+   unlink(cnf_control);
+   if (bind(ctl_sock, (struct sockaddr *)&sun, sizeof(sun)) == -1)
+   {
+      my_error("bind(): %s: %s", cnf_control, strerror(errno));
+      close(ctl_sock);
+      ctl_sock = -1;
+      return(-1);
+   };
+   chmod(cnf_control, 0600);
+   if ( ( (cnf_uid != getuid()) || (cnf_gid != getgid()) ) && (chown(cnf_control, cnf_uid, cnf_gid) == -1) )
+      my_error("chown(): %s: %s", cnf_control, strerror(errno));
+   if (listen(ctl_sock, 4) == -1)
+   {
+      my_error("listen(): %s", strerror(errno));
+      close(ctl_sock);
+      unlink(cnf_control);
+      ctl_sock = -1;
+      return(-1);
+   };
+   fcntl(ctl_sock, F_SETFL, O_NONBLOCK);
+
+   return(0);
+}
+
+
+// service control socket and connections after poll()
+void
+my_control_poll(
+         struct pollfd *               fds )
+{
+   int                        c;
+   size_t                     idx;
+   ssize_t                    rc;
+   time_t                     now;
+   struct my_ctlconn        * connp;
+
+   now = time(NULL);
+
+   // drop stalled peers before accepting so their slots can be reused
+   for(idx = 0; (idx < MY_CTL_MAX); idx++)
+   {
+      if ( ((ctl_conns[idx].start)) && ((now - ctl_conns[idx].start) > MY_CTL_IDLE) )
+      {
+         my_control_close(&ctl_conns[idx]);
+         fds[idx+1].revents = 0;
+      };
+   };
+
+   // accept new connection, refusing peers beyond MY_CTL_MAX
+   if ((fds[0].revents & POLLIN))
+   {
+      while ((c = accept(ctl_sock, NULL, NULL)) != -1)
+      {
+         for(idx = 0; ( (idx < MY_CTL_MAX) && ((ctl_conns[idx].start)) ); idx++);
+         if (idx >= MY_CTL_MAX)
+         {
+            close(c);
+            continue;
+         };
+         fcntl(c, F_SETFL, O_NONBLOCK);
+         memset(&ctl_conns[idx], 0, sizeof(struct my_ctlconn));
+         ctl_conns[idx].s     = c;
+         ctl_conns[idx].start = now;
+      };
+   };
+
+   for(idx = 0; (idx < MY_CTL_MAX); idx++)
+   {
+      connp = &ctl_conns[idx];
+      if (!(connp->start))
+         continue;
+
+      // read single command
+      if ( (!(connp->out)) && ((fds[idx+1].revents & (POLLIN|POLLHUP|POLLERR))) )
+      {
+         rc = read(connp->s, &connp->line[connp->len], (sizeof(connp->line)-1-connp->len));
+         if ( (rc == -1) && ( (errno == EAGAIN) || (errno == EINTR) ) )
+            continue;
+         if (rc == -1)
+         {
+            my_control_close(connp);
+            continue;
+         };
+         connp->len += (size_t)rc;
+         connp->line[connp->len] = '\0';
+         if ( (rc > 0) && (!(strchr(connp->line, '\n'))) && (connp->len < (sizeof(connp->line)-1)) )
+            continue;
+         my_control_exec(connp);
+         continue;
+      };
+
+      // write buffered response
+      if ( ((connp->out)) && ((fds[idx+1].revents & (POLLOUT|POLLHUP|POLLERR))) )
+      {
+         rc = write(connp->s, &connp->out[connp->out_pos], connp->out_len - connp->out_pos);
+         if ( (rc == -1) && ( (errno == EAGAIN) || (errno == EINTR) ) )
+            continue;
+         if (rc > 0)
+            connp->out_pos += (size_t)rc;
+         if ( (rc < 1) || (connp->out_pos >= connp->out_len) )
+            my_control_close(connp);
+      };
+   };
+
+   return;
+}
+
+
+// daemonize process
+int
+my_daemonize(
+         void )
+{
+   int                       s;
+   int                       rc;
+   int                       fd;
+   int                       opt;
+   socklen_t                 socklen;
+   char                      pidfile[512];
+   char                      buff[16];
+   char                      addr_str[512];
+   pid_t                     pid;
+   unsigned short            port;
+   FILE                    * fs;
+   struct stat               sb;
+   union
+   {
+      struct sockaddr         sa;
+      struct sockaddr_in      sin;
+      struct sockaddr_in6     sin6;
+      struct sockaddr_storage ss;
+   } sa;
+
+   // check for existing instance
+   fs = NULL;
+   my_debug("checking for existing PID file (%s)", cnf_pidfile);
+   if (stat(cnf_pidfile, &sb) == -1)
+   {
+      if (errno != ENOENT)
+      {
+         my_error("stat(): %s", strerror(errno));
+         return(-1);
+      };
+   } else if ((fs = fopen(cnf_pidfile, "r")) == NULL)
+   {
+      if (errno != ENOENT)
+      {
+         my_error("fopen(): %s", strerror(errno));
+         return(-1);
+      };
+   } else if (fscanf(fs, "%i", &pid) != 1)
+   {
+      fclose(fs);
+   } else
+   {
+      fclose(fs);
+      if (kill(pid, 0) == -1)
+      {
+         if (errno == ESRCH)
+         {
+            my_debug("removing stale PID file");
+            unlink(cnf_pidfile);
+         } else
+         {
+            my_error("kill(): %s", strerror(errno));
+            return(-1);
+         };
+      } else
+      {
+         my_error("daemon already running");
+         return(-1);
+      };
+   };
+
+   // create PID file
+   my_debug("creating PID file");
+   strncpy(pidfile, cnf_pidfile, sizeof(pidfile)-7);
+   strcat(pidfile, "XXXXXX");
+   if ((fd = mkstemp(pidfile)) == -1)
+   {
+      my_error("mkstemp(): %s", strerror(errno));
+      return(-1);
+   };
+   my_debug("temp pidfile: %s", pidfile);
+   if (link(pidfile, cnf_pidfile) == -1)
+   {
+      my_error("mkstemp(): %s", strerror(errno));
+      close(fd);
+      unlink(pidfile);
+      return(-1);
+   };
+   unlink(pidfile);
+   if (fchmod(fd, 0644) == -1)
+   {
+      my_error("fchmod(): %s", strerror(errno));
+      close(fd);
+      return(-1);
+   };
+   if ( (cnf_uid != getuid()) ||
+        (cnf_gid != getgid()) )
+   {
+      if (fchown(fd, cnf_uid, cnf_gid) == -1)
+      {
+         my_error("fchown(): %s", strerror(errno));
+         close(fd);
+         return(-1);
+      };
+   };
+   my_debug("pidfile: %s", cnf_pidfile);
+
+   // determines interface on which to listen
+   memset(&sa, 0, sizeof(sa));
    if (!(cnf_listen))
    {
       sa.sin6.sin6_family = AF_INET6;
@@ -635,8 +1570,89 @@ my_daemonize(
       return(-1);
    };
 
+   // accept packets for foreign destinations
+   if ((cnf_transparent))
+   {
+#if defined(IP_TRANSPARENT) && defined(IP_RECVORIGDSTADDR)
+      rc = 0;
+#if defined(IPV6_TRANSPARENT) && defined(IPV6_RECVORIGDSTADDR)
+      if ( (rc == 0) && (sa.sa.sa_family == AF_INET6) && ((rc = setsockopt(s, IPPROTO_IPV6, IPV6_TRANSPARENT, (void *)&opt, sizeof(int))) == -1) )
+         my_error("setsockopt(IPV6_TRANSPARENT): %s", strerror(errno));
+      if ( (rc == 0) && (sa.sa.sa_family == AF_INET6) && ((rc = setsockopt(s, IPPROTO_IPV6, IPV6_RECVORIGDSTADDR, (void *)&opt, sizeof(int))) == -1) )
+         my_error("setsockopt(IPV6_RECVORIGDSTADDR): %s", strerror(errno));
+#endif
+      if ( (rc == 0) && ((rc = setsockopt(s, IPPROTO_IP, IP_TRANSPARENT, (void *)&opt, sizeof(int))) == -1) )
+         my_error("setsockopt(IP_TRANSPARENT): %s", strerror(errno));
+      if ( (rc == 0) && ((rc = setsockopt(s, IPPROTO_IP, IP_RECVORIGDSTADDR, (void *)&opt, sizeof(int))) == -1) )
+         my_error("setsockopt(IP_RECVORIGDSTADDR): %s", strerror(errno));
+      if (rc == -1)
+      {
+         close(s);
+         close(fd);
+         unlink(cnf_pidfile);
+         return(-1);
+      };
+#else
+      my_error("transparent mode is not supported on this platform");
+      close(s);
+      close(fd);
+      unlink(cnf_pidfile);
+      return(-1);
+#endif
+   };
+
+   // capacity tests receive bursts at line rate
+   if ((cnf_capacity))
+   {
+      opt = MY_CAP_RCVBUF;
+      if (setsockopt(s, SOL_SOCKET, SO_RCVBUF, (void *)&opt, sizeof(int)) == -1)
+         my_error("setsockopt(SO_RCVBUF): %s", strerror(errno));
+      opt = 1;
+#if defined(SO_RXQ_OVFL)
+      if (setsockopt(s, SOL_SOCKET, SO_RXQ_OVFL, (void *)&opt, sizeof(int)) == -1)
+         my_error("setsockopt(SO_RXQ_OVFL): %s", strerror(errno));
+#endif
+   };
+
+   // request TTL of received packets for STAMP reflector
+   if ( ((cnf_stamp)) && (akudp_socket_recvttl(s, sa.sa.sa_family) == -1) )
+      my_error("setsockopt(%s): %s", (sa.sa.sa_family == AF_INET6) ? "IPV6_RECVHOPLIMIT" : "IP_RECVTTL", strerror(errno));
+
+   // request traffic class of received packets
+   if (akudp_socket_tclass(s, sa.sa.sa_family, -1) == -1)
+      my_error("setsockopt(%s): %s", (sa.sa.sa_family == AF_INET6) ? "IPV6_RECVTCLASS" : "IP_RECVTOS", strerror(errno));
+
+   // request destination address of received packets
+#if defined(IPV6_RECVPKTINFO)
+   if (sa.sa.sa_family == AF_INET6)
+   {
+      if (setsockopt(s, IPPROTO_IPV6, IPV6_RECVPKTINFO, (void *)&opt, sizeof(int)) == -1)
+      {
+         my_error("setsockopt(IPV6_RECVPKTINFO): %s", strerror(errno));
+         close(s);
+         close(fd);
+         unlink(cnf_pidfile);
+         return(-1);
+      };
+   };
+#endif
+#if defined(IP_PKTINFO)
+   if (sa.sa.sa_family == AF_INET)
+   {
+      if (setsockopt(s, IPPROTO_IP, IP_PKTINFO, (void *)&opt, sizeof(int)) == -1)
+      {
+         my_error("setsockopt(IP_PKTINFO): %s", strerror(errno));
+         close(s);
+         close(fd);
+         unlink(cnf_pidfile);
+         return(-1);
+      };
+   };
+#endif
+
    // bind socket to interface
    my_debug("binding socket");
+   listen_family = sa.sa.sa_family;
    if (bind(s, &sa.sa, socklen) == -1)
    {
       my_error("bind(): %s", strerror(errno));
@@ -676,6 +1692,15 @@ my_daemonize(
       return(-1);
    };
 
+   // open control socket
+   if ( ((cnf_control)) && (my_control_open() == -1) )
+   {
+      close(s);
+      close(fd);
+      unlink(cnf_pidfile);
+      return(-1);
+   };
+
    // change ownership
    if ( (getgid() != cnf_gid) && (setregid(cnf_gid, cnf_gid) == -1) )
    {
@@ -707,79 +1732,422 @@ my_daemonize(
          case 0:
          break;
 
-         default:
-         my_debug("forking to %i", pid);
-         closelog();
-         close(fd);
-         close(s);
-         return(0);
-      };
+         default:
+         my_debug("forking to %i", pid);
+         closelog();
+         close(fd);
+         close(s);
+         if (ctl_sock != -1)
+            close(ctl_sock);
+         return(0);
+      };
+   };
+
+   // record PID in pidfile
+   pid = getpid();
+   snprintf(buff, sizeof(buff), "%i", pid);
+   if (write(fd, buff, strlen(buff)) == -1)
+   {
+      close(fd);
+      unlink(cnf_pidfile);
+      my_error("write(): %s: %s", cnf_pidfile, strerror(errno));
+      return(-1);
+   };
+   close(fd);
+
+   // opens syslog
+   openlog(prog_name, LOG_PID | (((cnf_dont_fork)) ? LOG_PERROR : 0), cnf_facility);
+   syslog(LOG_NOTICE, "%s v%s", PROGRAM_NAME, PACKAGE_VERSION);
+   syslog(LOG_NOTICE, "echo plus enabled: %s", ((cnf_echoplus)) ? "yes" : "no");
+   syslog(LOG_NOTICE, "STAMP reflector enabled: %s", ((cnf_stamp)) ? "yes" : "no");
+   syslog(LOG_NOTICE, "random delay: %u us", cnf_delay);
+   syslog(LOG_NOTICE, "drop probability: %u%%", cnf_drop_perct);
+   syslog(LOG_NOTICE, "transparent mode: %s", ((cnf_transparent)) ? "yes" : "no");
+   syslog(LOG_NOTICE, "reflect traffic class: %s", ((cnf_reflect_tos)) ? "yes" : "no");
+   if ((cnf_aggregate))
+      syslog(LOG_NOTICE, "flow records: every %lu s", (unsigned long)cnf_aggregate);
+   if ((cnf_control))
+      syslog(LOG_NOTICE, "control socket: %s", cnf_control);
+   start_time = time(NULL);
+   syslog(LOG_NOTICE, "running as UID: %u", getuid());
+   syslog(LOG_NOTICE, "running as GID: %u", getgid());
+   syslog(LOG_NOTICE, "listening on [%s]:%hu", addr_str, port);
+
+   return(s);
+}
+
+
+// display debug message
+void
+my_debug(
+         const char *                  fmt,
+         ... )
+{
+   va_list args;
+
+   if (!(cnf_verbose))
+      return;
+
+   printf("%s: ", prog_name);
+
+   va_start(args, fmt);
+   vprintf(fmt, args);
+   va_end(args);
+
+   printf("\n");
+
+   return;
+}
+
+
+// display error message
+void
+my_error(
+         const char *                  fmt,
+         ... )
+{
+   va_list args;
+
+   fprintf(stderr, "%s: error: ", prog_name);
+
+   va_start(args, fmt);
+   vfprintf(stderr, fmt, args);
+   va_end(args);
+
+   fprintf(stderr, "\n");
+
+   return;
+}
+
+
+// find or allocate recent flow for client address
+struct my_flow *
+my_flow_lookup(
+         const union my_sa *           sap,
+         time_t                        now )
+{
+   size_t                     pos;
+   size_t                     addrlen;
+   uint32_t                   hash;
+   uint32_t                   idx;
+   uint32_t                 * linkp;
+   const uint8_t            * bytes;
+   struct my_flow           * flowp;
+   union my_sa                key;
+
+   // hash family, port, and address (FNV-1a) of a copy without flow label
+   addrlen = (sap->ss.ss_family == AF_INET6) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+   memset(&key, 0, sizeof(key));
+   memcpy(&key, sap, addrlen);
+   if (key.ss.ss_family == AF_INET6)
+      key.sin6.sin6_flowinfo = 0;
+   bytes   = (const uint8_t *)&key.ss;
+   hash    = 2166136261U;
+   for(pos = 0; (pos < addrlen); pos++)
+      hash = (hash ^ bytes[pos]) * 16777619U;
+
+   // search hash chain
+   for(idx = flow_hash[hash & (MY_FLOW_HASH-1)]; ((idx)); idx = flowp->next)
+   {
+      flowp = &flows[idx-1];
+      if ( (flowp->hash == hash) && (!(memcmp(&flowp->addr, &key, addrlen))) )
+         break;
+   };
+
+   if (!(idx))
+   {
+      // allocate unused slot or recycle least recently active flow
+      if (flow_used < MY_FLOW_MAX)
+      {
+         idx = (uint32_t)++flow_used;
+      } else
+      {
+         idx   = flow_oldest;
+         flowp = &flows[idx-1];
+         if ( ((cnf_aggregate)) && ((flowp->interval.packets)) )
+            my_flow_export(flowp, now, "evicted");
+         for(linkp = &flow_hash[flowp->hash & (MY_FLOW_HASH-1)]; (*linkp != idx); linkp = &flows[*linkp-1].next);
+         *linkp = flowp->next;
+         my_flow_unlink(idx);
+      };
+
+      // initialize flow
+      flowp = &flows[idx-1];
+      memset(flowp, 0, sizeof(struct my_flow));
+      memcpy(&flowp->addr, &key, addrlen);
+      flowp->hash             = hash;
+      flowp->first_seen       = now;
+      flowp->interval_start   = now;
+      flowp->rate_sec         = now;
+      flowp->next             = flow_hash[hash & (MY_FLOW_HASH-1)];
+      flow_hash[hash & (MY_FLOW_HASH-1)] = idx;
+   } else
+   {
+      my_flow_unlink(idx);
+   };
+
+   // move flow to front of recency list
+   flowp->newer = 0;
+   flowp->older = flow_newest;
+   if ((flow_newest))
+      flows[flow_newest-1].newer = idx;
+   flow_newest = idx;
+   if (!(flow_oldest))
+      flow_oldest = idx;
+
+   return(flowp);
+}
+
+
+// log flow record and reset interval counters
+void
+my_flow_export(
+         struct my_flow *              flowp,
+         time_t                        now,
+         const char *                  reason )
+{
+   char                       addr_str[INET6_ADDRSTRLEN];
+   unsigned short             port;
+   struct my_counters       * cntp;
+
+   cntp = &flowp->interval;
+   if (my_sa_ntop(&flowp->addr, addr_str, sizeof(addr_str), &port) == -1)
+      return;
+
+   syslog(LOG_INFO,
+      "flow: client: [%s]:%hu; start: %lu; end: %lu; duration: %lu s; packets: %" PRIu64 "; bytes: %" PRIu64 "; drops: %" PRIu64 "; invalid: %" PRIu64 "; proc min/avg/max: %" PRIu64 ".%03" PRIu64 "/%" PRIu64 ".%03" PRIu64 "/%" PRIu64 ".%03" PRIu64 " us; reason: %s;",
+      addr_str,
+      port,
+      (unsigned long)flowp->interval_start,
+      (unsigned long)flowp->last_seen,
+      (unsigned long)(now - flowp->interval_start),
+      cntp->packets,
+      cntp->bytes,
+      cntp->drops,
+      cntp->inval,
+      ((cntp->proc_cnt)) ? cntp->proc_min/1000                    : 0, ((cntp->proc_cnt)) ? cntp->proc_min%1000                    : 0,
+      ((cntp->proc_cnt)) ? (cntp->proc_sum/cntp->proc_cnt)/1000   : 0, ((cntp->proc_cnt)) ? (cntp->proc_sum/cntp->proc_cnt)%1000   : 0,
+      cntp->proc_max/1000,                                             cntp->proc_max%1000,
+      reason
+   );
+
+   memset(cntp, 0, sizeof(struct my_counters));
+   flowp->interval_start = now;
+
+   return;
+}
+
+
+// update flow counters
+void
+my_flow_record(
+         struct my_counters *          cntp,
+         int                           mode,
+         uint64_t                      val )
+{
+   switch(mode)
+   {
+      case MY_RECV:
+      cntp->packets++;
+      cntp->bytes += val;
+      break;
+
+      case MY_DROP:
+      cntp->drops++;
+      break;
+
+      case MY_INVAL:
+      cntp->inval++;
+      break;
+
+      case MY_SENT:
+      cntp->proc_min  = ( (!(cntp->proc_cnt)) || (val < cntp->proc_min) ) ? val : cntp->proc_min;
+      cntp->proc_max  = (val > cntp->proc_max) ? val : cntp->proc_max;
+      cntp->proc_sum += val;
+      cntp->proc_cnt++;
+      break;
+
+      default:
+      break;
+   };
+
+   return;
+}
+
+
+// remove flow from recency list
+void
+my_flow_unlink(
+         uint32_t                      idx )
+{
+   struct my_flow           * flowp;
+
+   flowp = &flows[idx-1];
+   if ((flowp->newer))
+      flows[flowp->newer-1].older = flowp->older;
+   else
+      flow_newest = flowp->older;
+   if ((flowp->older))
+      flows[flowp->older-1].newer = flowp->newer;
+   else
+      flow_oldest = flowp->newer;
+   flowp->newer = 0;
+   flowp->older = 0;
+
+   return;
+}
+
+
+// export flow records of active and idle flows
+void
+my_flow_sweep(
+         time_t                        now,
+         int                           force )
+{
+   size_t                     idx;
+   struct my_flow           * flowp;
+
+   for(idx = 0; (idx < MY_FLOW_MAX); idx++)
+   {
+      flowp = &flows[idx];
+      if (!(flowp->interval.packets))
+         continue;
+      if ((force))
+         my_flow_export(flowp, now, "shutdown");
+      else if ((now - flowp->last_seen) >= cnf_aggregate)
+         my_flow_export(flowp, now, "idle");
+      else if ((now - flowp->interval_start) >= cnf_aggregate)
+         my_flow_export(flowp, now, "active");
    };
 
-   // record PID in pidfile
-   pid = getpid();
-   snprintf(buff, sizeof(buff), "%i", pid);
-   if (write(fd, buff, strlen(buff)) == -1)
+   return;
+}
+
+
+// record packet in recent flow
+void
+my_flow_update(
+         struct my_flow *              flowp,
+         time_t                        now,
+         size_t                        bytes )
+{
+   // roll per second rate counters
+   if (flowp->rate_sec != now)
    {
-      close(fd);
-      unlink(cnf_pidfile);
-      my_error("write(): %s: %s", cnf_pidfile, strerror(errno));
-      return(-1);
+      flowp->prev_pkts  = (flowp->rate_sec == (now-1)) ? flowp->rate_pkts  : 0;
+      flowp->prev_bytes = (flowp->rate_sec == (now-1)) ? flowp->rate_bytes : 0;
+      flowp->rate_pkts  = 0;
+      flowp->rate_bytes = 0;
+      flowp->rate_sec   = now;
    };
-   close(fd);
+   flowp->rate_pkts++;
+   flowp->rate_bytes += bytes;
+   flowp->last_seen   = now;
 
-   // opens syslog
-   openlog(prog_name, LOG_PID | (((cnf_dont_fork)) ? LOG_PERROR : 0), cnf_facility);
-   syslog(LOG_NOTICE, "%s v%s", PROGRAM_NAME, PACKAGE_VERSION);
-   syslog(LOG_NOTICE, "echo plus enabled: %s", ((cnf_echoplus)) ? "yes" : "no");
-   syslog(LOG_NOTICE, "random delay: %u us", cnf_delay);
-   syslog(LOG_NOTICE, "drop probability: %u%%", cnf_drop_perct);
-   syslog(LOG_NOTICE, "running as UID: %u", getuid());
-   syslog(LOG_NOTICE, "running as GID: %u", getgid());
-   syslog(LOG_NOTICE, "listening on [%s]:%hu", addr_str, port);
+   // start new flow record interval
+   if (!(flowp->interval.packets))
+      flowp->interval_start = now;
 
-   return(s);
+   my_flow_record(&flowp->total,    MY_RECV, bytes);
+   my_flow_record(&flowp->interval, MY_RECV, bytes);
+
+   return;
 }
 
 
-// display debug message
-void
-my_debug(
-         const char *                  fmt,
-         ... )
+// find or allocate counters for local address
+struct my_local *
+my_local_lookup(
+         union my_sa *                 sap )
 {
-   va_list args;
+   size_t                     pos;
+   uint32_t                   hash;
+   const uint8_t            * addr;
+   size_t                     addrlen;
+   struct my_local          * lap;
 
-   if (!(cnf_verbose))
-      return;
+   // determine address bytes
+   switch(sap->ss.ss_family)
+   {
+      case AF_INET:
+      addr    = (const uint8_t *)&sap->sin.sin_addr;
+      addrlen = sizeof(struct in_addr);
+      break;
 
-   printf("%s: ", prog_name);
+      case AF_INET6:
+      addr    = (const uint8_t *)&sap->sin6.sin6_addr;
+      addrlen = sizeof(struct in6_addr);
+      break;
 
-   va_start(args, fmt);
-   vprintf(fmt, args);
-   va_end(args);
+      default:
+      return(&local_other);
+   };
 
-   printf("\n");
+   // hash address bytes (FNV-1a)
+   hash = 2166136261U;
+   for(pos = 0; (pos < addrlen); pos++)
+      hash = (hash ^ addr[pos]) * 16777619U;
 
-   return;
+   // linear probe for existing entry or empty slot
+   for(pos = 0; (pos < MY_LOCAL_MAX); pos++)
+   {
+      lap = &local_addrs[(hash + pos) % MY_LOCAL_MAX];
+      if (!(lap->addr.ss.ss_family))
+         break;
+      if (lap->addr.ss.ss_family != sap->ss.ss_family)
+         continue;
+      if (sap->ss.ss_family == AF_INET)
+      {
+         if (lap->addr.sin.sin_addr.s_addr == sap->sin.sin_addr.s_addr)
+            return(lap);
+         continue;
+      };
+      if (!(memcmp(&lap->addr.sin6.sin6_addr, &sap->sin6.sin6_addr, sizeof(struct in6_addr))))
+         return(lap);
+   };
+
+   // table full, account against catch all entry
+   if (pos >= MY_LOCAL_MAX)
+      return(&local_other);
+
+   // allocate new entry
+   memcpy(&lap->addr, sap, sizeof(union my_sa));
+
+   return(lap);
 }
 
 
-// display error message
+// log per local address counters
 void
-my_error(
-         const char *                  fmt,
-         ... )
+my_local_report(
+         void )
 {
-   va_list args;
-
-   fprintf(stderr, "%s: error: ", prog_name);
-
-   va_start(args, fmt);
-   vfprintf(stderr, fmt, args);
-   va_end(args);
+   size_t                     idx;
+   char                       addr_str[INET6_ADDRSTRLEN];
+   struct my_local          * lap;
 
-   fprintf(stderr, "\n");
+   for(idx = 0; (idx <= MY_LOCAL_MAX); idx++)
+   {
+      lap = (idx < MY_LOCAL_MAX) ? &local_addrs[idx] : &local_other;
+      if (!(lap->recv))
+         continue;
+      if (my_sa_ntop(&lap->addr, addr_str, sizeof(addr_str), NULL) == -1)
+         strncpy(addr_str, "other", sizeof(addr_str));
+      syslog(LOG_NOTICE,
+         "local: [%s]; recv: %" PRIu64 "; sent: %" PRIu64 "; drop: %" PRIu64 "; invalid: %" PRIu64 ";",
+         addr_str,
+         lap->recv,
+         lap->sent,
+         lap->drop,
+         lap->inval
+      );
+   };
+   for(idx = 0; (idx < 64); idx++)
+      if ((tos_dscp[idx]))
+         syslog(LOG_NOTICE, "dscp: %zu; requests: %" PRIu64 ";", idx, tos_dscp[idx]);
+   if ((tos_ecn[1] + tos_ecn[2] + tos_ecn[3]))
+      syslog(LOG_NOTICE, "ecn: not-ect %" PRIu64 "; ect1 %" PRIu64 "; ect0 %" PRIu64 "; ce %" PRIu64 ";",
+         tos_ecn[0], tos_ecn[1], tos_ecn[2], tos_ecn[3]);
 
    return;
 }
@@ -791,14 +2159,22 @@ my_log_conn(
       int                              mode,
       size_t *                         connp,
       union my_sa *                    sap,
-      struct udp_echo_plus *           msgp,
+      union my_sa *                    localp,
+      const akudp_echoplus_t *         msgp,
       ssize_t                          ssize,
       struct timespec *                tsp,
-      useconds_t                       delay )
+      useconds_t                       delay,
+      uint64_t                         delta )
 {
    const char               * mode_name;
    char                       addr_str[INET6_ADDRSTRLEN];
+   char                       local_str[INET6_ADDRSTRLEN];
    unsigned short             port;
+   unsigned short             local_port;
+
+   // per packet entries are replaced by flow records
+   if ((cnf_aggregate))
+      return(0);
 
    // determine log entry type
    switch(mode)
@@ -811,64 +2187,62 @@ my_log_conn(
    };
 
    // convert address to presentation format
-   switch(sap->ss.ss_family)
+   if (my_sa_ntop(sap, addr_str, sizeof(addr_str), &port) == -1)
    {
-      case AF_INET:
-      inet_ntop(AF_INET, &sap->sin.sin_addr, addr_str, sizeof(addr_str));
-      port =        ntohs(sap->sin.sin_port);
-      break;
-
-      case AF_INET6:
-      inet_ntop(AF_INET6, &sap->sin6.sin6_addr, addr_str, sizeof(addr_str));
-      port =         ntohs(sap->sin6.sin6_port);
-      break;
-
-      default:
       syslog(LOG_DEBUG, "conn %zu: ignoring request from unknown address family: %i", *connp, sap->ss.ss_family);
       return(-1);
    };
+   local_port = cnf_port;
+   if (my_sa_ntop(localp, local_str, sizeof(local_str), &local_port) == -1)
+      strncpy(local_str, "unknown", sizeof(local_str));
 
    // log connection
-   if ((cnf_echoplus))
+   if ( ((cnf_echoplus)) || ((cnf_stamp)) )
    {
       if (mode == MY_SENT)
       {
          syslog(LOG_INFO,
-            "conn %zu: client: [%s]:%hu; %s bytes: %zi; timestamp: %lu.%09lu; seq: %u; delay: %u.%03u ms; delta: %u.%03u ms;",
+            "conn %zu: client: [%s]:%hu; local: [%s]:%hu; %s bytes: %zi; timestamp: %lu.%09lu; seq: %u; delay: %u.%03u ms; delta: %u.%03u ms;",
             *connp,
             addr_str,
             port,
+            local_str,
+            local_port,
             mode_name,
             ssize,
             tsp->tv_sec,
             tsp->tv_nsec,
-            ntohl(msgp->req_sn),
+            msgp->req_sn,
             (delay/1000),
             (delay%1000),
-            (ntohl(msgp->reply_time) - ntohl(msgp->recv_time))/1000,
-            (ntohl(msgp->reply_time) - ntohl(msgp->recv_time))%1000
+            (unsigned)(delta/1000),
+            (unsigned)(delta%1000)
          );
       } else
       {
          syslog(LOG_INFO,
-            "conn %zu: client: [%s]:%hu; %s bytes: %zi; timestamp: %lu.%09lu; seq: %u;",
+            "conn %zu: client: [%s]:%hu; local: [%s]:%hu; %s bytes: %zi; timestamp: %lu.%09lu; seq: %u;",
             *connp,
             addr_str,
             port,
+            local_str,
+            local_port,
             mode_name,
             ssize,
             tsp->tv_sec,
             tsp->tv_nsec,
-            ntohl(msgp->req_sn)
+            msgp->req_sn
          );
       };
    } else
    {
       syslog(LOG_INFO,
-         "conn %zu: client: [%s]:%hu; %s bytes: %zi; timestamp: %lu.%09lu;",
+         "conn %zu: client: [%s]:%hu; local: [%s]:%hu; %s bytes: %zi; timestamp: %lu.%09lu;",
          *connp,
          addr_str,
          port,
+         local_str,
+         local_port,
          mode_name,
          ssize,
          tsp->tv_sec,
@@ -888,25 +2262,55 @@ my_loop(
 {
    socklen_t                  sinlen;
    ssize_t                    ssize;
+   ssize_t                    rsize;
    useconds_t                 delay;
+   unsigned                   ifindex;
+   int                        ttl;
+   int                        tos;
    struct timespec            ts;
+   struct timespec            ts_recv;
+   struct timespec            ts_proc;
+   uint64_t                   proc;
+   int                        rc;
+   time_t                     now;
+   static time_t              sweep_time = 0;
    uint64_t                   us_recv;
    uint64_t                   us_reply;
-   struct pollfd              fds[2];
+   struct pollfd              fds[2+MY_CTL_MAX];
    union my_sa                sa;
+   union my_sa                local;
+   struct my_local          * lap;
+   struct my_flow           * flowp;
+   akudp_echoplus_t           msg;
    union
    {
       char                    bytes[MY_BUFF_SIZE];
-      struct udp_echo_plus    msg;
+      uint32_t                align;
    } udpbuff;
 
    // setup poller
    fds[0].fd      = s;
    fds[0].events  = POLLIN;
    fds[0].revents = 0;
+   my_control_fds(&fds[1]);
    if (cnf_verbose > 1)
       syslog(LOG_DEBUG, "waiting for echo request");
-   if ((poll(fds, 1, 5000)) < 1)
+   rc = poll(fds, 2+MY_CTL_MAX, ( ((cnf_aggregate)) || ((cnf_control)) ) ? 1000 : 5000);
+
+   // export flow records once per second
+   if ((cnf_aggregate))
+   {
+      now = time(NULL);
+      if (now != sweep_time)
+         my_flow_sweep((sweep_time = now), 0);
+   };
+   // service control socket between packets, on timeouts only idle peers
+   // are reaped
+   if ( (rc >= 0) && (ctl_sock != -1) )
+      my_control_poll(&fds[1]);
+   if (rc < 1)
+      return(0);
+   if (!(fds[0].revents & POLLIN))
       return(0);
 
    // increment connection counter
@@ -914,20 +2318,42 @@ my_loop(
    (*connp)++;
 
    // read data
-   sinlen = sizeof(struct sockaddr_storage);
-   if ((ssize = recvfrom(s, udpbuff.bytes, sizeof(udpbuff), 0, &sa.sa, &sinlen)) == -1)
+   if ((ssize = my_recvmsg(s, udpbuff.bytes, sizeof(udpbuff), &sa, &sinlen, &local, &ifindex, &ttl, &tos)) == -1)
       return(-1);
+   clock_gettime(CLOCK_MONOTONIC, &ts_proc);
+   lap = my_local_lookup(&local);
+   lap->recv++;
+   if (tos != -1)
+   {
+      tos_dscp[(tos >> 2) & 0x3f]++;
+      tos_ecn[tos & 0x03]++;
+   };
+   if (!(cnf_reflect_tos))
+      tos = -1;
 
    // grab timestamp
    clock_gettime(CLOCK_REALTIME, &ts);
+   ts_recv  = ts;
+   flowp    = ( ((cnf_control)) || ((cnf_aggregate)) ) ? my_flow_lookup(&sa, ts.tv_sec) : NULL;
+   if ((flowp))
+      my_flow_update(flowp, ts.tv_sec, (size_t)ssize);
    us_recv  = (uint64_t)(ts.tv_sec * 1000000);
    us_recv += (uint64_t)ts.tv_nsec / 1000;
 
    // log connection
-   my_log_conn(MY_RECV, connp, &sa, &udpbuff.msg, ssize, &ts, 0);
-   if ( ((cnf_echoplus)) && (ssize < (ssize_t)sizeof(struct udp_echo_plus)) )
+   memset(&msg, 0, sizeof(msg));
+   akudp_echoplus_decode(&msg, udpbuff.bytes, (size_t)ssize);
+   my_log_conn(MY_RECV, connp, &sa, &local, &msg, ssize, &ts, 0, 0);
+   if ( ( ((cnf_echoplus)) && (ssize < AKUDP_ECHOPLUS_SIZE) ) ||
+        ( ((cnf_stamp))    && (ssize < MY_STAMP_SIZE) ) )
    {
-      my_log_conn(MY_INVAL, connp, &sa, &udpbuff.msg, ssize, &ts, 0);
+      lap->inval++;
+      if ((flowp))
+      {
+         my_flow_record(&flowp->total,    MY_INVAL, 0);
+         my_flow_record(&flowp->interval, MY_INVAL, 0);
+      };
+      my_log_conn(MY_INVAL, connp, &sa, &local, &msg, ssize, &ts, 0, 0);
       return(0);
    };
 
@@ -937,7 +2363,13 @@ my_loop(
       if ( (rand() % 100) < cnf_drop_perct)
       {
          state.failures++;
-         my_log_conn(MY_DROP, connp, &sa, &udpbuff.msg, ssize, &ts, 0);
+         lap->drop++;
+         if ((flowp))
+         {
+            my_flow_record(&flowp->total,    MY_DROP, 0);
+            my_flow_record(&flowp->interval, MY_DROP, 0);
+         };
+         my_log_conn(MY_DROP, connp, &sa, &local, &msg, ssize, &ts, 0, 0);
          return(0);
       };
    };
@@ -959,28 +2391,484 @@ my_loop(
 
    // send response
    if ((cnf_echoplus))
+      akudp_echoplus_reflect(udpbuff.bytes, (size_t)ssize, state.res_sn, &ts_recv, &ts, state.failures);
+   if ((cnf_stamp))
+      akudp_stamp_reflect(udpbuff.bytes, (size_t)ssize, &ts_recv, &ts, my_stamp_errest(ts.tv_sec), ttl);
+   if ( ((cnf_transparent)) && (ntohs(local.sin6.sin6_port) != cnf_port) )
+      rsize = my_tproxy_sendto(udpbuff.bytes, (size_t)ssize, &sa, sinlen, &local, tos);
+   else
+      rsize = my_sendmsg(s, udpbuff.bytes, (size_t)ssize, &sa, sinlen, &local, ifindex, tos);
+   if (rsize != -1)
+      lap->sent++;
+
+   // record processing time
+   proc = my_timespec_elapsed(&ts_proc);
+   if ((flowp))
    {
-      udpbuff.msg.res_sn    = htonl(state.res_sn);
-      udpbuff.msg.recv_time = htonl(us_recv & 0xFFFFFFFFLL);
-      udpbuff.msg.reply_time = htonl(us_reply & 0xFFFFFFFFLL);
-      udpbuff.msg.failures  = htonl(state.failures);
+      my_flow_record(&flowp->total,    MY_SENT, proc);
+      my_flow_record(&flowp->interval, MY_SENT, proc);
    };
-   sendto(s, udpbuff.bytes, (size_t)ssize, 0, &sa.sa, sinlen);
 
    // log response
-   my_log_conn(MY_SENT, connp, &sa, &udpbuff.msg, ssize, &ts, delay);
+   my_log_conn(MY_SENT, connp, &sa, &local, &msg, ssize, &ts, delay, (us_reply - us_recv));
+
+   return(0);
+}
+
+
+// receive datagram and destination address
+ssize_t
+my_recvmsg(
+         int                           s,
+         void *                        buff,
+         size_t                        len,
+         union my_sa *                 sap,
+         socklen_t *                   sinlenp,
+         union my_sa *                 localp,
+         unsigned *                    ifindexp,
+         int *                         ttlp,
+         int *                         tosp )
+{
+   ssize_t                    ssize;
+   int                        origdst;
+   struct iovec               iov;
+   struct msghdr              msg;
+   struct cmsghdr           * cmsg;
+   union
+   {
+      char                    bytes[MY_CMSG_SIZE];
+      struct cmsghdr          align;
+   } cbuff;
+
+   iov.iov_base         = buff;
+   iov.iov_len          = len;
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_name         = &sap->sa;
+   msg.msg_namelen      = sizeof(struct sockaddr_storage);
+   msg.msg_iov          = &iov;
+   msg.msg_iovlen       = 1;
+   msg.msg_control      = cbuff.bytes;
+   msg.msg_controllen   = sizeof(cbuff);
+
+   if ((ssize = recvmsg(s, &msg, 0)) == -1)
+      return(-1);
+   *sinlenp = msg.msg_namelen;
+
+   // extract destination address of packet
+   memset(localp, 0, sizeof(union my_sa));
+   *ifindexp = 0;
+   *ttlp     = akudp_cmsg_ttl(&msg);
+   *tosp     = akudp_cmsg_tos(&msg);
+   origdst   = 0;
+   for(cmsg = CMSG_FIRSTHDR(&msg); (cmsg != NULL); cmsg = CMSG_NXTHDR(&msg, cmsg))
+   {
+#if defined(IP_PKTINFO)
+      if ( (cmsg->cmsg_level == IPPROTO_IP) && (cmsg->cmsg_type == IP_PKTINFO) )
+      {
+         struct in_pktinfo pi;
+         memcpy(&pi, CMSG_DATA(cmsg), sizeof(pi));
+         *ifindexp                    = (unsigned)pi.ipi_ifindex;
+         if ((origdst))
+            continue;
+         localp->sin.sin_family       = AF_INET;
+         localp->sin.sin_addr         = pi.ipi_addr;
+         localp->sin.sin_port         = htons(cnf_port);
+      };
+#endif
+#if defined(IPV6_RECVPKTINFO)
+      if ( (cmsg->cmsg_level == IPPROTO_IPV6) && (cmsg->cmsg_type == IPV6_PKTINFO) )
+      {
+         struct in6_pktinfo pi6;
+         memcpy(&pi6, CMSG_DATA(cmsg), sizeof(pi6));
+         *ifindexp                    = pi6.ipi6_ifindex;
+         if ((origdst))
+            continue;
+         localp->sin6.sin6_family     = AF_INET6;
+         localp->sin6.sin6_addr       = pi6.ipi6_addr;
+         localp->sin6.sin6_port       = htons(cnf_port);
+      };
+#endif
+#if defined(IP_RECVORIGDSTADDR)
+      // original destination (address and port) of redirected packet
+      if ( (cmsg->cmsg_level == IPPROTO_IP) && (cmsg->cmsg_type == IP_ORIGDSTADDR) )
+      {
+         memcpy(&localp->sin, CMSG_DATA(cmsg), sizeof(struct sockaddr_in));
+         origdst = 1;
+      };
+#endif
+#if defined(IPV6_RECVORIGDSTADDR)
+      if ( (cmsg->cmsg_level == IPPROTO_IPV6) && (cmsg->cmsg_type == IPV6_ORIGDSTADDR) )
+      {
+         memcpy(&localp->sin6, CMSG_DATA(cmsg), sizeof(struct sockaddr_in6));
+         origdst = 1;
+      };
+#endif
+   };
+
+   // IPv4 destinations on IPv6 sockets are handled as mapped addresses
+   if ( (listen_family == AF_INET6) && (localp->ss.ss_family == AF_INET) )
+   {
+      struct sockaddr_in sin;
+      memcpy(&sin, &localp->sin, sizeof(sin));
+      memset(localp, 0, sizeof(union my_sa));
+      localp->sin6.sin6_family            = AF_INET6;
+      localp->sin6.sin6_port              = sin.sin_port;
+      localp->sin6.sin6_addr.s6_addr[10]  = 0xff;
+      localp->sin6.sin6_addr.s6_addr[11]  = 0xff;
+      memcpy(&localp->sin6.sin6_addr.s6_addr[12], &sin.sin_addr, 4);
+   };
+
+   return(ssize);
+}
+
+
+// convert socket address to presentation format
+int
+my_sa_ntop(
+         union my_sa *                 sap,
+         char *                        dst,
+         size_t                        size,
+         unsigned short *              portp )
+{
+   unsigned short             port;
+
+   switch(sap->ss.ss_family)
+   {
+      case AF_INET:
+      inet_ntop(AF_INET, &sap->sin.sin_addr, dst, (socklen_t)size);
+      port = ntohs(sap->sin.sin_port);
+      break;
+
+      case AF_INET6:
+      inet_ntop(AF_INET6, &sap->sin6.sin6_addr, dst, (socklen_t)size);
+      port = ntohs(sap->sin6.sin6_port);
+      break;
+
+      default:
+      return(-1);
+   };
+
+   if ((portp))
+      *portp = port;
 
    return(0);
 }
 
 
+// determine STAMP error estimate of local clock
+uint16_t
+my_stamp_errest(
+         time_t                        now )
+{
+   static time_t              updated = 0;
+   static uint16_t            errest  = 0;
+
+   // refresh estimate once per minute
+   if ( ((errest)) && ((now - updated) < AKUDP_STAMP_ERREST_REFRESH) )
+      return(errest);
+   updated = now;
+   errest  = akudp_stamp_errest();
+
+   return(errest);
+}
+
+
+// nanoseconds elapsed since monotonic timestamp
+uint64_t
+my_timespec_elapsed(
+         struct timespec *             tsp )
+{
+   struct timespec            now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return( (((uint64_t)now.tv_sec - (uint64_t)tsp->tv_sec) * 1000000000ULL) +
+           (uint64_t)now.tv_nsec - (uint64_t)tsp->tv_nsec );
+}
+
+
+// close cached transparent reply sockets
+void
+my_tproxy_close(
+         void )
+{
+   size_t                     idx;
+
+   for(idx = 0; (idx < tproxy_used); idx++)
+      close(tproxy_socks[idx].s);
+   memset(tproxy_socks, 0, sizeof(tproxy_socks));
+   memset(tproxy_hash,  0, sizeof(tproxy_hash));
+   tproxy_used   = 0;
+   tproxy_newest = 0;
+   tproxy_oldest = 0;
+
+   return;
+}
+
+
+// send datagram from foreign address and port
+ssize_t
+my_tproxy_sendto(
+         const void *                  buff,
+         size_t                        len,
+         union my_sa *                 sap,
+         socklen_t                     sinlen,
+         union my_sa *                 localp,
+         int                           tos )
+{
+#if defined(IP_TRANSPARENT)
+   int                        s;
+   int                        opt;
+   size_t                     pos;
+   uint32_t                   hash;
+   uint32_t                   idx;
+   uint32_t                 * linkp;
+   socklen_t                  socklen;
+   const uint8_t            * bytes;
+   struct my_tproxy         * tpp;
+   union my_sa                key;
+
+   // hash family, port, and address (FNV-1a) of a copy without flow label
+   socklen = (localp->ss.ss_family == AF_INET6) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+   memset(&key, 0, sizeof(key));
+   memcpy(&key, localp, socklen);
+   if (key.ss.ss_family == AF_INET6)
+      key.sin6.sin6_flowinfo = 0;
+   bytes   = (const uint8_t *)&key.ss;
+   hash    = 2166136261U;
+   for(pos = 0; (pos < socklen); pos++)
+      hash = (hash ^ bytes[pos]) * 16777619U;
+
+   // reuse cached socket
+   for(idx = tproxy_hash[hash & (MY_TPROXY_HASH-1)]; ((idx)); idx = tpp->next)
+   {
+      tpp = &tproxy_socks[idx-1];
+      if ( (tpp->hash == hash) && (!(memcmp(&tpp->addr, &key, socklen))) )
+         break;
+   };
+   if ((idx))
+   {
+      my_tproxy_unlink(idx);
+      s = tpp->s;
+   } else
+   {
+      // open socket bound to original destination
+      if ((s = socket(key.ss.ss_family, SOCK_DGRAM, 0)) == -1)
+      {
+         syslog(LOG_ERR, "socket(): %s", strerror(errno));
+         return(-1);
+      };
+      opt = 1;
+      setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (void *)&opt, sizeof(int));
+      if (setsockopt(s, IPPROTO_IP, IP_TRANSPARENT, (void *)&opt, sizeof(int)) == -1)
+      {
+         syslog(LOG_ERR, "setsockopt(IP_TRANSPARENT): %s", strerror(errno));
+         close(s);
+         return(-1);
+      };
+      if (bind(s, &key.sa, socklen) == -1)
+      {
+         syslog(LOG_ERR, "bind(): %s", strerror(errno));
+         close(s);
+         return(-1);
+      };
+
+      // allocate unused slot or recycle least recently used socket
+      if (tproxy_used < MY_TPROXY_MAX)
+      {
+         idx = (uint32_t)++tproxy_used;
+      } else
+      {
+         idx = tproxy_oldest;
+         tpp = &tproxy_socks[idx-1];
+         close(tpp->s);
+         for(linkp = &tproxy_hash[tpp->hash & (MY_TPROXY_HASH-1)]; (*linkp != idx); linkp = &tproxy_socks[*linkp-1].next);
+         *linkp = tpp->next;
+         my_tproxy_unlink(idx);
+      };
+
+      // cache socket
+      tpp = &tproxy_socks[idx-1];
+      memset(tpp, 0, sizeof(struct my_tproxy));
+      memcpy(&tpp->addr, &key, sizeof(union my_sa));
+      tpp->s    = s;
+      tpp->hash = hash;
+      tpp->next = tproxy_hash[hash & (MY_TPROXY_HASH-1)];
+      tproxy_hash[hash & (MY_TPROXY_HASH-1)] = idx;
+   };
+
+   // move socket to front of recency list
+   tpp->newer = 0;
+   tpp->older = tproxy_newest;
+   if ((tproxy_newest))
+      tproxy_socks[tproxy_newest-1].newer = idx;
+   tproxy_newest = idx;
+   if (!(tproxy_oldest))
+      tproxy_oldest = idx;
+
+   my_tproxy_tos(s, sap, tos);
+
+   return(sendto(s, buff, len, 0, &sap->sa, sinlen));
+#else
+   (void)buff;
+   (void)len;
+   (void)sap;
+   (void)sinlen;
+   (void)localp;
+   (void)tos;
+   errno = ENOTSUP;
+   return(-1);
+#endif
+}
+
+
+// remove transparent reply socket from recency list
+void
+my_tproxy_unlink(
+         uint32_t                      idx )
+{
+   struct my_tproxy         * tpp;
+
+   tpp = &tproxy_socks[idx-1];
+   if ((tpp->newer))
+      tproxy_socks[tpp->newer-1].older = tpp->older;
+   else
+      tproxy_newest = tpp->older;
+   if ((tpp->older))
+      tproxy_socks[tpp->older-1].newer = tpp->newer;
+   else
+      tproxy_oldest = tpp->newer;
+   tpp->newer = 0;
+   tpp->older = 0;
+
+   return;
+}
+
+
+// set traffic class of transparent reply socket
+void
+my_tproxy_tos(
+         int                           s,
+         union my_sa *                 sap,
+         int                           tos )
+{
+   if (tos == -1)
+      return;
+   if ( (sap->ss.ss_family == AF_INET) || (IN6_IS_ADDR_V4MAPPED(&sap->sin6.sin6_addr)) )
+      setsockopt(s, IPPROTO_IP, IP_TOS, (void *)&tos, sizeof(int));
+   else
+      setsockopt(s, IPPROTO_IPV6, IPV6_TCLASS, (void *)&tos, sizeof(int));
+   return;
+}
+
+
+// send datagram from specified source address
+ssize_t
+my_sendmsg(
+         int                           s,
+         const void *                  buff,
+         size_t                        len,
+         union my_sa *                 sap,
+         socklen_t                     sinlen,
+         union my_sa *                 localp,
+         unsigned                      ifindex,
+         int                           tos )
+{
+   struct iovec               iov;
+   struct msghdr              msg;
+   struct cmsghdr           * cmsg;
+   union
+   {
+      char                    bytes[MY_CMSG_SIZE];
+      struct cmsghdr          align;
+   } cbuff;
+
+   iov.iov_base         = (void *)(uintptr_t)buff;
+   iov.iov_len          = len;
+   memset(&msg,   0, sizeof(msg));
+   memset(&cbuff, 0, sizeof(cbuff));
+   msg.msg_name         = &sap->sa;
+   msg.msg_namelen      = sinlen;
+   msg.msg_iov          = &iov;
+   msg.msg_iovlen       = 1;
+   msg.msg_control      = cbuff.bytes;
+   msg.msg_controllen   = sizeof(cbuff);
+   cmsg                 = CMSG_FIRSTHDR(&msg);
+
+   // reply from the address the request was sent to
+   switch(localp->ss.ss_family)
+   {
+#if defined(IP_PKTINFO)
+      case AF_INET:
+      {
+         struct in_pktinfo pi;
+         memset(&pi, 0, sizeof(pi));
+         pi.ipi_spec_dst         = localp->sin.sin_addr;
+         cmsg->cmsg_level        = IPPROTO_IP;
+         cmsg->cmsg_type         = IP_PKTINFO;
+         cmsg->cmsg_len          = CMSG_LEN(sizeof(pi));
+         memcpy(CMSG_DATA(cmsg), &pi, sizeof(pi));
+         msg.msg_controllen      = CMSG_SPACE(sizeof(pi));
+         break;
+      };
+#endif
+
+#if defined(IPV6_RECVPKTINFO)
+      case AF_INET6:
+      {
+         struct in6_pktinfo pi6;
+         memset(&pi6, 0, sizeof(pi6));
+         pi6.ipi6_addr           = localp->sin6.sin6_addr;
+         // interface is only pinned for link-local scope
+         if (IN6_IS_ADDR_LINKLOCAL(&pi6.ipi6_addr))
+            pi6.ipi6_ifindex     = ifindex;
+         cmsg->cmsg_level        = IPPROTO_IPV6;
+         cmsg->cmsg_type         = IPV6_PKTINFO;
+         cmsg->cmsg_len          = CMSG_LEN(sizeof(pi6));
+         memcpy(CMSG_DATA(cmsg), &pi6, sizeof(pi6));
+         msg.msg_controllen      = CMSG_SPACE(sizeof(pi6));
+         break;
+      };
+#endif
+
+      default:
+      msg.msg_controllen   = 0;
+      break;
+   };
+
+   // reply with traffic class of request
+   if (tos != -1)
+   {
+      cmsg = (struct cmsghdr *)(void *)&cbuff.bytes[msg.msg_controllen];
+      if ( (sap->ss.ss_family == AF_INET) || (IN6_IS_ADDR_V4MAPPED(&sap->sin6.sin6_addr)) )
+      {
+         cmsg->cmsg_level  = IPPROTO_IP;
+         cmsg->cmsg_type   = IP_TOS;
+      } else {
+         cmsg->cmsg_level  = IPPROTO_IPV6;
+         cmsg->cmsg_type   = IPV6_TCLASS;
+      };
+      cmsg->cmsg_len       = CMSG_LEN(sizeof(int));
+      memcpy(CMSG_DATA(cmsg), &tos, sizeof(int));
+      msg.msg_controllen  += CMSG_SPACE(sizeof(int));
+   };
+   if (!(msg.msg_controllen))
+      msg.msg_control      = NULL;
+
+   return(sendmsg(s, &msg, 0));
+}
+
+
 // signal handler
 void
 my_sighandler(
          int                           signum )
 {
    signal(signum, my_sighandler);
-   should_stop = 1;
+   if (signum == SIGUSR1)
+      should_report = 1;
+   else
+      should_stop = 1;
    return;
 }
 
@@ -992,6 +2880,9 @@ my_usage(
 {
    printf("Usage: %s [options]\n", prog_name);
    printf("OPTIONS:\n");
+   printf("  -A sec,  --aggregate=sec  log flow records instead of packets (default: off)\n");
+   printf("  -c,      --capacity       IP capacity test receiver (RFC 9097 style)\n");
+   printf("  -C path, --control=path   runtime control socket (default: none)\n");
    printf("  -d num,  --drop=num       set packet drop probability [0-99] (default: %u%%)\n", cnf_drop_perct);
    printf("  -D usec, --delay=usec     set echo delay range to microseconds (default: %u us)\n", cnf_delay);
    printf("  -e,      --echoplus       enable echo plus, not RFC compliant%s\n", ((cnf_echoplus)) ? " (default)" : "");
@@ -1002,7 +2893,10 @@ my_usage(
    printf("  -n,      --foreground     do not fork\n");
    printf("  -p port, --port=port      list on port number (default: %u)\n", cnf_port);
    printf("  -P file, --pidfile=file   PID file (default: %s)\n", cnf_pidfile);
-   printf("  -r,      --rfc            RFC compliant echo protocol%s\n", (!(cnf_echoplus)) ? " (default)" : "");
+   printf("  -Q,      --reflect-tos    reply with DSCP and ECN bits of request\n");
+   printf("  -r,      --rfc            RFC compliant echo protocol%s\n", ( (!(cnf_echoplus)) && (!(cnf_stamp)) ) ? " (default)" : "");
+   printf("  -S,      --stamp          STAMP (RFC 8762) / TWAMP-Light session-reflector\n");
+   printf("  -T,      --transparent    answer for any redirected destination (IP_TRANSPARENT)\n");
    printf("  -u uid,  --user=uid       setuid to uid (default: none)\n");
    printf("  -v,      --verbose        enable verbose output\n");
    printf("  -V,      --version        print version number and exit\n");